@@ -532,10 +532,13 @@ RC CLI::run(Iterator *it) {
     for (uint i = 0; i < attrs.size(); i++)
         outputBuffer.push_back(attrs.at(i).name);
 
-    while (it->getNextTuple(data) != QE_EOF) {
+    RC rc;
+    while ((rc = it->getNextTuple(data)) == 0) {
         if (updateOutputBuffer(outputBuffer, data, attrs) != 0)
             return error(__LINE__);
     }
+    if (rc != QE_EOF)
+        return error(__LINE__);
 
     if (printOutputBuffer(outputBuffer, attrs.size()) != 0)
         return error(__LINE__);
@@ -959,7 +962,7 @@ RC CLI::addAttribute() {
         return -1;
 
     int biggestPosition = 0, position = 0;
-    while (rmsi.getNextTuple(rid, data_returned) != RM_EOF) {
+    while (rmsi.getNextTuple(rid, data_returned) == 0) {
         // adding +1 because of nulls-indicator
         memcpy(&position, (char *) data_returned + 1, sizeof(int));
         if (biggestPosition < (int) position)
@@ -1012,7 +1015,7 @@ RC CLI::dropTable() {
         return -1;
 
     // delete tableName from CLI_TABLES
-    while (rmsi.getNextTuple(rid, data_returned) != RM_EOF) {
+    while (rmsi.getNextTuple(rid, data_returned) == 0) {
         if (rm.deleteTuple(CLI_TABLES, rid) != 0)
             return -1;
     }
@@ -1746,7 +1749,7 @@ bool CLI::checkAttribute(const string tableName, const string columnName, RID &r
         return -1;
 
     // check if tableName is what we want
-    while (rmsi.getNextTuple(rid, data_returned) != RM_EOF) {
+    while (rmsi.getNextTuple(rid, data_returned) == 0) {
         int length = 0, offset = 0;
 
         // adding +1 because of nulls-indicator
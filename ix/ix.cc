@@ -16,8 +16,8 @@ RC IndexManager::destroyFile(const std::string &fileName) {
     return pfm->destroyFile(fileName);
 }
 
-RC IndexManager::openFile(const std::string &fileName, IXFileHandle &ixFileHandle) {
-    return pfm->openFile(fileName, ixFileHandle.fileHandle);
+RC IndexManager::openFile(const std::string &fileName, IXFileHandle &ixFileHandle, FileMode fileMode) {
+    return pfm->openFile(fileName, ixFileHandle.fileHandle, fileMode);
 }
 
 RC IndexManager::closeFile(IXFileHandle &ixFileHandle) {
@@ -27,58 +27,300 @@ RC IndexManager::closeFile(IXFileHandle &ixFileHandle) {
 RC IndexManager::insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid) {
     AttrValue attrValue;
     attrValue.readAttr(attribute.type, key);
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
     if (ixFileHandle.fileHandle.getNumberOfPages() == 0) {
-        Node root = Node(attribute.type);
-        root.nodeType = SingleRoot;
-        root.keys.emplace_back(attrValue);
-        vector<RID> rids;
-        rids.emplace_back(rid);
-        root.pointers.emplace_back(rids);
-        root.pageNum = 0;
-        root.serialize(page);
-        ixFileHandle.fileHandle.appendPage(page);
+        // Page 0 is latched before it exists, in case another thread is creating the root as well
+        ixFileHandle.latchPage(0, true);
+        if (ixFileHandle.fileHandle.getNumberOfPages() == 0) {
+            void *page = malloc(PAGE_SIZE);
+            memset(page, 0, PAGE_SIZE);
+            Node root = Node(attribute.type);
+            root.nodeType = SingleRoot;
+            root.keys.emplace_back(attrValue);
+            vector<RID> rids;
+            rids.emplace_back(rid);
+            root.pointers.emplace_back(rids);
+            root.pageNum = 0;
+            root.serialize(page);
+            ixFileHandle.fileHandle.appendPage(page);
+            free(page);
+            ixFileHandle.unlatchAll();
+            return 0;
+        }
+        ixFileHandle.unlatchAll();
+    }
+
+    // Most inserts only change the leaf, which is all that is latched exclusively on the way down
+    vector<int> path;
+    this->locateLeaf(ixFileHandle, attribute.type, attrValue, path, true);
+    void *leafPage;
+    ixFileHandle.fileHandle.pinPage(path.back(), leafPage);
+    Node *leaf = new Node(ixFileHandle, attribute.type, leafPage);
+    ixFileHandle.fileHandle.unpinPage(path.back(), false);
+    leaf->pageNum = path.back();
+    int pos = leaf->locateChildPos(attrValue, LT_OP);
+    leaf->insertKey(pos, attrValue);
+    leaf->insertPointer(pos, attrValue, rid);
+    if (leaf->keys.empty() || leaf->getNodeSize() <= PAGE_SIZE) {
+        leaf->writeNode(ixFileHandle);
+        delete leaf;
+        ixFileHandle.unlatchAll();
+        return 0;
+    }
+    delete leaf;
+    ixFileHandle.unlatchAll();
+
+    // The leaf splits: start over, keeping the nodes the split can reach latched exclusively
+    vector<Node *> route;
+    this->routeToLeaf(ixFileHandle, attribute, attrValue, route, true);
+    leaf = route.back();
+    pos = leaf->locateChildPos(attrValue, LT_OP);
+    leaf->insertKey(pos, attrValue);
+    leaf->insertPointer(pos, attrValue, rid);
+    if (!leaf->keys.empty() && leaf->getNodeSize() > PAGE_SIZE) {
+        split(ixFileHandle, route);
     } else {
-        ixFileHandle.fileHandle.readPage(0, page);
-        Node root = Node(ixFileHandle, attribute.type, page);
-        vector<Node *> route;
-        if (root.nodeType == SingleRoot) {
-            int pos = root.locateChildPos(attrValue, LT_OP);
-            root.insertKey(pos, attrValue);
-            root.insertPointer(pos, attrValue, rid);
-            route.emplace_back(&root);
-
-            if (!root.keys.empty() && root.getNodeSize() > PAGE_SIZE) {
-                split(ixFileHandle, route);
+        leaf->writeNode(ixFileHandle);
+    }
+    for (int i = 0; i < route.size(); i++) {
+        delete route[i];
+    }
+    ixFileHandle.unlatchAll();
+    return 0;
+}
+
+RC IndexManager::insertEntries(IXFileHandle &ixFileHandle, const Attribute &attribute,
+                                const vector<IndexEntry> &entries) {
+    void *key = malloc(PAGE_SIZE);
+    RC rc = 0;
+    int i = 0;
+    while (i < entries.size() && rc == 0) {
+        if (ixFileHandle.fileHandle.getNumberOfPages() == 0) {
+            // insertEntry creates the root
+            AttrValue attrValue = entries[i].key;
+            attrValue.writeAttr(key);
+            rc = this->insertEntry(ixFileHandle, attribute, key, entries[i].rid);
+            i++;
+            continue;
+        }
+        vector<int> path;
+        AttrValue upperFence;
+        rc = this->locateLeaf(ixFileHandle, attribute.type, entries[i].key, path, true, &upperFence);
+        if (rc != 0) {
+            break;
+        }
+        void *leafPage;
+        ixFileHandle.fileHandle.pinPage(path.back(), leafPage);
+        Node *leaf = new Node(ixFileHandle, attribute.type, leafPage);
+        ixFileHandle.fileHandle.unpinPage(path.back(), false);
+        leaf->pageNum = path.back();
+        // The entries go in while they belong to this leaf and it has room for them
+        int j = i;
+        while (j < entries.size() && (j == i || upperFence.length == 0 || entries[j].key < upperFence) &&
+               leaf->fitsEntry(attribute, entries[j].key)) {
+            int pos = leaf->locateChildPos(entries[j].key, LT_OP);
+            leaf->insertKey(pos, entries[j].key);
+            leaf->insertPointer(pos, entries[j].key, entries[j].rid);
+            j++;
+        }
+        if (j > i) {
+            leaf->writeNode(ixFileHandle);
+        }
+        delete leaf;
+        ixFileHandle.unlatchAll();
+        if (j == i) {
+            // The leaf is full, insertEntry splits it
+            AttrValue attrValue = entries[i].key;
+            attrValue.writeAttr(key);
+            rc = this->insertEntry(ixFileHandle, attribute, key, entries[i].rid);
+            j++;
+        }
+        i = j;
+    }
+    free(key);
+    return rc;
+}
+
+RC IndexManager::bulkLoad(IXFileHandle &ixFileHandle, const Attribute &attribute, const vector<IndexEntry> &entries,
+                          float fillFactor) {
+    if (ixFileHandle.fileHandle.getNumberOfPages() != 0) {
+        return -13; // BulkLoadException: the index is not empty
+    }
+    if (entries.empty()) {
+        return 0;
+    }
+    if (fillFactor <= 0 || fillFactor > 1) {
+        fillFactor = IX_FILL_FACTOR;
+    }
+    int capacity = (int) (PAGE_SIZE * fillFactor);
+
+    // Pack the leaves, the rids of equal keys share one key. leafSize counts the keys in full,
+    // a VarChar leaf saves the prefix they share on all of them but one.
+    bool compress = attribute.type == TypeVarChar && this->keyCompression;
+    vector<Node *> level;
+    Node *leaf = new Node(attribute.type);
+    leaf->nodeType = Leaf;
+    int leafSize = leaf->getNodeSize();
+    int prefixLength = 0;
+    for (int i = 0; i < entries.size(); i++) {
+        const AttrValue &key = entries[i].key;
+        int saved = compress ? ((int) leaf->keys.size() - 1) * prefixLength : 0;
+        if (!leaf->keys.empty() && key == leaf->keys.back()) {
+            if (leafSize - saved + (int) sizeof(RID) > capacity && leaf->keys.size() > 1) {
+                // Only a leaf with a single key can spill into overflow pages, so a long run moves out
+                Node *runLeaf = new Node(attribute.type);
+                runLeaf->nodeType = Leaf;
+                runLeaf->keys.emplace_back(leaf->keys.back());
+                runLeaf->pointers.emplace_back(leaf->pointers.back());
+                leaf->keys.pop_back();
+                leaf->pointers.pop_back();
+                level.emplace_back(leaf);
+                leaf = runLeaf;
+                leafSize = leaf->getNodeSize();
+                prefixLength = leaf->keys[0].vchar.size();
+            }
+            leaf->pointers.back().emplace_back(entries[i].rid);
+            leafSize += sizeof(RID);
+            continue;
+        }
+        if (!leaf->keys.empty() && key < leaf->keys.back()) {
+            for (Node *node : level) {
+                delete node;
+            }
+            delete leaf;
+            return -13; // BulkLoadException: the entries are not sorted
+        }
+        int added = key.length + sizeof(int) + sizeof(RID);
+        int prefix = leaf->keys.empty() ? key.vchar.size()
+                                        : getCommonPrefix(leaf->keys[0].vchar, key.vchar, prefixLength);
+        saved = compress ? (int) leaf->keys.size() * prefix : 0;
+        if (!leaf->keys.empty() && leafSize + added - saved > capacity) {
+            level.emplace_back(leaf);
+            leaf = new Node(attribute.type);
+            leaf->nodeType = Leaf;
+            leafSize = leaf->getNodeSize();
+            prefix = key.vchar.size();
+        }
+        prefixLength = prefix;
+        leaf->keys.emplace_back(key);
+        leaf->pointers.emplace_back(vector<RID>(1, entries[i].rid));
+        leafSize += added;
+    }
+    level.emplace_back(leaf);
+
+    // The root is always page 0, it is taken before anything else
+    void *emptyPage = malloc(PAGE_SIZE);
+    memset(emptyPage, 0, PAGE_SIZE);
+    ixFileHandle.fileHandle.appendPage(emptyPage);
+    free(emptyPage);
+    if (level.size() == 1) {
+        leaf->nodeType = SingleRoot;
+        leaf->pageNum = 0;
+        leaf->writeNode(ixFileHandle);
+        delete leaf;
+        return 0;
+    }
+    for (int i = 0; i < level.size(); i++) {
+        level[i]->allocatePage(ixFileHandle);
+    }
+    vector<int> levelPages;
+    vector<AttrValue> lowKeys;
+    for (int i = 0; i < level.size(); i++) {
+        level[i]->previous = i > 0 ? level[i - 1]->pageNum : -1;
+        level[i]->next = i < level.size() - 1 ? level[i + 1]->pageNum : -1;
+        levelPages.emplace_back(level[i]->pageNum);
+        lowKeys.emplace_back(i > 0 ? this->getSeparator(level[i - 1]->keys.back(), level[i]->keys[0])
+                                   : level[i]->keys[0]);
+    }
+    for (int i = 0; i < level.size(); i++) {
+        level[i]->writeNode(ixFileHandle);
+        delete level[i];
+    }
+
+    // Each inner level separates its children by their lowest keys, until a single node is left
+    while (levelPages.size() > 1) {
+        vector<Node *> parents;
+        vector<AttrValue> parentLowKeys;
+        Node *parent = nullptr;
+        int parentSize = 0;
+        for (int i = 0; i < levelPages.size(); i++) {
+            int added = lowKeys[i].length + sizeof(int);
+            if (parent == nullptr || (parent->children.size() >= 2 && parentSize + added > capacity)) {
+                parent = new Node(attribute.type);
+                parent->nodeType = Intermediate;
+                parent->children.emplace_back(levelPages[i]);
+                parentSize = parent->getNodeSize();
+                parents.emplace_back(parent);
+                parentLowKeys.emplace_back(lowKeys[i]);
+                continue;
+            }
+            parent->keys.emplace_back(lowKeys[i]);
+            parent->children.emplace_back(levelPages[i]);
+            parentSize += added;
+        }
+        if (parents.size() > 1 && parent->children.size() == 1) {
+            // The last node needs two children, borrow the last one of its neighbour or join it
+            Node *neighbour = parents[parents.size() - 2];
+            if (neighbour->children.size() > 2) {
+                parent->keys.insert(parent->keys.begin(), parentLowKeys.back());
+                parent->children.insert(parent->children.begin(), neighbour->children.back());
+                parentLowKeys.back() = neighbour->keys.back();
+                neighbour->keys.pop_back();
+                neighbour->children.pop_back();
             } else {
-                root.writeNode(ixFileHandle);
+                neighbour->keys.emplace_back(parentLowKeys.back());
+                neighbour->children.emplace_back(parent->children[0]);
+                parents.pop_back();
+                parentLowKeys.pop_back();
+                delete parent;
+                parent = neighbour;
             }
+        }
+
+        if (parents.size() == 1) {
+            parent->nodeType = Root;
+            parent->pageNum = 0;
         } else {
-            routeToLeaf(ixFileHandle, route, &root, attrValue);
-            Node *leaf = route[route.size() - 1];
-            int pos = leaf->locateChildPos(attrValue, LT_OP);
-            leaf->insertKey(pos, attrValue);
-            leaf->insertPointer(pos, attrValue, rid);
-            if (!leaf->keys.empty() && leaf->getNodeSize() > PAGE_SIZE) {
-                split(ixFileHandle, route);
-            } else {
-                leaf->writeNode(ixFileHandle);
+            for (int i = 0; i < parents.size(); i++) {
+                parents[i]->allocatePage(ixFileHandle);
             }
         }
-        for (int i = 1; i < route.size(); i++) {
-            delete route[i];
+        levelPages.clear();
+        for (int i = 0; i < parents.size(); i++) {
+            parents[i]->writeNode(ixFileHandle);
+            levelPages.emplace_back(parents[i]->pageNum);
+            delete parents[i];
         }
-        route.clear();
+        lowKeys = parentLowKeys;
     }
-    free(page);
     return 0;
 }
 
+void IndexManager::setKeyCompression(bool enabled) {
+    this->keyCompression = enabled;
+}
+
+AttrValue IndexManager::getSeparator(const AttrValue &left, const AttrValue &right) const {
+    if (right.type != TypeVarChar || !this->keyCompression) {
+        return right;
+    }
+    // The shortest prefix of right that is still greater than left
+    int length = getCommonPrefix(left.vchar, right.vchar, right.vchar.size()) + 1;
+    if (length >= right.vchar.size()) {
+        return right;
+    }
+    return AttrValue(right.vchar.substr(0, length));
+}
+
+int getCommonPrefix(const string &left, const string &right, int limit) {
+    int length = 0;
+    while (length < limit && length < left.size() && length < right.size() && left[length] == right[length]) {
+        length++;
+    }
+    return length;
+}
+
 RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
     Node *node = route[route.size() - 1];
-    void *emptyPage = malloc(PAGE_SIZE);
-    memset(emptyPage, 0, PAGE_SIZE);
     if (node->nodeType == Leaf) {
         Node newLeaf = Node(node->attrType);
         newLeaf.nodeType = Leaf;
@@ -92,8 +334,7 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         node->keys.erase(node->keys.begin() + mid, node->keys.begin() + node->keys.size());
         node->pointers.erase(node->pointers.begin() + mid, node->pointers.begin() + node->pointers.size());
 
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newLeaf.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
+        newLeaf.allocatePage(ixFileHandle);
         newLeaf.next = node->next;
         node->next = newLeaf.pageNum;
         newLeaf.previous = node->pageNum;
@@ -101,8 +342,9 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         newLeaf.writeNode(ixFileHandle);
 
         Node *parent = route[route.size() - 2];
-        int pos = parent->locateChildPos(newLeaf.keys[0], LT_OP);
-        parent->insertKey(pos, newLeaf.keys[0]);
+        AttrValue separator = this->getSeparator(node->keys.back(), newLeaf.keys[0]);
+        int pos = parent->locateChildPos(separator, LT_OP);
+        parent->insertKey(pos, separator);
         parent->insertChild(pos + 1, newLeaf.pageNum);
         // Delete the top element
         delete route[route.size() - 1];
@@ -124,8 +366,7 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         }
         newInter.children.emplace_back(node->children[node->keys.size()]);
 
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newInter.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
+        newInter.allocatePage(ixFileHandle);
         Node *parent = route[route.size() - 2];
         int pos = parent->locateChildPos(node->keys[mid], LT_OP);
         parent->insertKey(pos, node->keys[mid]);
@@ -163,12 +404,11 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         }
         node->keys.erase(node->keys.begin() + mid + 1, node->keys.begin() + node->keys.size());
         node->keys.erase(node->keys.begin(), node->keys.begin() + mid);
+        node->keys[0] = this->getSeparator(newLeaf1.keys.back(), newLeaf2.keys[0]);
         node->pointers.clear();
 
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newLeaf1.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newLeaf2.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
+        newLeaf1.allocatePage(ixFileHandle);
+        newLeaf2.allocatePage(ixFileHandle);
         node->children.emplace_back(newLeaf1.pageNum);
         node->children.emplace_back(newLeaf2.pageNum);
         node->writeNode(ixFileHandle);
@@ -202,10 +442,8 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         node->keys.erase(node->keys.begin(), node->keys.begin() + mid);
         node->children.clear();
 
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newInter1.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
-        ixFileHandle.fileHandle.appendPage(emptyPage);
-        newInter2.pageNum = ixFileHandle.fileHandle.getNumberOfPages() - 1;
+        newInter1.allocatePage(ixFileHandle);
+        newInter2.allocatePage(ixFileHandle);
         node->children.clear();
         node->children.emplace_back(newInter1.pageNum);
         node->children.emplace_back(newInter2.pageNum);
@@ -214,7 +452,6 @@ RC IndexManager::split(IXFileHandle &ixFileHandle, vector<Node *> &route) {
         newInter1.writeNode(ixFileHandle);
         newInter2.writeNode(ixFileHandle);
     }
-    free(emptyPage);
     return 0;
 }
 
@@ -223,44 +460,48 @@ RC IndexManager::deleteEntry(IXFileHandle &ixFileHandle, const Attribute &attrib
         return -1;
     }
 
+    // Most deletes leave the leaf at least half full, then it is the only page latched exclusively
     AttrValue attrValue;
     attrValue.readAttr(attribute.type, key);
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    ixFileHandle.fileHandle.readPage(0, page);
-    Node node = Node(ixFileHandle, attribute.type, page);
-    free(page);
-    node.pageNum = 0;
-    if (node.nodeType == SingleRoot) {
-        int pos = node.locateChildPos(attrValue, EQ_OP);
-        if (pos < 0) {
-            // -10 indicates delete a non-existing entry
-            return -10;
-        }
-
-        RC rc = node.deleteRecord(pos, rid);
-        if (rc != 0) {
-            return rc;
+    vector<int> path;
+    this->locateLeaf(ixFileHandle, attribute.type, attrValue, path, true);
+    void *page;
+    ixFileHandle.fileHandle.pinPage(path.back(), page);
+    Node *leaf = new Node(ixFileHandle, attribute.type, page);
+    ixFileHandle.fileHandle.unpinPage(path.back(), false);
+    leaf->pageNum = path.back();
+    int pos = leaf->locateChildPos(attrValue, EQ_OP);
+    // -10 indicates delete a non-existing entry
+    RC rc = pos < 0 ? -10 : leaf->deleteRecord(pos, rid);
+    if (rc != 0 || leaf->nodeType == SingleRoot || leaf->getNodeSize() >= PAGE_SIZE / 2) {
+        if (rc == 0) {
+            leaf->writeNode(ixFileHandle);
         }
-        node.writeNode(ixFileHandle);
+        delete leaf;
+        ixFileHandle.unlatchAll();
         return rc;
     }
+    delete leaf;
+    ixFileHandle.unlatchAll();
+
+    // The leaf may merge or borrow: start over, keeping every node on the way down latched exclusively
     vector<Node *> route;
-    routeToLeaf(ixFileHandle, route, &node, attrValue);
-    Node *leaf = route[route.size() - 1];
-    int pos = leaf->locateChildPos(attrValue, EQ_OP);
-    if (pos < 0) {
-        return -10;
-    }
-    RC rc = leaf->deleteRecord(pos, rid);
-    if (rc != 0) {
-        return rc;
+    this->routeToLeaf(ixFileHandle, attribute, attrValue, route, false);
+    leaf = route[route.size() - 1];
+    pos = leaf->locateChildPos(attrValue, EQ_OP);
+    rc = pos < 0 ? -10 : leaf->deleteRecord(pos, rid);
+    if (rc == 0) {
+        if (leaf->nodeType == SingleRoot) {
+            leaf->writeNode(ixFileHandle);
+        } else {
+            this->checkMerge(ixFileHandle, route);
+        }
     }
-    this->checkMerge(ixFileHandle, route);
-    for (int i = 1; i < route.size(); i++) {
+    for (int i = 0; i < route.size(); i++) {
         delete route[i];
     }
     route.clear();
+    ixFileHandle.unlatchAll();
     return rc;
 }
 
@@ -285,15 +526,16 @@ RC IndexManager::checkMerge(IXFileHandle &ixFileHandle, vector<Node *> &route) {
     if (sibPageNum == -1 && pos == -1) {
         return -1;
     }
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    ixFileHandle.fileHandle.readPage(sibPageNum, page);
+    this->latchSibling(ixFileHandle, node, sibPageNum, siblingType);
+    void *page;
+    ixFileHandle.fileHandle.pinPage(sibPageNum, page);
     Node *sibNode = new Node(ixFileHandle, node->attrType, page);
-    free(page);
+    ixFileHandle.fileHandle.unpinPage(sibPageNum, false);
     sibNode->pageNum = sibPageNum;
     int nodeSize = node->getNodeSize();
     int sibSize = sibNode->getNodeSize();
-    if (nodeSize < PAGE_SIZE / 2 && sibSize < PAGE_SIZE / 2 && nodeSize + sibSize + sizeof(int) < PAGE_SIZE) {
+    if (nodeSize < PAGE_SIZE / 2 && sibSize < PAGE_SIZE / 2 &&
+        node->getMergedSize(sibNode) + sizeof(int) < PAGE_SIZE) {
         this->merge(ixFileHandle, sibNode, route, pos, siblingType);
     } else if (nodeSize < PAGE_SIZE / 2) {
         this->borrow(ixFileHandle, node, sibNode, parent, pos, siblingType);
@@ -306,6 +548,8 @@ RC IndexManager::checkMerge(IXFileHandle &ixFileHandle, vector<Node *> &route) {
 RC IndexManager::merge(IXFileHandle &ixFileHandle, Node *sibNode, vector<Node *> &route, int &pos, int &siblingType) {
     Node *node = route[route.size() - 1];
     Node *parent = route[route.size() - 2];
+    int nodePageNum = node->pageNum;
+    int sibPageNum = sibNode->pageNum;
     if (siblingType == 1) {
         if (node->nodeType == Leaf) {
             if (parent->nodeType == Root && parent->keys.size() == 1) {
@@ -322,11 +566,11 @@ RC IndexManager::merge(IXFileHandle &ixFileHandle, Node *sibNode, vector<Node *>
             parent->children.erase(parent->children.begin() + pos + 1);
             node->next = sibNode->next;
             if (node->nodeType == Leaf && sibNode->next != -1) {
-                void *page = malloc(PAGE_SIZE);
-                memset(page, 0, PAGE_SIZE);
-                ixFileHandle.fileHandle.readPage(node->next, page);
+                void *page;
+                ixFileHandle.latchPage(node->next, true);
+                ixFileHandle.fileHandle.pinPage(node->next, page);
                 Node *sibNextNode = new Node(ixFileHandle, node->attrType, page);
-                free(page);
+                ixFileHandle.fileHandle.unpinPage(node->next, false);
                 sibNextNode->previous = node->pageNum;
                 sibNextNode->writeNode(ixFileHandle);
             }
@@ -383,6 +627,13 @@ RC IndexManager::merge(IXFileHandle &ixFileHandle, Node *sibNode, vector<Node *>
         parent->writeNode(ixFileHandle);
         sibNode->writeNode(ixFileHandle);
     }
+    // Pages merged away, or moved to the root, are not in the tree anymore
+    if (nodePageNum != node->pageNum || siblingType == -1) {
+        this->freePage(ixFileHandle, nodePageNum);
+    }
+    if (sibPageNum != sibNode->pageNum || siblingType == 1) {
+        this->freePage(ixFileHandle, sibPageNum);
+    }
     delete route[route.size() - 1];
     route.pop_back();
     if (route.size() == 1) {
@@ -404,11 +655,11 @@ RC IndexManager::merge(IXFileHandle &ixFileHandle, Node *sibNode, vector<Node *>
     if (uncPageNum == -1 && position == -1) {
         return -1;
     }
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    ixFileHandle.fileHandle.readPage(uncPageNum, page);
+    this->latchSibling(ixFileHandle, parent, uncPageNum, siblingType);
+    void *page;
+    ixFileHandle.fileHandle.pinPage(uncPageNum, page);
     Node *uncNode = new Node(ixFileHandle, parent->attrType, page);
-    free(page);
+    ixFileHandle.fileHandle.unpinPage(uncPageNum, false);
     uncNode->pageNum = uncPageNum;
     int parentSize = parent->getNodeSize();
     int uncleSize = uncNode->getNodeSize();
@@ -422,6 +673,30 @@ RC IndexManager::merge(IXFileHandle &ixFileHandle, Node *sibNode, vector<Node *>
     }
 }
 
+void IndexManager::latchSibling(IXFileHandle &ixFileHandle, Node *node, int sibPageNum, int siblingType) {
+    if (siblingType == -1 && node->nodeType == Leaf) {
+        // Leaves are latched from left to right, the way scans move along them
+        ixFileHandle.unlatchPage(node->pageNum);
+        ixFileHandle.latchPage(sibPageNum, true);
+        ixFileHandle.latchPage(node->pageNum, true);
+    } else {
+        ixFileHandle.latchPage(sibPageNum, true);
+    }
+}
+
+RC IndexManager::freePage(IXFileHandle &ixFileHandle, int pageNum) {
+    void *page = malloc(PAGE_SIZE);
+    memset(page, 0, PAGE_SIZE);
+    NodeType nodeType = Free;
+    int none = -1;
+    memcpy(page, &nodeType, sizeof(NodeType));
+    memcpy((char *) page + sizeof(NodeType), &none, sizeof(int));
+    memcpy((char *) page + sizeof(NodeType) + sizeof(int), &none, sizeof(int));
+    RC rc = ixFileHandle.fileHandle.writePage(pageNum, page);
+    free(page);
+    return rc;
+}
+
 RC IndexManager::borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, Node *parent, int &pos,
                         int &siblingType) {
     if (sibNode->keys.size() <= 1) {
@@ -429,7 +704,7 @@ RC IndexManager::borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, N
     }
     if (siblingType == 0) {
         if (node->nodeType == Leaf) {
-            if (node->getNodeSize() + sibNode->keys[0].length +
+            if (node->getNodeSize() + node->getKeyGrowth(sibNode->keys[0]) +
                 sibNode->pointers[0].size() * sizeof(RID) > PAGE_SIZE) {
                 return -1;
             }
@@ -452,7 +727,7 @@ RC IndexManager::borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, N
         int kSize = sibNode->keys.size();
         if (node->nodeType == Leaf) {
             int ptSize = sibNode->pointers.size();
-            if (node->getNodeSize() + sibNode->keys[kSize - 1].length +
+            if (node->getNodeSize() + node->getKeyGrowth(sibNode->keys[kSize - 1]) +
                 sibNode->pointers[ptSize - 1].size() * sizeof(RID) > PAGE_SIZE) {
                 return -1;
             }
@@ -460,7 +735,8 @@ RC IndexManager::borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, N
             node->pointers.insert(node->pointers.begin(), sibNode->pointers[ptSize - 1]);
             sibNode->keys.erase(sibNode->keys.begin() + kSize - 1);
             sibNode->pointers.erase(sibNode->pointers.begin() + ptSize - 1);
-            parent->keys[pos - 1] = sibNode->keys[0];
+            // The key moved over is the lowest of node now
+            parent->keys[pos - 1] = this->getSeparator(sibNode->keys.back(), node->keys[0]);
         } else if (node->nodeType == Intermediate) {
             int chSize = sibNode->children.size();
             if (node->getNodeSize() + sibNode->keys[kSize - 1].length + sizeof(int) > PAGE_SIZE) {
@@ -480,22 +756,80 @@ RC IndexManager::borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, N
     return 0;
 }
 
-RC IndexManager::routeToLeaf(IXFileHandle &ixFileHandle, vector<Node *> &route,
-                             Node *root, AttrValue &attrValue) {
-    route.emplace_back(root);
-    if (root->nodeType == Leaf) {
-        return 0;
+RC IndexManager::routeToLeaf(IXFileHandle &ixFileHandle, const Attribute &attribute, const AttrValue &attrValue,
+                             vector<Node *> &route, bool inserting) {
+    int pageNum = 0;
+    while (true) {
+        ixFileHandle.latchPage(pageNum, true);
+        void *page;
+        ixFileHandle.fileHandle.pinPage(pageNum, page);
+        Node *node = new Node(ixFileHandle, attribute.type, page);
+        ixFileHandle.fileHandle.unpinPage(pageNum, false);
+        node->pageNum = pageNum;
+        if (inserting && node->fitsEntry(attribute, attrValue)) {
+            // A split stops at this node, the ones above it stay as they are
+            for (int i = 0; i < route.size(); i++) {
+                ixFileHandle.unlatchPage(route[i]->pageNum);
+                delete route[i];
+            }
+            route.clear();
+        }
+        route.emplace_back(node);
+        if (node->nodeType == Leaf || node->nodeType == SingleRoot) {
+            return 0;
+        }
+        pageNum = node->children[node->locateChildPos(attrValue, LT_OP)];
     }
-    int pos = root->locateChildPos(attrValue, LT_OP);
+}
 
-    void *page = (char *) malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    ixFileHandle.fileHandle.readPage(root->children[pos], page);
-    Node *node = new Node(ixFileHandle, root->attrType, page);
-    free(page);
-    node->pageNum = root->children[pos];
-    routeToLeaf(ixFileHandle, route, node, attrValue);
-    return 0;
+RC IndexManager::locateLeaf(IXFileHandle &ixFileHandle, AttrType attrType, const AttrValue &attrValue,
+                            vector<int> &path, bool exclusive, AttrValue *upperFence) {
+    NodeView view(attrType);
+    int pageNum = 0;
+    int parent = -1;
+    bool latchedExclusive = false;
+    void *page;
+    ixFileHandle.latchPage(pageNum, false);
+    while (true) {
+        RC rc = ixFileHandle.fileHandle.pinPage(pageNum, page);
+        if (rc != 0) {
+            ixFileHandle.unlatchAll();
+            return rc;
+        }
+        view.load(page);
+        bool leaf = view.nodeType == Leaf || view.nodeType == SingleRoot;
+        if (leaf && exclusive && !latchedExclusive) {
+            // The parent, still latched, keeps the leaf from splitting or merging meanwhile. The root has no
+            // parent, it is read again.
+            ixFileHandle.fileHandle.unpinPage(pageNum, false);
+            ixFileHandle.unlatchPage(pageNum);
+            ixFileHandle.latchPage(pageNum, true);
+            latchedExclusive = true;
+            continue;
+        }
+        // Crab down: a node is let go once its child is latched the way it is needed
+        if (parent != -1) {
+            ixFileHandle.unlatchPage(parent);
+        }
+        path.emplace_back(pageNum);
+        if (leaf) {
+            ixFileHandle.fileHandle.unpinPage(pageNum, false);
+            return 0;
+        }
+        int pos = view.upperBound(attrValue);
+        if (upperFence != nullptr && pos < view.nKeys) {
+            // The key right of the child bounds its subtree, the one a level down is the tighter bound
+            char key[PAGE_SIZE];
+            view.copyKey(pos, key);
+            upperFence->readAttr(attrType, key);
+        }
+        int child = view.getChild(pos);
+        ixFileHandle.fileHandle.unpinPage(pageNum, false);
+        ixFileHandle.latchPage(child, false);
+        parent = pageNum;
+        pageNum = child;
+        latchedExclusive = false;
+    }
 }
 
 RC IndexManager::scan(IXFileHandle &ixFileHandle,
@@ -510,12 +844,14 @@ RC IndexManager::scan(IXFileHandle &ixFileHandle,
         return -12;
     }
 
+    ix_ScanIterator.close();
     ix_ScanIterator.lowKey.readAttr(attribute.type, lowKey);
     ix_ScanIterator.highKey.readAttr(attribute.type, highKey);
     ix_ScanIterator.lowKeyInclusive = lowKeyKeyInclusive;
     ix_ScanIterator.highKeyInclusive = highKeyKeyInclusive;
     ix_ScanIterator.attrType = attribute.type;
     ix_ScanIterator.ixFileHandle = &ixFileHandle;
+    ix_ScanIterator.view = NodeView(attribute.type);
     return 0;
 }
 
@@ -589,136 +925,207 @@ RC Node::printNodePointers(int indent) {
 }
 
 IX_ScanIterator::IX_ScanIterator() {
-    this->pageNum = 0;
+    this->pageNum = -1;
+    this->page = nullptr;
     this->curK = 0;
-    this->curR = -1;
-    this->prevP = -1;
-    this->prevK = -1;
-    this->prevR = -1;
+    this->curR = 0;
+    this->pageVersion = 0;
+    this->resuming = false;
+    this->ixFileHandle = nullptr;
 }
 
-RC IX_ScanIterator::getNextEntry(RID &rid, void *key) {
-    if (this->pageNum > this->ixFileHandle->fileHandle.getNumberOfPages() - 1) {
-        return -1;
-    }
+IX_ScanIterator::~IX_ScanIterator() {
+    this->close();
+}
 
-    if (this->node == nullptr) {
-        void *page = malloc(PAGE_SIZE);
-        memset(page, 0, PAGE_SIZE);
-        this->ixFileHandle->fileHandle.readPage(this->pageNum, page);
-        this->node = new Node(*this->ixFileHandle, this->attrType, page);
-        this->node->pageNum = this->pageNum;
-        free(page);
+RC IX_ScanIterator::getNextEntry(RID &rid, void *key) {
+    FileHandle &fileHandle = this->ixFileHandle->fileHandle;
+    int k;
+    int r;
+    if (this->pageNum == -1) {
+        if (fileHandle.getNumberOfPages() == 0) {
+            return IX_EOF;
+        }
+        this->reachLeaf(this->lowKey);
+        k = this->lowKey.length > 0 ? this->view.lowerBound(this->lowKey) : 0;
+        r = 0;
+        this->resuming = false;
+    } else if (this->page == nullptr) {
+        return IX_EOF;
+    } else {
+        // The leaf stays pinned between calls but not latched. Unless it has been written since the
+        // last entry, the view and the position in it still hold.
+        unsigned long long version;
+        fileHandle.latchPage(this->pageNum, false, version);
+        if (version == this->pageVersion) {
+            k = this->curK;
+            r = this->curR + 1;
+        } else {
+            this->pageVersion = version;
+            this->loadLeaf();
+            if (this->view.nodeType != Leaf && this->view.nodeType != SingleRoot) {
+                // Merged away, or the root leaf has split: look for the last key from the top again
+                fileHandle.unpinPage(this->pageNum, false);
+                fileHandle.unlatchPage(this->pageNum);
+                this->reachLeaf(this->lastKey);
+            }
+            k = this->curK;
+            if (k >= this->view.nKeys || this->view.compareKey(k, this->lastKey) != 0) {
+                k = this->view.lowerBound(this->lastKey);
+            }
+            r = 0;
+            this->resuming = true;
+        }
     }
 
-    if (this->node->nodeType != SingleRoot && this->node->nodeType != Leaf) {
-        this->pageNum = reachLeaf();
-    }
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
     while (true) {
-        this->curR++;
-        if (!this->node->pointers.empty() && this->curR >= this->node->pointers[this->curK].size()) {
-            this->curK++;
-            this->curR = 0;
-        }
-        if (this->curK >= this->node->keys.size() && this->node->next != -1) {
-            this->ixFileHandle->fileHandle.readPage(this->node->next, page);
-            this->pageNum = this->node->next;
-            delete this->node;
-            this->node = new Node(*this->ixFileHandle, this->attrType, page);
-            this->node->pageNum = this->pageNum;
-            this->curK = 0;
-            this->curR = 0;
-        }
-
-        if (this->curK >= this->node->keys.size() && this->node->next == -1) {
-            free(page);
-            return IX_EOF;
+        if (k >= this->view.nKeys) {
+            int next = this->view.next;
+            if (next == -1) {
+                this->release();
+                return IX_EOF;
+            }
+            // Leaves are latched from left to right, the next one before this one is let go
+            fileHandle.latchPage(next, false, this->pageVersion);
+            fileHandle.unpinPage(this->pageNum, false);
+            fileHandle.unlatchPage(this->pageNum);
+            this->pageNum = next;
+            fileHandle.pinPage(this->pageNum, this->page);
+            this->loadLeaf();
+            k = 0;
+            r = 0;
+            continue;
         }
-        if (this->curK >= this->node->keys.size() || this->curR >= this->node->pointers[this->curK].size()) {
+        if (this->resuming) {
+            // The first key at or after the last one returned, skip its rids returned already.
+            // Smaller keys have been passed before a split moved them into the next leaf.
+            int comp = this->view.compareKey(k, this->lastKey);
+            if (comp < 0) {
+                k++;
+                continue;
+            }
+            this->resuming = false;
+            if (comp == 0) {
+                r = this->getResumePosition(k);
+            }
+        }
+        if (r >= this->getRidCount(k)) {
+            k++;
+            r = 0;
             continue;
         }
 
         if (this->lowKey.length > 0) {
-            if (this->lowKeyInclusive) {
-                if (AttrValue::compAttr(this->node->keys[this->curK], this->lowKey, LT_OP)) {
-                    continue;
-                }
-            } else {
-                if (AttrValue::compAttr(this->node->keys[this->curK], this->lowKey, LE_OP)) {
-                    continue;
-                }
+            int comp = this->view.compareKey(k, this->lowKey);
+            if (comp < 0 || (comp == 0 && !this->lowKeyInclusive)) {
+                k++;
+                r = 0;
+                continue;
             }
         }
         if (this->highKey.length > 0) {
-            if (this->highKeyInclusive) {
-                if (AttrValue::compAttr(this->node->keys[this->curK], this->highKey, GT_OP)) {
-                    free(page);
-                    return IX_EOF;
-                }
-            } else {
-                if (AttrValue::compAttr(this->node->keys[this->curK], this->highKey, GE_OP)) {
-                    free(page);
-                    return IX_EOF;
-                }
-            }
-        }
-        rid.pageNum = this->node->pointers[this->curK][this->curR].pageNum;
-        rid.slotNum = this->node->pointers[this->curK][this->curR].slotNum;
-        this->node->keys[this->curK].writeAttr(key);
-        if (this->prevP == this->pageNum) {
-            this->ixFileHandle->fileHandle.readPage(this->pageNum, page);
-            delete this->node;
-            this->node = new Node(*this->ixFileHandle, this->attrType, page);
-            this->node->pageNum = this->pageNum;
-            RID lastRid = this->node->pointers[this->prevK][this->prevR];
-            // In this situation, the prevRid has already been deleted
-            if (lastRid.pageNum != this->prevRid.pageNum || lastRid.slotNum != this->prevRid.slotNum) {
-                this->curK = this->prevK;
-                this->curR = this->prevR;
-                this->pageNum = this->prevP;
+            int comp = this->view.compareKey(k, this->highKey);
+            if (comp > 0 || (comp == 0 && !this->highKeyInclusive)) {
+                this->release();
+                return IX_EOF;
             }
         }
+        rid = this->getRid(k, r);
+        this->view.copyKey(k, key);
+        this->lastKey.readAttr(this->attrType, key);
+        this->curK = k;
+        this->curR = r;
         this->prevRid = rid;
-        this->prevP = this->pageNum;
-        this->prevK = this->curK;
-        this->prevR = this->curR;
-        break;
+        fileHandle.unlatchPage(this->pageNum);
+        return 0;
     }
-    free(page);
-    return 0;
 }
 
 RC IX_ScanIterator::close() {
-    this->pageNum = 0;
-    this->curK = 0;
-    this->curR = -1;
-    if (this->node != nullptr) {
-        delete this->node;
-        this->node = nullptr;
+    if (this->page != nullptr) {
+        this->ixFileHandle->fileHandle.unpinPage(this->pageNum, false);
+        this->page = nullptr;
     }
+    this->pageNum = -1;
+    this->curK = 0;
+    this->curR = 0;
+    this->overflowRids.clear();
     return 0;
 }
 
-int IX_ScanIterator::reachLeaf() {
+void IX_ScanIterator::reachLeaf(const AttrValue &attrValue) {
+    FileHandle &fileHandle = this->ixFileHandle->fileHandle;
     int cPage = 0;
-    int pos;
-    void *page = (char *) malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    while (this->node->nodeType != SingleRoot && this->node->nodeType != Leaf) {
-        if (this->lowKey.length > 0) {
-            pos = this->node->locateChildPos(this->lowKey, LT_OP);
-        } else {
-            pos = 0;
+    fileHandle.latchPage(cPage, false, this->pageVersion);
+    while (true) {
+        fileHandle.pinPage(cPage, this->page);
+        this->view.load(this->page);
+        if (this->view.nodeType == SingleRoot || this->view.nodeType == Leaf) {
+            // The leaf is kept pinned for the scan
+            this->pageNum = cPage;
+            this->loadLeaf();
+            return;
         }
-        cPage = this->node->children[pos];
-        this->ixFileHandle->fileHandle.readPage(cPage, page);
-        delete this->node;
-        this->node = new Node(*this->ixFileHandle, this->attrType, page);
+        int pos = attrValue.length > 0 ? this->view.upperBound(attrValue) : 0;
+        int child = this->view.getChild(pos);
+        fileHandle.latchPage(child, false, this->pageVersion);
+        fileHandle.unpinPage(cPage, false);
+        fileHandle.unlatchPage(cPage);
+        cPage = child;
     }
-    free(page);
-    return cPage;
+}
+
+void IX_ScanIterator::release() {
+    this->ixFileHandle->fileHandle.unpinPage(this->pageNum, false);
+    this->ixFileHandle->fileHandle.unlatchPage(this->pageNum);
+    this->page = nullptr;
+}
+
+int IX_ScanIterator::getResumePosition(int k) {
+    // The rids of a key keep their order, the ones up to prevRid have been returned
+    int count = this->getRidCount(k);
+    for (int i = 0; i < count; i++) {
+        int r = (this->curR + i) % count;
+        RID rid = this->getRid(k, r);
+        if (rid.pageNum == this->prevRid.pageNum && rid.slotNum == this->prevRid.slotNum) {
+            return r + 1;
+        }
+    }
+    // prevRid has been deleted, the rid after it has taken its place
+    return this->curR < count ? this->curR : count;
+}
+
+void IX_ScanIterator::loadLeaf() {
+    this->view.load(this->page);
+    this->overflowRids.clear();
+    if (this->view.nodeType != Leaf && this->view.nodeType != SingleRoot) {
+        return;
+    }
+    int overflowPage = this->view.overflowPage;
+    while (overflowPage != -1) {
+        void *overflow;
+        this->ixFileHandle->fileHandle.pinPage(overflowPage, overflow);
+        int nRids;
+        memcpy(&nRids, overflow, sizeof(int));
+        for (int i = 0; i < nRids; i++) {
+            RID rid;
+            memcpy(&rid, (char *) overflow + sizeof(int) + i * sizeof(RID), sizeof(RID));
+            this->overflowRids.emplace_back(rid);
+        }
+        int nextPage;
+        memcpy(&nextPage, (char *) overflow + sizeof(int) + nRids * sizeof(RID), sizeof(int));
+        this->ixFileHandle->fileHandle.unpinPage(overflowPage, false);
+        overflowPage = nextPage;
+    }
+}
+
+int IX_ScanIterator::getRidCount(int k) {
+    return this->view.getRidCount(k) + (k == 0 ? (int) this->overflowRids.size() : 0);
+}
+
+RID IX_ScanIterator::getRid(int k, int r) {
+    int inPage = this->view.getRidCount(k);
+    return r < inPage ? this->view.getRid(k, r) : this->overflowRids[r - inPage];
 }
 
 IXFileHandle::IXFileHandle() {
@@ -738,6 +1145,35 @@ RC IXFileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePa
     return 0;
 }
 
+RC IXFileHandle::latchPage(int pageNum, bool exclusive) {
+    RC rc = this->fileHandle.latchPage(pageNum, exclusive);
+    if (rc == 0) {
+        this->latchedPages.emplace_back(pageNum);
+    }
+    return rc;
+}
+
+RC IXFileHandle::unlatchPage(int pageNum) {
+    for (int i = 0; i < this->latchedPages.size(); i++) {
+        if (this->latchedPages[i] == pageNum) {
+            this->latchedPages.erase(this->latchedPages.begin() + i);
+            return this->fileHandle.unlatchPage(pageNum);
+        }
+    }
+    return -19; // LatchException
+}
+
+void IXFileHandle::unlatchAll() {
+    for (int pageNum : this->latchedPages) {
+        this->fileHandle.unlatchPage(pageNum);
+    }
+    this->latchedPages.clear();
+}
+
+bool isFixedWidth(AttrType attrType) {
+    return attrType == TypeInt || attrType == TypeReal;
+}
+
 Node::~Node() {}
 
 Node::Node(AttrType type) {
@@ -762,15 +1198,43 @@ Node::Node(IXFileHandle &ixFileHandle, AttrType type, const void *page) {
     int nKeys;
     memcpy(&nKeys, (char *) page + offset, sizeof(int));
     offset += sizeof(int);
-    AttrValue attrValue;
-    for (int i = 0; i < nKeys; i++) {
-        attrValue.readAttr(this->attrType, (char *) page + offset);
-        offset += attrValue.length;
-        this->keys.emplace_back(attrValue);
+    if (this->hasKeyPrefix()) {
+        int prefixLength;
+        memcpy(&prefixLength, (char *) page + offset, sizeof(int));
+        offset += sizeof(int);
+        string prefix((char *) page + offset, prefixLength);
+        offset += prefixLength;
+        for (int i = 0; i < nKeys; i++) {
+            int suffixLength;
+            memcpy(&suffixLength, (char *) page + offset, sizeof(int));
+            offset += sizeof(int);
+            this->keys.emplace_back(AttrValue(prefix + string((char *) page + offset, suffixLength)));
+            offset += suffixLength;
+        }
+    } else {
+        AttrValue attrValue;
+        for (int i = 0; i < nKeys; i++) {
+            attrValue.readAttr(this->attrType, (char *) page + offset);
+            offset += attrValue.length;
+            this->keys.emplace_back(attrValue);
+        }
     }
 
     // Copy rids to Node
-    if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
+    if ((this->nodeType == Leaf || this->nodeType == SingleRoot) && isFixedWidth(this->attrType)) {
+        // The end of the rids of each key, then one rid array for all of them
+        int ridBase = offset + nKeys * sizeof(int);
+        int begin = 0;
+        for (int i = 0; i < nKeys; i++) {
+            int end;
+            memcpy(&end, (char *) page + offset + i * sizeof(int), sizeof(int));
+            vector<RID> rids(end - begin);
+            memcpy(rids.data(), (char *) page + ridBase + begin * sizeof(RID), (end - begin) * sizeof(RID));
+            this->pointers.emplace_back(rids);
+            begin = end;
+        }
+        offset = ridBase + begin * sizeof(RID);
+    } else if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
         int nRids;
         memcpy(&nRids, (char *) page + offset, sizeof(int));
         offset += sizeof(int);
@@ -809,9 +1273,8 @@ Node::Node(IXFileHandle &ixFileHandle, AttrType type, const void *page) {
 }
 
 RC Node::deserializeOverflowPage(IXFileHandle &ixFileHandle, int nodePageNum) {
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    ixFileHandle.fileHandle.readPage(nodePageNum, page);
+    void *page;
+    ixFileHandle.fileHandle.pinPage(nodePageNum, page);
     int offset = 0;
     int nRids;
     memcpy(&nRids, (char *) page + offset, sizeof(int));
@@ -824,7 +1287,7 @@ RC Node::deserializeOverflowPage(IXFileHandle &ixFileHandle, int nodePageNum) {
     }
     int overFlowPageNum;
     memcpy(&overFlowPageNum, (char *) page + offset, sizeof(int));
-    free(page);
+    ixFileHandle.fileHandle.unpinPage(nodePageNum, false);
     if (overFlowPageNum != -1) {
         this->overFlowPages.emplace_back(overFlowPageNum);
         this->deserializeOverflowPage(ixFileHandle, overFlowPageNum);
@@ -841,9 +1304,10 @@ RC Node::writeNode(IXFileHandle &ixFileHandle) {
         int remainSpace = this->pointers[0].size() - nRidInNode;
         int nRidInPage = (PAGE_SIZE - sizeof(RID)) / sizeof(RID);
         int required = remainSpace / nRidInPage + 1;
-        if (required > this->overFlowPages.size()) {
-            ixFileHandle.fileHandle.appendPage(page);
-            this->overFlowPages.emplace_back(ixFileHandle.fileHandle.getNumberOfPages() - 1);
+        while (required > this->overFlowPages.size()) {
+            PageNum overflowPage;
+            ixFileHandle.fileHandle.appendPage(page, overflowPage);
+            this->overFlowPages.emplace_back(overflowPage);
         }
 
         int offset = 0;
@@ -853,24 +1317,16 @@ RC Node::writeNode(IXFileHandle &ixFileHandle) {
         offset += sizeof(int);
         memcpy((char *) page + offset, &this->next, sizeof(int));
         offset += sizeof(int);
-        int nKeys = this->keys.size();
-        memcpy((char *) page + offset, &nKeys, sizeof(int));
-        offset += sizeof(int);
-        for (int i = 0; i < nKeys; i++) {
-            this->keys[i].writeAttr((char *) page + offset);
-            offset += this->keys[i].length;
-        }
-        int nRids = this->pointers.size();
-        memcpy((char *) page + offset, &nRids, sizeof(int));
-        offset += sizeof(int);
-        for (int i = 0; i < nRids; i++) {
-            memcpy((char *) page + offset, &nRidInNode, sizeof(int));
+        offset = this->serializeKeys(page, offset);
+        if (!isFixedWidth(this->attrType)) {
+            int nRids = this->pointers.size();
+            memcpy((char *) page + offset, &nRids, sizeof(int));
             offset += sizeof(int);
-            for (int j = 0; j < nRidInNode; j++) {
-                memcpy((char *) page + offset, &this->pointers[i][j], sizeof(RID));
-                offset += sizeof(RID);
-            }
         }
+        memcpy((char *) page + offset, &nRidInNode, sizeof(int));
+        offset += sizeof(int);
+        memcpy((char *) page + offset, this->pointers[0].data(), nRidInNode * sizeof(RID));
+        offset += nRidInNode * sizeof(RID);
 
         memcpy((char *) page + offset, &this->overFlowPages[0], sizeof(int));
         ixFileHandle.fileHandle.writePage(this->pageNum, page);
@@ -896,6 +1352,93 @@ RC Node::writeNode(IXFileHandle &ixFileHandle) {
     return 0;
 }
 
+bool Node::hasKeyPrefix() {
+    return this->attrType == TypeVarChar && (this->nodeType == Leaf || this->nodeType == SingleRoot);
+}
+
+int Node::getPrefixLength() {
+    if (!this->hasKeyPrefix() || this->keys.empty() || !IndexManager::instance().keyCompression) {
+        return 0;
+    }
+    // Keys are sorted, what the first and the last share is shared by all
+    const string &first = this->keys.front().vchar;
+    return getCommonPrefix(first, this->keys.back().vchar, first.size());
+}
+
+int Node::serializeKeys(void *page, int offset) {
+    int nKeys = this->keys.size();
+    memcpy((char *) page + offset, &nKeys, sizeof(int));
+    offset += sizeof(int);
+    if (!this->hasKeyPrefix()) {
+        for (int i = 0; i < nKeys; i++) {
+            this->keys[i].writeAttr((char *) page + offset);
+            offset += this->keys[i].length;
+        }
+        return offset;
+    }
+    int prefixLength = this->getPrefixLength();
+    memcpy((char *) page + offset, &prefixLength, sizeof(int));
+    offset += sizeof(int);
+    if (nKeys > 0) {
+        memcpy((char *) page + offset, this->keys[0].vchar.data(), prefixLength);
+        offset += prefixLength;
+    }
+    for (int i = 0; i < nKeys; i++) {
+        int suffixLength = this->keys[i].vchar.size() - prefixLength;
+        memcpy((char *) page + offset, &suffixLength, sizeof(int));
+        offset += sizeof(int);
+        memcpy((char *) page + offset, this->keys[i].vchar.data() + prefixLength, suffixLength);
+        offset += suffixLength;
+    }
+    return offset;
+}
+
+int Node::getKeysSize() {
+    int size = sizeof(int); // nKeys: this->keys.size()
+    int prefixLength = this->getPrefixLength();
+    if (this->hasKeyPrefix()) {
+        size += sizeof(int) + prefixLength;
+    }
+    for (int i = 0; i < this->keys.size(); i++) {
+        size += this->keys[i].length - prefixLength;
+    }
+    return size;
+}
+
+int Node::getKeyGrowth(const AttrValue &attrValue) {
+    int prefixLength = this->getPrefixLength();
+    if (prefixLength == 0) {
+        return attrValue.length;
+    }
+    // The keys only share what attrValue shares with them, every other key gets longer
+    int common = getCommonPrefix(this->keys.front().vchar, attrValue.vchar, prefixLength);
+    return attrValue.length - common + ((int) this->keys.size() - 1) * (prefixLength - common);
+}
+
+int Node::getMergedSize(Node *sibling) {
+    int size = this->getNodeSize() + sibling->getNodeSize();
+    int prefixLength = this->getPrefixLength();
+    int sibPrefixLength = sibling->getPrefixLength();
+    if ((prefixLength == 0 && sibPrefixLength == 0) || this->keys.empty() || sibling->keys.empty()) {
+        return size;
+    }
+    int common = getCommonPrefix(this->keys.front().vchar, sibling->keys.front().vchar,
+                                 prefixLength < sibPrefixLength ? prefixLength : sibPrefixLength);
+    return size + this->keys.size() * (prefixLength - common) + sibling->keys.size() * (sibPrefixLength - common);
+}
+
+bool Node::fitsEntry(const Attribute &attribute, const AttrValue &attrValue) {
+    if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
+        return this->getNodeSize() + this->getKeyGrowth(attrValue) + sizeof(int) + sizeof(RID) <= PAGE_SIZE;
+    }
+    // A separator is a key of the leaves, at most as long as the attribute
+    int keyLength = sizeof(int);
+    if (attribute.type == TypeVarChar) {
+        keyLength += attribute.length > attrValue.vchar.size() ? attribute.length : attrValue.vchar.size();
+    }
+    return this->getNodeSize() + keyLength + sizeof(int) <= PAGE_SIZE;
+}
+
 RC Node::serialize(void *page) {
     int offset = 0;
     memcpy((char *) page + offset, &this->nodeType, sizeof(int));
@@ -906,14 +1449,20 @@ RC Node::serialize(void *page) {
     offset += sizeof(int);
 
     int nKeys = this->keys.size();
-    memcpy((char *) page + offset, &nKeys, sizeof(int));
-    offset += sizeof(int);
-    for (int i = 0; i < nKeys; i++) {
-        this->keys[i].writeAttr((char *) page + offset);
-        offset += this->keys[i].length;
-    }
+    offset = this->serializeKeys(page, offset);
 
-    if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
+    if ((this->nodeType == Leaf || this->nodeType == SingleRoot) && isFixedWidth(this->attrType)) {
+        int end = 0;
+        for (int i = 0; i < nKeys; i++) {
+            end += this->pointers[i].size();
+            memcpy((char *) page + offset, &end, sizeof(int));
+            offset += sizeof(int);
+        }
+        for (int i = 0; i < nKeys; i++) {
+            memcpy((char *) page + offset, this->pointers[i].data(), this->pointers[i].size() * sizeof(RID));
+            offset += this->pointers[i].size() * sizeof(RID);
+        }
+    } else if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
         int nRids = this->pointers.size();
         memcpy((char *) page + offset, &nRids, sizeof(int));
         offset += sizeof(int);
@@ -953,18 +1502,40 @@ int Node::serializeOverflowPage(int start, int end, void *page) {
     return offset;
 }
 
-int Node::locateChildPos(AttrValue &attrValue, CompOp compOp) {
+int Node::locateChildPos(const AttrValue &attrValue, CompOp compOp) {
+    // Keys are sorted and unique, so both lookups are a binary search
+    int low = 0;
+    int high = this->keys.size();
+    if (compOp == LT_OP) {
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (attrValue < this->keys[mid]) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+        return low;
+    }
+    if (compOp == EQ_OP) {
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (this->keys[mid] < attrValue) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low < this->keys.size() && this->keys[low] == attrValue ? low : -1;
+    }
+
     int i;
     for (i = 0; i < this->keys.size(); i++) {
         if (AttrValue::compAttr(attrValue, this->keys[i], compOp)) {
             return i;
         }
     }
-    if (compOp == EQ_OP) {
-        return -1;
-    } else {
-        return i;
-    }
+    return i;
 }
 
 bool Node::checkKeyExist(const int &pos, const AttrValue &attrValue) {
@@ -1014,15 +1585,13 @@ int Node::getLeftSibling(Node *parent, int &pos) {
 int Node::getNodeSize() {
     int size = 0;
     size += sizeof(NodeType) + 2 * sizeof(int); // nodeType, previous, next
-    int nKeys = this->keys.size();
-    size += sizeof(int); // nKeys: this->keys.size()
-    for (int i = 0; i < nKeys; i++) {
-        size += this->keys[i].length;
-    }
+    size += this->getKeysSize();
 
     if (this->nodeType == Leaf || this->nodeType == SingleRoot) {
         int nRids = this->pointers.size();
-        size += sizeof(int); // nRids: this->pointer.size();
+        if (!isFixedWidth(this->attrType)) {
+            size += sizeof(int); // nRids: this->pointer.size();
+        }
         for (int i = 0; i < nRids; i++) {
             size += sizeof(int); // nRecs: this->pointers[i].size();
             size += this->pointers[i].size() * sizeof(RID);
@@ -1036,15 +1605,27 @@ int Node::getNodeSize() {
     return size;
 }
 
+RC Node::allocatePage(IXFileHandle &ixFileHandle) {
+    void *page = malloc(PAGE_SIZE);
+    memset(page, 0, PAGE_SIZE);
+    PageNum newPage;
+    RC rc = ixFileHandle.fileHandle.appendPage(page, newPage);
+    free(page);
+    if (rc != 0) {
+        return rc;
+    }
+    this->pageNum = newPage;
+    return 0;
+}
+
 int Node::getHeaderSize() {
     int size = 0;
     size += sizeof(NodeType) + 2 * sizeof(int); // nodeType, previous, next
-    int nKeys = this->keys.size();
-    size += sizeof(int); // number of keys
-    for (int i = 0; i < nKeys; i++) {
-        size += this->keys[i].length;
+    size += this->getKeysSize();
+    size += 2 * sizeof(int); // overflow pointer, nRec
+    if (!isFixedWidth(this->attrType)) {
+        size += sizeof(int); // nRids
     }
-    size += 3 * sizeof(int); // overflow pointer, nRec, nRids
     return size;
 }
 
@@ -1068,4 +1649,199 @@ RC Node::deleteRecord(int pos, const RID &rid) {
         return -11;
     }
 
-}
\ No newline at end of file
+}
+
+NodeView::NodeView(AttrType type) {
+    this->attrType = type;
+    this->page = nullptr;
+    this->nKeys = 0;
+    this->prefixLength = 0;
+}
+
+void NodeView::load(const void *page) {
+    this->page = (const char *) page;
+    int offset = 0;
+    memcpy(&this->nodeType, this->page + offset, sizeof(NodeType));
+    offset += sizeof(NodeType);
+    memcpy(&this->previous, this->page + offset, sizeof(int));
+    offset += sizeof(int);
+    memcpy(&this->next, this->page + offset, sizeof(int));
+    offset += sizeof(int);
+    memcpy(&this->nKeys, this->page + offset, sizeof(int));
+    offset += sizeof(int);
+    this->keyBase = offset;
+    bool leaf = this->nodeType == Leaf || this->nodeType == SingleRoot;
+
+    if (isFixedWidth(this->attrType)) {
+        // Every field is found by arithmetic, there is nothing to walk
+        offset += this->nKeys * sizeof(int);
+        if (leaf) {
+            this->ridEndOffset = offset;
+            this->ridBase = offset + this->nKeys * sizeof(int);
+            offset = this->ridBase + (this->nKeys > 0 ? this->getRidEnd(this->nKeys - 1) : 0) * sizeof(RID);
+        } else {
+            int nChildren;
+            memcpy(&nChildren, this->page + offset, sizeof(int));
+            this->childOffset = offset + sizeof(int);
+            offset = this->childOffset + nChildren * sizeof(int);
+        }
+        memcpy(&this->overflowPage, this->page + offset, sizeof(int));
+        return;
+    }
+
+    // Leaves store the prefix shared by their keys once, keyOffsets then point at the suffixes
+    this->prefixLength = 0;
+    if (leaf) {
+        memcpy(&this->prefixLength, this->page + offset, sizeof(int));
+        this->prefixOffset = offset + sizeof(int);
+        offset = this->prefixOffset + this->prefixLength;
+    }
+    this->keyOffsets.clear();
+    for (int i = 0; i < this->nKeys; i++) {
+        this->keyOffsets.emplace_back(offset);
+        int len;
+        memcpy(&len, this->page + offset, sizeof(int));
+        offset += sizeof(int) + len;
+    }
+    this->keyOffsets.emplace_back(offset);
+
+    this->ridOffsets.clear();
+    if (leaf) {
+        int nRids;
+        memcpy(&nRids, this->page + offset, sizeof(int));
+        offset += sizeof(int);
+        for (int i = 0; i < nRids; i++) {
+            this->ridOffsets.emplace_back(offset);
+            int nRec;
+            memcpy(&nRec, this->page + offset, sizeof(int));
+            offset += sizeof(int) + nRec * sizeof(RID);
+        }
+    } else {
+        int nChildren;
+        memcpy(&nChildren, this->page + offset, sizeof(int));
+        offset += sizeof(int);
+        this->childOffset = offset;
+        offset += nChildren * sizeof(int);
+    }
+    memcpy(&this->overflowPage, this->page + offset, sizeof(int));
+}
+
+int NodeView::upperBound(const AttrValue &attrValue) const {
+    int low = 0;
+    int high = this->nKeys;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (this->compareKey(mid, attrValue) > 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return low;
+}
+
+int NodeView::lowerBound(const AttrValue &attrValue) const {
+    int low = 0;
+    int high = this->nKeys;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (this->compareKey(mid, attrValue) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+int NodeView::compareKey(int pos, const AttrValue &attrValue) const {
+    if (attrValue.length == 0) {
+        // An empty value stands for minus infinity
+        return 1;
+    }
+    const char *key = this->page + this->getKeyOffset(pos);
+    switch (this->attrType) {
+        case TypeInt: {
+            int itg;
+            memcpy(&itg, key, sizeof(int));
+            return itg < attrValue.itg ? -1 : (itg > attrValue.itg ? 1 : 0);
+        }
+        case TypeReal: {
+            float flt;
+            memcpy(&flt, key, sizeof(float));
+            return flt < attrValue.flt ? -1 : (flt > attrValue.flt ? 1 : 0);
+        }
+        default: {
+            int len;
+            memcpy(&len, key, sizeof(int));
+            const char *value = attrValue.vchar.data();
+            int valueLen = attrValue.vchar.size();
+            if (this->prefixLength > 0) {
+                int comp = memcmp(this->page + this->prefixOffset, value,
+                                  this->prefixLength < valueLen ? this->prefixLength : valueLen);
+                if (comp != 0) {
+                    return comp;
+                }
+                if (valueLen < this->prefixLength) {
+                    return 1;
+                }
+                value += this->prefixLength;
+                valueLen -= this->prefixLength;
+            }
+            int comp = memcmp(key + sizeof(int), value, len < valueLen ? len : valueLen);
+            if (comp != 0) {
+                return comp;
+            }
+            return len < valueLen ? -1 : (len > valueLen ? 1 : 0);
+        }
+    }
+}
+
+void NodeView::copyKey(int pos, void *key) const {
+    if (isFixedWidth(this->attrType)) {
+        memcpy(key, this->page + this->getKeyOffset(pos), sizeof(int));
+    } else {
+        int suffixLength = this->keyOffsets[pos + 1] - this->keyOffsets[pos] - sizeof(int);
+        int len = this->prefixLength + suffixLength;
+        memcpy(key, &len, sizeof(int));
+        memcpy((char *) key + sizeof(int), this->page + this->prefixOffset, this->prefixLength);
+        memcpy((char *) key + sizeof(int) + this->prefixLength,
+               this->page + this->keyOffsets[pos] + sizeof(int), suffixLength);
+    }
+}
+
+int NodeView::getChild(int pos) const {
+    int child;
+    memcpy(&child, this->page + this->childOffset + pos * sizeof(int), sizeof(int));
+    return child;
+}
+
+int NodeView::getRidCount(int pos) const {
+    if (isFixedWidth(this->attrType)) {
+        return this->getRidEnd(pos) - (pos > 0 ? this->getRidEnd(pos - 1) : 0);
+    }
+    int nRec;
+    memcpy(&nRec, this->page + this->ridOffsets[pos], sizeof(int));
+    return nRec;
+}
+
+RID NodeView::getRid(int pos, int i) const {
+    RID rid;
+    if (isFixedWidth(this->attrType)) {
+        int begin = pos > 0 ? this->getRidEnd(pos - 1) : 0;
+        memcpy(&rid, this->page + this->ridBase + (begin + i) * sizeof(RID), sizeof(RID));
+    } else {
+        memcpy(&rid, this->page + this->ridOffsets[pos] + sizeof(int) + i * sizeof(RID), sizeof(RID));
+    }
+    return rid;
+}
+
+int NodeView::getKeyOffset(int pos) const {
+    return isFixedWidth(this->attrType) ? this->keyBase + pos * sizeof(int) : this->keyOffsets[pos];
+}
+
+int NodeView::getRidEnd(int pos) const {
+    int end;
+    memcpy(&end, this->page + this->ridEndOffset + pos * sizeof(int), sizeof(int));
+    return end;
+}
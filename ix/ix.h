@@ -7,6 +7,13 @@
 #include "../rbf/rbfm.h"
 
 # define IX_EOF (-1)  // end of the index scan
+#define IX_FILL_FACTOR 0.9  // Share of each page filled by bulkLoad
+
+// A key and the rid of the record it comes from
+struct IndexEntry {
+    AttrValue key;
+    RID rid;
+};
 
 class Node;
 
@@ -25,8 +32,8 @@ public:
     // Delete an index file.
     RC destroyFile(const std::string &fileName);
 
-    // Open an index and return an ixFileHandle.
-    RC openFile(const std::string &fileName, IXFileHandle &ixFileHandle);
+    // Open an index and return an ixFileHandle. READ_ONLY_MMAP serves scans straight from a mapping.
+    RC openFile(const std::string &fileName, IXFileHandle &ixFileHandle, FileMode fileMode = READ_WRITE);
 
     // Close an ixFileHandle for an index.
     RC closeFile(IXFileHandle &ixFileHandle);
@@ -34,9 +41,34 @@ public:
     // Insert an entry into the given index that is indicated by the given ixFileHandle.
     RC insertEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid);
 
+    // Insert entries sorted by key. The ones that fall into the same leaf go in with a single descent,
+    // only an entry whose leaf has to split takes the way of insertEntry.
+    RC insertEntries(IXFileHandle &ixFileHandle, const Attribute &attribute, const vector<IndexEntry> &entries);
+
+    // Build the tree of an empty index bottom-up, from entries sorted by key (ties in any order).
+    // Nodes are packed up to fillFactor of a page, leaving room for later inserts.
+    RC bulkLoad(IXFileHandle &ixFileHandle, const Attribute &attribute, const vector<IndexEntry> &entries,
+                float fillFactor = IX_FILL_FACTOR);
+
+    // VarChar leaves store the prefix their keys share once, and inner nodes get the shortest separator
+    // between two leaves instead of a full key. On by default, indexes written either way stay readable.
+    void setKeyCompression(bool enabled);
+
+    // Shortest key k with left < k <= right, right itself unless compressing VarChar keys
+    AttrValue getSeparator(const AttrValue &left, const AttrValue &right) const;
+
     RC split(IXFileHandle &ixFileHandle, vector<Node *> &route);
 
-    RC routeToLeaf(IXFileHandle &ixFileHandle, vector<Node *> &route, Node *root, AttrValue &attrValue);
+    // Nodes down to the leaf of attrValue, latched exclusively. When inserting, the route starts at the
+    // lowest node a split cannot go past, the ones above it are not kept.
+    RC routeToLeaf(IXFileHandle &ixFileHandle, const Attribute &attribute, const AttrValue &attrValue,
+                   vector<Node *> &route, bool inserting);
+
+    // Pages from the root down to the leaf attrValue belongs to, read in place without building nodes.
+    // Only the leaf stays latched, exclusively if asked to. upperFence gets the smallest key that goes
+    // right of the leaf, it is left empty (length 0) for the last leaf.
+    RC locateLeaf(IXFileHandle &ixFileHandle, AttrType attrType, const AttrValue &attrValue, vector<int> &path,
+                  bool exclusive = false, AttrValue *upperFence = nullptr);
 
     // Delete an entry from the given index that is indicated by the given ixFileHandle.
     RC deleteEntry(IXFileHandle &ixFileHandle, const Attribute &attribute, const void *key, const RID &rid);
@@ -47,6 +79,11 @@ public:
 
     RC borrow(IXFileHandle &ixFileHandle, Node *node, Node *sibNode, Node *parent, int &pos, int &siblingType);
 
+    void latchSibling(IXFileHandle &ixFileHandle, Node *node, int sibPageNum, int siblingType);
+
+    // Mark a page merged out of the tree, so that scans paused on it look for their place again
+    RC freePage(IXFileHandle &ixFileHandle, int pageNum);
+
     // Initialize and IX_ScanIterator to support a range search
     RC scan(IXFileHandle &ixFileHandle,
             const Attribute &attribute,
@@ -67,6 +104,72 @@ protected:
     IndexManager(const IndexManager &) = default;                               // Prevent construction by copying
     IndexManager &operator=(const IndexManager &) = default;                    // Prevent assignment
     PagedFileManager  *pfm;
+    bool keyCompression = true;                                                 // See setKeyCompression
+
+    friend class Node;
+};
+
+// Length of the common prefix of two strings, at most limit
+int getCommonPrefix(const string &left, const string &right, int limit);
+
+typedef enum {
+    Root = 0, Intermediate, Leaf, SingleRoot, Free
+} NodeType;
+
+// Int and real keys take 4 bytes. Their leaves keep the keys, the end of each key's rids and the rids
+// in three arrays: [header][nKeys][key 0..n-1][rid end 0..n-1][rids][overflow page]
+bool isFixedWidth(AttrType attrType);
+
+// Read-only view of a node page. Keys are found through an offset array and compared in the page bytes,
+// so a lookup or a scan copies nothing. The page has to stay pinned while the view is used.
+class NodeView {
+public:
+    NodeType nodeType;
+    int previous;
+    int next;
+    int nKeys;
+    int overflowPage;
+
+    NodeView() = default;
+
+    NodeView(AttrType type);
+
+    void load(const void *page);
+
+    // First key greater than attrValue, nKeys if none, like Node::locateChildPos with LT_OP
+    int upperBound(const AttrValue &attrValue) const;
+
+    // First key not less than attrValue, nKeys if none
+    int lowerBound(const AttrValue &attrValue) const;
+
+    // Negative, zero or positive as key pos is less than, equal to or greater than attrValue
+    int compareKey(int pos, const AttrValue &attrValue) const;
+
+    // Copy key pos in the format of insertEntry
+    void copyKey(int pos, void *key) const;
+
+    int getChild(int pos) const;
+
+    int getRidCount(int pos) const;
+
+    RID getRid(int pos, int i) const;
+
+private:
+    int getKeyOffset(int pos) const;
+
+    // Fixed-width leaves: index in the rid array past the last rid of key pos
+    int getRidEnd(int pos) const;
+
+    AttrType attrType;
+    const char *page;
+    int keyBase;                // Offset of the first key
+    int prefixLength;           // VarChar leaves: length of the prefix all keys share
+    int prefixOffset;           // VarChar leaves: offset of that prefix
+    vector<int> keyOffsets;     // VarChar: nKeys + 1 entries, the last one is the end of the keys
+    vector<int> ridOffsets;     // VarChar leaves: offset of the rid count of each key
+    int ridEndOffset;           // Fixed-width leaves: offset of the rid end array
+    int ridBase;                // Fixed-width leaves: offset of the rid array
+    int childOffset;            // Inner nodes: offset of the first child
 };
 
 class IX_ScanIterator {
@@ -75,25 +178,26 @@ public:
     // Constructor
     IX_ScanIterator();
 
-    // Destructor
-    ~IX_ScanIterator() = default;
+    // Destructor, releases the pinned leaf as close() does
+    ~IX_ScanIterator();
 
     // Get next matching entry
     RC getNextEntry(RID &rid, void *key);
 
-    // Traverse to leaf node
-    int reachLeaf();
+    // Traverse to the leaf of attrValue, the first one for an empty value, and keep it pinned and latched
+    void reachLeaf(const AttrValue &attrValue);
 
     // Terminate index scan
     RC close();
 
-    int pageNum;
-    int curK;
+    int pageNum;    // Leaf of the last entry returned, -1 before the first one
+    void *page;     // Pinned frame of pageNum until the scan ends or is closed
+    int curK;       // Key and rid positions of the last entry returned
     int curR;
-    int prevP;
-    int prevK;
-    int prevR;
-    RID prevRid;
+    RID prevRid;    // The last entry returned, to notice that it has been deleted since
+    unsigned long long pageVersion; // Of the leaf when the last entry was returned
+    AttrValue lastKey;
+    bool resuming;  // The position after lastKey and prevRid is still to be found
 
     AttrValue lowKey;
     AttrValue highKey;
@@ -101,8 +205,22 @@ public:
     bool highKeyInclusive;
 
     IXFileHandle *ixFileHandle;
-    Node *node = nullptr;
     AttrType attrType;
+    NodeView view;
+    vector<RID> overflowRids;   // Rids of the first key of the leaf kept in overflow pages
+
+    // Point the view at the pinned leaf, and collect the rids its first key keeps in overflow pages
+    void loadLeaf();
+
+    int getRidCount(int k);
+
+    RID getRid(int k, int r);
+
+    // Rid position to go on from in key k, which is lastKey
+    int getResumePosition(int k);
+
+    // Unpin and unlatch the leaf at the end of the scan
+    void release();
 };
 
 class IXFileHandle {
@@ -124,11 +242,15 @@ public:
     // Put the current counter values of associated PF FileHandles into variables
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);
 
-};
+    // Latch a page for the operation in progress, unlatchAll() lets go of whatever it still holds
+    RC latchPage(int pageNum, bool exclusive);
 
-typedef enum {
-    Root = 0, Intermediate, Leaf, SingleRoot
-} NodeType;
+    RC unlatchPage(int pageNum);
+
+    void unlatchAll();
+
+    vector<int> latchedPages;   // Latched by the operation in progress
+};
 
 class Node {
 public :
@@ -153,7 +275,8 @@ public :
 
     RC deserializeOverflowPage(IXFileHandle &ixFileHandle, int nodePageNum);
 
-    int locateChildPos(AttrValue &attrValue, CompOp compOp);
+    // LT_OP: first key greater than attrValue (keys.size() if none), EQ_OP: the key equal to it or -1
+    int locateChildPos(const AttrValue &attrValue, CompOp compOp);
 
     bool checkKeyExist(const int &pos, const AttrValue &attrValue);
 
@@ -170,12 +293,33 @@ public :
 
     int getHeaderSize();
 
+    // VarChar leaves write their keys as one shared prefix followed by the suffixes
+    bool hasKeyPrefix();
+
+    int getPrefixLength();
+
+    int serializeKeys(void *page, int offset);
+
+    int getKeysSize();
+
+    // Bytes the keys grow by when attrValue joins them, its length unless the leaf shares a prefix
+    int getKeyGrowth(const AttrValue &attrValue);
+
+    // Size of this node with the keys of sibling merged in
+    int getMergedSize(Node *sibling);
+
+    // Whether one more entry for attrValue, in this node or pushed up by a child split, cannot split it
+    bool fitsEntry(const Attribute &attribute, const AttrValue &attrValue);
+
     RC writeNode(IXFileHandle &ixFileHandle);
     int deleteRecord(int pos, const RID &rid);
 
     RC printNodeKeys();
 
     RC printNodePointers(int indent);
+
+    // Take a free page at the end of the file for this node
+    RC allocatePage(IXFileHandle &ixFileHandle);
 };
 
 #endif
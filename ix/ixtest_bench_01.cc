@@ -0,0 +1,146 @@
+#include <chrono>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+// The search locateChildPos did before, one copying comparison per key
+int linearChildPos(Node &node, AttrValue attrValue, CompOp compOp) {
+    int i;
+    for (i = 0; i < node.keys.size(); i++) {
+        if (AttrValue::compAttr(AttrValue(attrValue), AttrValue(node.keys[i]), compOp)) {
+            return i;
+        }
+    }
+    return compOp == EQ_OP ? -1 : i;
+}
+
+// Nanoseconds per search over the keys of one node, -1 if a result differs from the linear search
+double timeNodeSearch(Node &node, bool binary, CompOp compOp, int numOfSearches) {
+    int maxKey = node.keys.back().itg + 2;
+    int minKey = node.keys.front().itg - 1;
+    volatile int sink = 0;  // Keeps the searches from being optimized away
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numOfSearches; i++) {
+        AttrValue attrValue(minKey + i % (maxKey - minKey));
+        int pos = binary ? node.locateChildPos(attrValue, compOp) : linearChildPos(node, attrValue, compOp);
+        sink = pos;
+        if (binary && i % 97 == 0 && pos != linearChildPos(node, attrValue, compOp)) {
+            return -1;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    // The last position has to be one of the node's
+    if (sink < -1 || sink > (int) node.keys.size()) {
+        return -1;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / numOfSearches;
+}
+
+int testCase_bench_1(const std::string &indexFileName, const Attribute &attribute) {
+    // Functions tested
+    // 1. Point lookups through scan on a tree of 200k keys **
+    // 2. Binary and linear search inside a full leaf return the same positions **
+    // 3. Binary search is faster than the linear one it replaces
+    std::cerr << std::endl << "***** In IX Test Bench Case 01 *****" << std::endl;
+
+    int numOfKeys = 200000;
+    int numOfLookups = 20000;
+    int numOfSearches = 200000;
+    IXFileHandle ixFileHandle;
+    IX_ScanIterator ix_ScanIterator;
+
+    std::vector<IndexEntry> entries;
+    IndexEntry entry;
+    for (int i = 0; i < numOfKeys; i++) {
+        entry.key = AttrValue(i);
+        entry.rid.pageNum = i;
+        entry.rid.slotNum = i % 100;
+        entries.push_back(entry);
+    }
+    RC rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(indexFileName, ixFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager.bulkLoad(ixFileHandle, attribute, entries);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+
+    srand(222);
+    RID rid;
+    int key;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numOfLookups; i++) {
+        int lookup = rand() % numOfKeys;
+        rc = indexManager.scan(ixFileHandle, attribute, &lookup, &lookup, true, true, ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        int count = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+            count++;
+        }
+        ix_ScanIterator.close();
+        if (count != 1 || key != lookup || (int) rid.pageNum != lookup) {
+            std::cerr << "Lookup of " << lookup << " returned " << count << " entries... The test failed"
+                      << std::endl;
+            indexManager.closeFile(ixFileHandle);
+            return fail;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::cerr << "Point lookup: " << std::chrono::duration<double, std::micro>(end - start).count() / numOfLookups
+              << " us" << std::endl;
+
+    // Descend to the leftmost leaf, it is filled like every other one
+    void *page;
+    int pageNum = 0;
+    ixFileHandle.fileHandle.pinPage(pageNum, page);
+    Node *node = new Node(ixFileHandle, attribute.type, page);
+    ixFileHandle.fileHandle.unpinPage(pageNum, false);
+    while (node->nodeType != Leaf && node->nodeType != SingleRoot) {
+        pageNum = node->children[0];
+        delete node;
+        ixFileHandle.fileHandle.pinPage(pageNum, page);
+        node = new Node(ixFileHandle, attribute.type, page);
+        ixFileHandle.fileHandle.unpinPage(pageNum, false);
+    }
+    int result = success;
+    CompOp compOps[] = {LT_OP, EQ_OP};
+    for (CompOp compOp : compOps) {
+        double linear = timeNodeSearch(*node, false, compOp, numOfSearches);
+        double binary = timeNodeSearch(*node, true, compOp, numOfSearches);
+        std::cerr << (compOp == LT_OP ? "LT_OP" : "EQ_OP") << " search in a leaf of " << node->keys.size()
+                  << " keys: linear " << linear << " ns, binary " << binary << " ns" << std::endl;
+        if (binary < 0) {
+            std::cerr << "Binary search returned another position... The test failed" << std::endl;
+            result = fail;
+        } else if (binary >= linear) {
+            std::cerr << "Binary search should be faster... The test failed" << std::endl;
+            result = fail;
+        }
+    }
+    delete node;
+
+    rc = indexManager.closeFile(ixFileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager.destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return result;
+}
+
+int main() {
+
+    const std::string indexFileName = "bench_age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    indexManager.destroyFile(indexFileName);
+
+    if (testCase_bench_1(indexFileName, attrAge) == success) {
+        std::cerr << "IX_Test Bench Case 01 finished. The result will be examined." << std::endl;
+        return success;
+    } else {
+        std::cerr << "IX_Test Bench Case 01 failed." << std::endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,164 @@
+#include "ix.h"
+#include "ix_test_util.h"
+
+// Number of entries a scan over [lowKey, highKey] returns, -1 if they come out of order
+int countEntries(IXFileHandle &ixFileHandle, const Attribute &attribute, int lowKey, int highKey) {
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager.scan(ixFileHandle, attribute, &lowKey, &highKey, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    int key;
+    int lastKey = lowKey;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        if (key < lastKey || key > highKey || (int) rid.slotNum != key) {
+            count = -1;
+            break;
+        }
+        lastKey = key;
+        count++;
+    }
+    ix_ScanIterator.close();
+    return count;
+}
+
+int testCase_bulk_1(const std::string &indexFileName, const std::string &insertedFileName,
+                    const Attribute &attribute) {
+    // Functions tested
+    // 1. Bulk load sorted entries with duplicates, one key spanning overflow pages **
+    // 2. Scan the whole index and a range of it **
+    // 3. The bulk loaded index takes fewer pages than one built with insertEntry
+    // 4. insertEntry and deleteEntry keep working on the bulk loaded tree
+    // 5. Unsorted entries and non-empty indexes are refused
+    std::cerr << std::endl << "***** In IX Test Bulk Case 01 *****" << std::endl;
+
+    unsigned numOfKeys = 20000;
+    unsigned numOfDuplicates = 3000;
+    int heavyKey = 5000;
+    IXFileHandle ixFileHandle;
+    IXFileHandle insertedFileHandle;
+
+    // Two rids per key, and many more for heavyKey
+    std::vector<IndexEntry> entries;
+    IndexEntry entry;
+    for (unsigned i = 0; i < numOfKeys; i++) {
+        unsigned copies = (int) i == heavyKey ? numOfDuplicates : 2;
+        for (unsigned j = 0; j < copies; j++) {
+            entry.key = AttrValue((int) i);
+            entry.rid.pageNum = j;
+            entry.rid.slotNum = i;
+            entries.push_back(entry);
+        }
+    }
+    int numOfEntries = entries.size();
+
+    RC rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(indexFileName, ixFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager.bulkLoad(ixFileHandle, attribute, entries);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    rc = indexManager.bulkLoad(ixFileHandle, attribute, entries);
+    assert(rc != success && "indexManager::bulkLoad() should fail on a non-empty index.");
+
+    int count = countEntries(ixFileHandle, attribute, 0, numOfKeys);
+    std::cerr << "Number of scanned entries: " << count << std::endl;
+    if (count != numOfEntries) {
+        std::cerr << "Wrong entries output... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+    count = countEntries(ixFileHandle, attribute, heavyKey - 10, heavyKey + 10);
+    if (count != 20 * 2 + (int) numOfDuplicates) {
+        std::cerr << "Wrong range scan output: " << count << " entries... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+
+    // Two rids per key through insertEntry, in random order, and through bulkLoad
+    entries.erase(entries.begin() + heavyKey * 2 + 2, entries.begin() + heavyKey * 2 + numOfDuplicates);
+    rc = indexManager.createFile(insertedFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(insertedFileName, insertedFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    std::vector<IndexEntry> shuffled = entries;
+    srand(12);
+    for (int i = entries.size() - 1; i > 0; i--) {
+        std::swap(shuffled[i], shuffled[rand() % (i + 1)]);
+    }
+    rc = indexManager.bulkLoad(insertedFileHandle, attribute, shuffled);
+    assert(rc != success && "indexManager::bulkLoad() should fail on unsorted entries.");
+    for (int i = 0; i < shuffled.size(); i++) {
+        rc = indexManager.insertEntry(insertedFileHandle, attribute, &shuffled[i].key.itg, shuffled[i].rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    unsigned insertedPages = insertedFileHandle.fileHandle.getNumberOfPages();
+    indexManager.closeFile(insertedFileHandle);
+    indexManager.destroyFile(insertedFileName);
+    rc = indexManager.createFile(insertedFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(insertedFileName, insertedFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager.bulkLoad(insertedFileHandle, attribute, entries);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    unsigned bulkPages = insertedFileHandle.fileHandle.getNumberOfPages();
+    count = countEntries(insertedFileHandle, attribute, 0, numOfKeys);
+    indexManager.closeFile(insertedFileHandle);
+    indexManager.destroyFile(insertedFileName);
+    std::cerr << "Pages: " << bulkPages << " bulk loaded, " << insertedPages << " with insertEntry" << std::endl;
+    if (count != (int) entries.size() || bulkPages >= insertedPages) {
+        std::cerr << "Bulk loading should pack the pages... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+
+    // Grow and shrink the bulk loaded tree
+    RID rid;
+    for (int key = numOfKeys; key < (int) numOfKeys + 5000; key++) {
+        rid.pageNum = 0;
+        rid.slotNum = key;
+        rc = indexManager.insertEntry(ixFileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    for (int key = 0; key < 1000; key++) {
+        rid.pageNum = 1;
+        rid.slotNum = key;
+        rc = indexManager.deleteEntry(ixFileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    count = countEntries(ixFileHandle, attribute, 0, numOfKeys + 5000);
+    std::cerr << "Number of scanned entries after updates: " << count << std::endl;
+    if (count != numOfEntries + 5000 - 1000) {
+        std::cerr << "Wrong entries output... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+
+    rc = indexManager.closeFile(ixFileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager.destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main() {
+
+    const std::string indexFileName = "bulk_age_idx";
+    const std::string insertedFileName = "bulk_inserted_age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    indexManager.destroyFile(indexFileName);
+    indexManager.destroyFile(insertedFileName);
+
+    if (testCase_bulk_1(indexFileName, insertedFileName, attrAge) == success) {
+        std::cerr << "IX_Test Bulk Case 01 finished. The result will be examined." << std::endl;
+        return success;
+    } else {
+        std::cerr << "IX_Test Bulk Case 01 failed." << std::endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,199 @@
+#include "ix.h"
+#include "ix_test_util.h"
+
+std::string makeEmail(int i) {
+    char email[32];
+    sprintf(email, "user%07d@example.com", i);
+    return std::string(email);
+}
+
+void prepareVarCharKey(const std::string &value, void *key) {
+    int len = value.size();
+    memcpy(key, &len, sizeof(int));
+    memcpy((char *) key + sizeof(int), value.data(), len);
+}
+
+// Levels from the root down to the leaves
+int getTreeHeight(IXFileHandle &ixFileHandle, const Attribute &attribute) {
+    void *page;
+    int pageNum = 0;
+    int height = 1;
+    ixFileHandle.fileHandle.pinPage(pageNum, page);
+    Node *node = new Node(ixFileHandle, attribute.type, page);
+    ixFileHandle.fileHandle.unpinPage(pageNum, false);
+    while (node->nodeType != Leaf && node->nodeType != SingleRoot) {
+        pageNum = node->children[0];
+        delete node;
+        ixFileHandle.fileHandle.pinPage(pageNum, page);
+        node = new Node(ixFileHandle, attribute.type, page);
+        ixFileHandle.fileHandle.unpinPage(pageNum, false);
+        height++;
+    }
+    delete node;
+    return height;
+}
+
+// Number of entries a scan over [low, high] returns, -1 if a key is out of order or does not match its rid
+int countEntries(IXFileHandle &ixFileHandle, const Attribute &attribute, const std::string &low,
+                 const std::string &high) {
+    IX_ScanIterator ix_ScanIterator;
+    char lowKey[PAGE_SIZE];
+    char highKey[PAGE_SIZE];
+    char key[PAGE_SIZE];
+    prepareVarCharKey(low, lowKey);
+    prepareVarCharKey(high, highKey);
+    RC rc = indexManager.scan(ixFileHandle, attribute, lowKey, highKey, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    std::string lastKey = low;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, key) == success) {
+        int len;
+        memcpy(&len, key, sizeof(int));
+        std::string value(key + sizeof(int), len);
+        if (value < lastKey || value > high || value != makeEmail(rid.slotNum)) {
+            count = -1;
+            break;
+        }
+        lastKey = value;
+        count++;
+    }
+    ix_ScanIterator.close();
+    return count;
+}
+
+RC bulkLoadEmails(const std::string &indexFileName, const Attribute &attribute, const std::vector<IndexEntry> &entries,
+                  bool compressed, int &height, unsigned &numOfPages) {
+    IXFileHandle ixFileHandle;
+    indexManager.setKeyCompression(compressed);
+    RC rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(indexFileName, ixFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager.bulkLoad(ixFileHandle, attribute, entries);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    height = getTreeHeight(ixFileHandle, attribute);
+    numOfPages = ixFileHandle.fileHandle.getNumberOfPages();
+
+    int count = countEntries(ixFileHandle, attribute, makeEmail(0), makeEmail(entries.size()));
+    RC result = count == (int) entries.size() ? success : fail;
+    // A point lookup, and a range bounded by values shorter than the prefixes of the leaves
+    if (countEntries(ixFileHandle, attribute, makeEmail(123457), makeEmail(123457)) != 1 ||
+        countEntries(ixFileHandle, attribute, "user012", "user013") != 10000) {
+        result = fail;
+    }
+    indexManager.closeFile(ixFileHandle);
+    indexManager.destroyFile(indexFileName);
+    return result;
+}
+
+int testCase_compress_1(const std::string &indexFileName, const Attribute &attribute) {
+    // Functions tested
+    // 1. Bulk load 1M strings with and without key compression **
+    // 2. Compressed leaves and truncated separators give fewer pages and no taller tree **
+    // 3. Scans return full keys from compressed leaves
+    // 4. insertEntry and deleteEntry split and shrink compressed leaves
+    std::cerr << std::endl << "***** In IX Test Compress Case 01 *****" << std::endl;
+
+    int numOfKeys = 1000000;
+    std::vector<IndexEntry> entries;
+    IndexEntry entry;
+    for (int i = 0; i < numOfKeys; i++) {
+        entry.key = AttrValue(makeEmail(i));
+        entry.rid.pageNum = i / 100;
+        entry.rid.slotNum = i;
+        entries.push_back(entry);
+    }
+
+    int plainHeight, compressedHeight;
+    unsigned plainPages, compressedPages;
+    RC rc = bulkLoadEmails(indexFileName, attribute, entries, false, plainHeight, plainPages);
+    if (rc != success) {
+        std::cerr << "Wrong entries output without compression... The test failed" << std::endl;
+        return fail;
+    }
+    rc = bulkLoadEmails(indexFileName, attribute, entries, true, compressedHeight, compressedPages);
+    if (rc != success) {
+        std::cerr << "Wrong entries output with compression... The test failed" << std::endl;
+        return fail;
+    }
+    std::cerr << "Without compression: height " << plainHeight << ", " << plainPages << " pages" << std::endl;
+    std::cerr << "With compression:    height " << compressedHeight << ", " << compressedPages << " pages"
+              << std::endl;
+    if (compressedPages >= plainPages || compressedHeight > plainHeight) {
+        std::cerr << "Compressed keys should take fewer pages... The test failed" << std::endl;
+        return fail;
+    }
+
+    // Build a smaller index one entry at a time, in random order
+    int numOfInserted = 30000;
+    std::vector<int> order;
+    for (int i = 0; i < numOfInserted; i++) {
+        order.push_back(i);
+    }
+    srand(16);
+    for (int i = numOfInserted - 1; i > 0; i--) {
+        std::swap(order[i], order[rand() % (i + 1)]);
+    }
+    IXFileHandle ixFileHandle;
+    rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(indexFileName, ixFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    char key[PAGE_SIZE];
+    RID rid;
+    for (int i : order) {
+        prepareVarCharKey(makeEmail(i), key);
+        rid.pageNum = i / 100;
+        rid.slotNum = i;
+        rc = indexManager.insertEntry(ixFileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    int count = countEntries(ixFileHandle, attribute, makeEmail(0), makeEmail(numOfInserted));
+    std::cerr << "Number of scanned entries after inserts: " << count << std::endl;
+    if (count != numOfInserted) {
+        std::cerr << "Wrong entries output... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+    for (int i = 0; i < numOfInserted; i += 2) {
+        prepareVarCharKey(makeEmail(i), key);
+        rid.pageNum = i / 100;
+        rid.slotNum = i;
+        rc = indexManager.deleteEntry(ixFileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    count = countEntries(ixFileHandle, attribute, makeEmail(0), makeEmail(numOfInserted));
+    std::cerr << "Number of scanned entries after deletes: " << count << std::endl;
+    if (count != numOfInserted / 2) {
+        std::cerr << "Wrong entries output... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+
+    rc = indexManager.closeFile(ixFileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager.destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main() {
+
+    const std::string indexFileName = "compress_email_idx";
+    Attribute attrEmail;
+    attrEmail.length = 40;
+    attrEmail.name = "email";
+    attrEmail.type = TypeVarChar;
+
+    indexManager.destroyFile(indexFileName);
+
+    if (testCase_compress_1(indexFileName, attrEmail) == success) {
+        std::cerr << "IX_Test Compress Case 01 finished. The result will be examined." << std::endl;
+        return success;
+    } else {
+        std::cerr << "IX_Test Compress Case 01 failed." << std::endl;
+        return fail;
+    }
+
+}
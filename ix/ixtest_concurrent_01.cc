@@ -0,0 +1,214 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+const int numOfKeys = 40000;
+
+// Every thread works through its own handle on the shared index
+void insertKeys(const std::string &indexFileName, const Attribute &attribute, const std::vector<int> &keys,
+                int first, int step, std::atomic<int> &failures) {
+    IXFileHandle ixFileHandle;
+    indexManager.openFile(indexFileName, ixFileHandle);
+    RID rid;
+    for (int i = first; i < keys.size(); i += step) {
+        rid.pageNum = keys[i] / 100;
+        rid.slotNum = keys[i];
+        if (indexManager.insertEntry(ixFileHandle, attribute, &keys[i], rid) != success) {
+            failures++;
+        }
+    }
+    indexManager.closeFile(ixFileHandle);
+}
+
+// Delete the even keys among those of the thread
+void deleteKeys(const std::string &indexFileName, const Attribute &attribute, const std::vector<int> &keys,
+                int first, int step, std::atomic<int> &failures) {
+    IXFileHandle ixFileHandle;
+    indexManager.openFile(indexFileName, ixFileHandle);
+    RID rid;
+    for (int i = first; i < keys.size(); i += step) {
+        if (keys[i] % 2 != 0) {
+            continue;
+        }
+        rid.pageNum = keys[i] / 100;
+        rid.slotNum = keys[i];
+        if (indexManager.deleteEntry(ixFileHandle, attribute, &keys[i], rid) != success) {
+            failures++;
+        }
+    }
+    indexManager.closeFile(ixFileHandle);
+}
+
+// Scan the whole index until done is set. Keys must come out in order, each once, and
+// the odd keys must all be there once they have been inserted.
+void scanKeys(const std::string &indexFileName, const Attribute &attribute, bool oddKeysInserted,
+              std::atomic<bool> &done, std::atomic<int> &failures, std::atomic<int> &scans) {
+    IXFileHandle ixFileHandle;
+    indexManager.openFile(indexFileName, ixFileHandle);
+    IX_ScanIterator ix_ScanIterator;
+    RID rid;
+    int key;
+    while (!done) {
+        indexManager.scan(ixFileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+        int lastKey = -1;
+        int oddKeys = 0;
+        while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+            if (key <= lastKey || (int) rid.slotNum != key) {
+                failures++;
+                break;
+            }
+            lastKey = key;
+            oddKeys += key % 2;
+        }
+        ix_ScanIterator.close();
+        if (oddKeysInserted && oddKeys != numOfKeys / 2) {
+            failures++;
+        }
+        scans++;
+    }
+    indexManager.closeFile(ixFileHandle);
+}
+
+// Number of entries in the index, -1 if they are out of order or do not match their rids
+int countEntries(const std::string &indexFileName, const Attribute &attribute, int keyStep) {
+    IXFileHandle ixFileHandle;
+    indexManager.openFile(indexFileName, ixFileHandle);
+    IX_ScanIterator ix_ScanIterator;
+    indexManager.scan(ixFileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    RID rid;
+    int key;
+    int count = 0;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        int expected = keyStep == 1 ? count : count * 2 + 1;
+        if (key != expected || (int) rid.slotNum != key) {
+            count = -1;
+            break;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    indexManager.closeFile(ixFileHandle);
+    return count;
+}
+
+// Insert all keys, then delete the even ones, with numOfThreads threads and one more scanning along.
+// Returns the seconds each phase took, or -1 when the index came out wrong.
+double runRound(const std::string &indexFileName, const Attribute &attribute, const std::vector<int> &keys,
+                int numOfThreads, double &deleteSeconds) {
+    indexManager.destroyFile(indexFileName);
+    RC rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    std::atomic<int> failures(0);
+    std::atomic<int> scanFailures(0);
+    std::atomic<int> scans(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numOfThreads; i++) {
+        threads.emplace_back(insertKeys, std::cref(indexFileName), std::cref(attribute), std::cref(keys), i,
+                             numOfThreads, std::ref(failures));
+    }
+    std::thread scanner(scanKeys, std::cref(indexFileName), std::cref(attribute), false, std::ref(done),
+                        std::ref(scanFailures), std::ref(scans));
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    done = true;
+    scanner.join();
+    double insertSeconds = std::chrono::duration<double>(end - start).count();
+    int count = countEntries(indexFileName, attribute, 1);
+    if (failures > 0 || scanFailures > 0 || count != numOfKeys) {
+        std::cerr << numOfThreads << " threads: " << failures << " failed inserts, " << scanFailures
+                  << " bad scans, " << count << " entries after inserting" << std::endl;
+        return -1;
+    }
+
+    threads.clear();
+    done = false;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numOfThreads; i++) {
+        threads.emplace_back(deleteKeys, std::cref(indexFileName), std::cref(attribute), std::cref(keys), i,
+                             numOfThreads, std::ref(failures));
+    }
+    std::thread deleteScanner(scanKeys, std::cref(indexFileName), std::cref(attribute), true, std::ref(done),
+                              std::ref(scanFailures), std::ref(scans));
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    end = std::chrono::steady_clock::now();
+    done = true;
+    deleteScanner.join();
+    deleteSeconds = std::chrono::duration<double>(end - start).count();
+    count = countEntries(indexFileName, attribute, 2);
+    if (failures > 0 || scanFailures > 0 || count != numOfKeys / 2) {
+        std::cerr << numOfThreads << " threads: " << failures << " failed deletes, " << scanFailures
+                  << " bad scans, " << count << " entries after deleting" << std::endl;
+        return -1;
+    }
+    std::cerr << numOfThreads << " threads: " << (int) (numOfKeys / insertSeconds) << " inserts/s, "
+              << (int) (numOfKeys / 2 / deleteSeconds) << " deletes/s, " << scans << " concurrent scans"
+              << std::endl;
+    indexManager.destroyFile(indexFileName);
+    return insertSeconds;
+}
+
+int testCase_concurrent_1(const std::string &indexFileName, const Attribute &attribute) {
+    // Functions tested
+    // 1. insertEntry from several threads at once, splitting leaves and inner nodes **
+    // 2. deleteEntry from several threads at once, merging and borrowing **
+    // 3. Scans running along see every entry once, in order
+    // 4. Throughput from 1 to 8 threads
+    std::cerr << std::endl << "***** In IX Test Concurrent Case 01 *****" << std::endl;
+    std::cerr << "Hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    std::vector<int> keys;
+    for (int i = 0; i < numOfKeys; i++) {
+        keys.push_back(i);
+    }
+    srand(17);
+    for (int i = numOfKeys - 1; i > 0; i--) {
+        std::swap(keys[i], keys[rand() % (i + 1)]);
+    }
+
+    double baseInsert = 0;
+    double baseDelete = 0;
+    for (int numOfThreads = 1; numOfThreads <= 8; numOfThreads *= 2) {
+        double deleteSeconds;
+        double insertSeconds = runRound(indexFileName, attribute, keys, numOfThreads, deleteSeconds);
+        if (insertSeconds < 0) {
+            std::cerr << "Wrong entries output... The test failed" << std::endl;
+            return fail;
+        }
+        if (numOfThreads == 1) {
+            baseInsert = insertSeconds;
+            baseDelete = deleteSeconds;
+        } else {
+            std::cerr << "  speedup over 1 thread: inserts " << baseInsert / insertSeconds << "x, deletes "
+                      << baseDelete / deleteSeconds << "x" << std::endl;
+        }
+    }
+    return success;
+}
+
+int main() {
+
+    const std::string indexFileName = "concurrent_age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    if (testCase_concurrent_1(indexFileName, attrAge) == success) {
+        std::cerr << "IX_Test Concurrent Case 01 finished. The result will be examined." << std::endl;
+        return success;
+    } else {
+        std::cerr << "IX_Test Concurrent Case 01 failed." << std::endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,135 @@
+#include <chrono>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+// Every tenth key has a second rid
+int getRidCount(int key) {
+    return key % 10 == 0 ? 2 : 1;
+}
+
+int testCase_scan_1(const std::string &indexFileName, const Attribute &attribute) {
+    // Functions tested
+    // 1. A range scan over leaves nobody writes to goes on from where it stopped **
+    // 2. A scan inserting right behind itself picks its place up again on every changed leaf **
+    // 3. Time per entry of both scans
+    std::cerr << std::endl << "***** In IX Test Scan Case 01 *****" << std::endl;
+
+    int numOfKeys = 100000;
+    IXFileHandle ixFileHandle;
+    IX_ScanIterator ix_ScanIterator;
+
+    // Even keys only, the odd ones are inserted during the second scan
+    std::vector<IndexEntry> entries;
+    IndexEntry entry;
+    for (int i = 0; i < numOfKeys; i += 2) {
+        entry.key = AttrValue(i);
+        for (int j = 0; j < getRidCount(i); j++) {
+            entry.rid.pageNum = i;
+            entry.rid.slotNum = j;
+            entries.push_back(entry);
+        }
+    }
+    RC rc = indexManager.createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager.openFile(indexFileName, ixFileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager.bulkLoad(ixFileHandle, attribute, entries);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+
+    RID rid;
+    int key;
+    int count = 0;
+    int expectedKey = 0;
+    int expectedSlot = 0;
+    auto start = std::chrono::steady_clock::now();
+    rc = indexManager.scan(ixFileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        if (key != expectedKey || (int) rid.pageNum != key || (int) rid.slotNum != expectedSlot) {
+            std::cerr << "Expected " << expectedKey << " but got " << key << "... The test failed" << std::endl;
+            ix_ScanIterator.close();
+            indexManager.closeFile(ixFileHandle);
+            return fail;
+        }
+        if (++expectedSlot == getRidCount(key)) {
+            expectedKey += 2;
+            expectedSlot = 0;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    auto end = std::chrono::steady_clock::now();
+    double readOnly = std::chrono::duration<double, std::nano>(end - start).count() / count;
+    if (count != entries.size()) {
+        std::cerr << "Scanned " << count << " of " << entries.size() << " entries... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+
+    // Put key + 1 into the index after each key, so the leaf is written before the next call. The
+    // scan has to find its place again and then return the key it just inserted.
+    count = 0;
+    expectedKey = 0;
+    expectedSlot = 0;
+    start = std::chrono::steady_clock::now();
+    rc = indexManager.scan(ixFileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success) {
+        if (key != expectedKey || (int) rid.pageNum != key || (int) rid.slotNum != expectedSlot) {
+            std::cerr << "Expected " << expectedKey << " but got " << key << "... The test failed" << std::endl;
+            ix_ScanIterator.close();
+            indexManager.closeFile(ixFileHandle);
+            return fail;
+        }
+        if (++expectedSlot == getRidCount(key)) {
+            expectedKey++;
+            expectedSlot = 0;
+            if (key % 2 == 0) {
+                int odd = key + 1;
+                RID oddRid;
+                oddRid.pageNum = odd;
+                oddRid.slotNum = 0;
+                rc = indexManager.insertEntry(ixFileHandle, attribute, &odd, oddRid);
+                assert(rc == success && "indexManager::insertEntry() should not fail.");
+            }
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    end = std::chrono::steady_clock::now();
+    double modifying = std::chrono::duration<double, std::nano>(end - start).count() / count;
+    if (expectedKey != numOfKeys) {
+        std::cerr << "Scan stopped before " << expectedKey << "... The test failed" << std::endl;
+        indexManager.closeFile(ixFileHandle);
+        return fail;
+    }
+    std::cerr << "Read-only scan: " << readOnly << " ns per entry" << std::endl;
+    std::cerr << "Scan inserting along: " << modifying << " ns per entry, inserts included" << std::endl;
+
+    rc = indexManager.closeFile(ixFileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager.destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main() {
+
+    const std::string indexFileName = "scan_age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    indexManager.destroyFile(indexFileName);
+
+    if (testCase_scan_1(indexFileName, attrAge) == success) {
+        std::cerr << "IX_Test Scan Case 01 finished. The result will be examined." << std::endl;
+        return success;
+    } else {
+        std::cerr << "IX_Test Scan Case 01 failed." << std::endl;
+        return fail;
+    }
+
+}
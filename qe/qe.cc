@@ -1,6 +1,155 @@
 
 #include "qe.h"
 
+void Batch::reset(const std::vector<Attribute> &attrs) {
+    this->columns.resize(attrs.size());
+    for (int i = 0; i < attrs.size(); i++) {
+        this->columns[i].attr = attrs[i];
+        this->columns[i].values.clear();
+        this->columns[i].offsets.clear();
+    }
+    this->rowCount = 0;
+    this->selection.clear();
+}
+
+void Batch::appendFields(const void *data, int firstColumn, int fieldCount) {
+    int nullFlagSize = ceil((double) fieldCount / CHAR_BIT);
+    auto *nullFlags = (const unsigned char *) data;
+    const char *value = (const char *) data + nullFlagSize;
+    for (int i = 0; i < fieldCount; i++) {
+        Column &column = this->columns[firstColumn + i];
+        if (nullFlags[i / CHAR_BIT] & (1 << (7 - i % CHAR_BIT))) {
+            column.offsets.push_back(-1);
+            continue;
+        }
+        int size = sizeof(int);
+        if (column.attr.type == TypeVarChar) {
+            int length;
+            memcpy(&length, value, sizeof(int));
+            size += length;
+        }
+        column.offsets.push_back(column.values.size());
+        column.values.insert(column.values.end(), value, value + size);
+        value += size;
+    }
+}
+
+int Batch::getTuple(int row, void *data) const {
+    int nullFlagSize = ceil((double) this->columns.size() / CHAR_BIT);
+    auto *nullFlags = (unsigned char *) data;
+    memset(nullFlags, 0, nullFlagSize);
+    int offset = nullFlagSize;
+    for (int i = 0; i < this->columns.size(); i++) {
+        const char *value = this->getValue(i, row);
+        if (value == nullptr) {
+            nullFlags[i / CHAR_BIT] |= 1 << (7 - i % CHAR_BIT);
+            continue;
+        }
+        int size = sizeof(int);
+        if (this->columns[i].attr.type == TypeVarChar) {
+            int length;
+            memcpy(&length, value, sizeof(int));
+            size += length;
+        }
+        memcpy((char *) data + offset, value, size);
+        offset += size;
+    }
+    return offset;
+}
+
+RC Iterator::getNextBatch(Batch &batch) {
+    std::vector<Attribute> attrs;
+    this->getAttributes(attrs);
+    batch.reset(attrs);
+    batch.tuple.resize(max(getMaxTupleSize(attrs), PAGE_SIZE));
+    RC rc = 0;
+    while (batch.rowCount < QE_BATCH_SIZE && (rc = this->getNextTuple(batch.tuple.data())) == 0) {
+        batch.appendTuple(batch.tuple.data());
+    }
+    // An error after some tuples is left for the next call
+    return batch.rowCount == 0 ? rc : 0;
+}
+
+// Fill a batch from the matches of a join, the fields of both tuples go straight into the columns
+// without putting the joined tuple together first
+template<class Join>
+RC getNextJoinBatch(Join *join, Batch &batch) {
+    std::vector<Attribute> attrs;
+    join->getAttributes(attrs);
+    batch.reset(attrs);
+    const void *left, *right;
+    RC rc = 0;
+    while (batch.rowCount < QE_BATCH_SIZE && (rc = join->getNextMatch(left, right)) == 0) {
+        batch.appendFields(left, 0, join->leftAttrs.size());
+        batch.appendFields(right, join->leftAttrs.size(), join->rightAttrs.size());
+        batch.endRow();
+    }
+    if (batch.rowCount > 0) {
+        return 0;
+    }
+    return rc == 0 ? QE_EOF : rc;
+}
+
+RC TableScan::getNextBatch(Batch &batch) {
+    if (this->batchAttrs.empty()) {
+        this->getAttributes(this->batchAttrs);
+    }
+    batch.reset(this->batchAttrs);
+    this->batchColumns.clear();
+    for (Batch::Column &column : batch.columns) {
+        this->batchColumns.push_back(&column);
+    }
+    int count;
+    RC rc = this->iter->getNextTuples(QE_BATCH_SIZE, this->batchColumns, count);
+    if (rc != 0) {
+        return rc;
+    }
+    for (int i = 0; i < count; i++) {
+        batch.endRow();
+    }
+    return 0;
+}
+
+RC IndexScan::fetchBatch() {
+    this->batchRids.clear();
+    this->batchPos = 0;
+    RID entryRid;
+    while (this->batchRids.size() < this->batchSize && this->iter->getNextEntry(entryRid, this->key) == 0) {
+        this->batchRids.push_back(entryRid);
+    }
+    if (this->batchRids.empty()) {
+        return QE_EOF;
+    }
+    std::vector<void *> tuples;
+    for (size_t i = 0; i < this->batchRids.size(); i++) {
+        tuples.push_back(this->batchTuples + i * this->tupleSize);
+    }
+    RC rc = this->readTuples(this->batchRids, tuples, this->batchFound);
+    if (rc != 0) {
+        this->batchRids.clear();
+    }
+    return rc;
+}
+
+RC IndexScan::getNextTuple(void *data) {
+    // Entries left behind by deleted tuples are passed over
+    while (this->batchPos == this->batchRids.size() || !this->batchFound[this->batchPos]) {
+        if (this->batchPos < this->batchRids.size()) {
+            this->batchPos++;
+            continue;
+        }
+        RC rc = this->fetchBatch();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    this->rid = this->batchRids[this->batchPos];
+    char *tuple = this->batchTuples + this->batchPos * this->tupleSize;
+    memcpy(data, tuple, getTupleSize(this->attrs, tuple));
+    this->batchPos++;
+    return 0;
+}
+
 Filter::Filter(Iterator *input, const Condition &condition) {
     this->input = input;
     this->condition = condition;
@@ -11,25 +160,82 @@ Filter::Filter(Iterator *input, const Condition &condition) {
         string attrName = this->attrs[i].name.substr(pos + 1, this->attrs[i].name.length() - pos + 1);
         this->attrs[i].name = attrName;
     }
+
+    int pos = condition.lhsAttr.find('.');
+    string lhsAttrName = condition.lhsAttr.substr(pos + 1);
+    this->lhsPlan = AttrPlan(this->attrs, lhsAttrName);
+
+    // An attribute compared with a constant is left to the input when it can drop the tuples itself
+    this->pushedDown = false;
+    if (!condition.bRhsIsAttr) {
+        this->pushedDown = input->pushCondition(lhsAttrName, condition.op, condition.rhsValue);
+    }
+}
+
+bool Filter::pushCondition(const std::string &attrName, CompOp op, const Value &value) {
+    return this->input->pushCondition(attrName, op, value);
+}
+
+bool Filter::pushProjection(const std::vector<std::string> &attrNames) {
+    if (!this->pushedDown || !this->input->pushProjection(attrNames)) {
+        return false;
+    }
+    this->input->getAttributes(this->attrs);
+    for (Attribute &attr : this->attrs) {
+        excludeTableName(attr.name);
+    }
+    this->lhsPlan = AttrPlan(this->attrs, this->condition.lhsAttr);
+    return true;
 }
 
 RC Filter::getNextTuple(void *data) {
-    while (input->getNextTuple(data) != RM_EOF) {
-        void *filterValue = malloc(PAGE_SIZE);
-        int pos = getAttrValue(this->attrs, this->condition.lhsAttr, filterValue, data);
-        if (pos == -1) {
-            // Invalid tuple
-            return -1;
-        }
-        bool satisfied = compare(filterValue, condition.rhsValue);
+    if (this->pushedDown) {
+        return this->input->getNextTuple(data);
+    }
+    RC rc;
+    while ((rc = input->getNextTuple(data)) == 0) {
+        const char *value = this->lhsPlan.locate(data);
+        if (value == nullptr) {
+            if (this->lhsPlan.index == -1) {
+                // Invalid tuple
+                return -1;
+            }
+            // A null satisfies no comparison
+            continue;
+        }
+        bool satisfied = compare(value, condition.rhsValue);
         if (satisfied) {
             return 0;
         }
     }
-    return RM_EOF;
+    return rc;
+}
+
+RC Filter::getNextBatch(Batch &batch) {
+    if (this->pushedDown) {
+        return this->input->getNextBatch(batch);
+    }
+    if (this->lhsPlan.index == -1) {
+        return -1;
+    }
+    do {
+        RC rc = this->input->getNextBatch(batch);
+        if (rc != 0) {
+            return rc;
+        }
+        int kept = 0;
+        for (int row : batch.selection) {
+            const char *value = batch.getValue(this->lhsPlan.index, row);
+            if (value != nullptr && this->compare(value, this->condition.rhsValue)) {
+                batch.selection[kept++] = row;
+            }
+        }
+        batch.selection.resize(kept);
+    } while (batch.selection.empty());
+    return 0;
 }
 
-bool Filter::compare(void *filterValue, Value rhsValue) {
+bool Filter::compare(const void *filterValue, const Value &rhsValue) {
     bool satisfied = false;
     Attribute attr;
     attr.type = this->condition.rhsValue.type;
@@ -92,43 +298,74 @@ void Filter::getAttributes(std::vector<Attribute> &attrs) const {
     }
 }
 
-int getAttrValue(vector<Attribute> attrs, string attrName, void *filterValue, void *data) {
-    int index = -1;
-    int nullIndicatorSize = ceil((double) attrs.size() / CHAR_BIT);
-    int offset = nullIndicatorSize;
-    char *nullIndicator = (char *) malloc(nullIndicatorSize);
-    memcpy(nullIndicator, data, nullIndicatorSize);
-    int pos = attrName.find('.');
-    string lhsAttrName = attrName.substr(pos + 1, attrName.length() - pos + 1);
-    int i;
-    for (i = 0; i < attrs.size(); i++) {
-        bool isNull = nullIndicator[i / CHAR_BIT] & (1 << (7 - i % CHAR_BIT));
-        if (isNull) {
-            continue;
+AttrPlan::AttrPlan(const vector<Attribute> &attrs, const string &attrName) {
+    string name = attrName;
+    excludeTableName(name);
+    this->nullFlagSize = ceil((double) attrs.size() / CHAR_BIT);
+    this->fixedOffset = true;
+    this->offset = this->nullFlagSize;
+    for (int i = 0; i < attrs.size(); i++) {
+        string candidate = attrs[i].name;
+        excludeTableName(candidate);
+        if (candidate == name) {
+            this->index = i;
+            this->attr = attrs[i];
+            return;
         }
-        if (lhsAttrName == attrs[i].name) {
-            index = i;
-            if (attrs[i].type == TypeInt || attrs[i].type == TypeReal) {
-                memcpy(filterValue, (char *) data + offset, sizeof(int));
-            } else {
-                int localLength;
-                memcpy(&localLength, (char *) data + offset, sizeof(int));
-                offset += sizeof(int);
-                memcpy(filterValue, &localLength, sizeof(int));
-                memcpy((char *) filterValue + sizeof(int), (char *) data + offset, localLength);
-            }
-            return index;
-        } else {
-            if (attrs[i].type == TypeInt || attrs[i].type == TypeReal) {
-                offset += sizeof(int);
-            } else {
-                int length;
-                memcpy(&length, (char *) data + offset, sizeof(int));
-                offset += sizeof(int) + length;
+        this->varChars.push_back(attrs[i].type == TypeVarChar);
+        if (attrs[i].type == TypeVarChar) {
+            this->fixedOffset = false;
+        }
+        this->offset += sizeof(int);
+    }
+}
+
+const char *AttrPlan::locate(const void *tuple) const {
+    if (this->index == -1) {
+        return nullptr;
+    }
+    auto *nullFlags = (const unsigned char *) tuple;
+    if (nullFlags[this->index / CHAR_BIT] & (1 << (7 - this->index % CHAR_BIT))) {
+        return nullptr;
+    }
+    int offset = this->offset;
+    if (this->fixedOffset) {
+        // Each null field in front moves the value by an int
+        for (int i = 0; i < this->index; i++) {
+            if (nullFlags[i / CHAR_BIT] & (1 << (7 - i % CHAR_BIT))) {
+                offset -= sizeof(int);
             }
         }
+        return (const char *) tuple + offset;
+    }
+    offset = this->nullFlagSize;
+    for (int i = 0; i < this->index; i++) {
+        if (nullFlags[i / CHAR_BIT] & (1 << (7 - i % CHAR_BIT))) {
+            continue;
+        }
+        if (this->varChars[i]) {
+            int length;
+            memcpy(&length, (const char *) tuple + offset, sizeof(int));
+            offset += length;
+        }
+        offset += sizeof(int);
     }
-    return index;
+    return (const char *) tuple + offset;
+}
+
+int AttrPlan::read(const void *tuple, void *value) const {
+    const char *field = this->locate(tuple);
+    if (field == nullptr) {
+        return -1;
+    }
+    int size = sizeof(int);
+    if (this->attr.type == TypeVarChar) {
+        int length;
+        memcpy(&length, field, sizeof(int));
+        size += length;
+    }
+    memcpy(value, field, size);
+    return this->index;
 }
 
 Project::Project(Iterator *input, const std::vector<std::string> &attrNames) {
@@ -146,9 +383,23 @@ Project::Project(Iterator *input, const std::vector<std::string> &attrNames) {
         for (int j = 0; j < this->attrs.size(); j++) {
             if (attrName == this->attrs[j].name) {
                 this->projectAttrs.push_back(this->attrs[j]);
+                this->projectIndex.push_back(j);
+                this->projectPlans.emplace_back(this->attrs, attrName);
             }
         }
     }
+    this->tuple = malloc(max(getMaxTupleSize(this->attrs), PAGE_SIZE));
+
+    // An input that narrows its tuples itself spares copying every attribute out just to drop most of them
+    vector<string> projectNames;
+    for (const Attribute &attr : this->projectAttrs) {
+        projectNames.push_back(attr.name);
+    }
+    this->pushedDown = input->pushProjection(projectNames);
+}
+
+Project::~Project() {
+    free(this->tuple);
 }
 
 void Project::getAttributes(std::vector<Attribute> &attrs) const {
@@ -160,67 +411,64 @@ void Project::getAttributes(std::vector<Attribute> &attrs) const {
 }
 
 RC Project::getNextTuple(void *data) {
-    void *page = malloc(PAGE_SIZE);
-    while (this->input->getNextTuple(page) != RM_EOF) {
-        int length = this->getProjectValue(data, page);
-        if (length == -1) {
-            continue;
+    if (this->pushedDown) {
+        return this->input->getNextTuple(data);
+    }
+    RC rc = this->input->getNextTuple(this->tuple);
+    if (rc != 0) {
+        return rc;
+    }
+    this->getProjectValue(data, this->tuple);
+    return 0;
+}
+
+RC Project::getNextBatch(Batch &batch) {
+    RC rc = this->input->getNextBatch(batch);
+    if (rc != 0) {
+        return rc;
+    }
+    if (!this->pushedDown) {
+        // Columns are moved over, only one picked twice is copied
+        vector<Batch::Column> columns(this->projectIndex.size());
+        vector<int> movedTo(batch.columns.size(), -1);
+        for (int i = 0; i < this->projectIndex.size(); i++) {
+            int index = this->projectIndex[i];
+            if (movedTo[index] == -1) {
+                columns[i] = std::move(batch.columns[index]);
+                movedTo[index] = i;
+            } else {
+                columns[i] = columns[movedTo[index]];
+            }
         }
-        free(page);
-        return 0;
+        batch.columns.swap(columns);
+    }
+    for (int i = 0; i < this->projectAttrs.size(); i++) {
+        batch.columns[i].attr = this->projectAttrs[i];
+        batch.columns[i].attr.name = "Project." + this->projectAttrs[i].name;
     }
-    return RM_EOF;
+    return 0;
 }
 
 int Project::getProjectValue(void *projectDataValue, void *page) {
-    int count = 0;
-    int nullIndicatorSize = ceil((double) this->attrs.size() / CHAR_BIT);
-    char *nullIndicator = (char *) malloc(nullIndicatorSize);
-    memcpy(nullIndicator, page, nullIndicatorSize);
     int projectNullIndicatorSize = ceil((double) this->projectAttrs.size() / CHAR_BIT);
-    char *projectNullIndicator = (char *) malloc(projectNullIndicatorSize);
+    char *projectNullIndicator = (char *) projectDataValue;
     memset(projectNullIndicator, 0, projectNullIndicatorSize);
     int projectOffset = projectNullIndicatorSize;
-    for (int i = 0; i < this->projectAttrs.size(); i++) {
-        int offset = nullIndicatorSize;
-        for (int j = 0; j < this->attrs.size(); j++) {
-            bool isNull = nullIndicator[j / CHAR_BIT] & (1 << (7 - j % CHAR_BIT));
-            if (this->attrs[j].name == this->projectAttrs[i].name) {
-                count++;
-                if (isNull) {
-                    projectNullIndicator[i / 8] || (1 << (7 - i % 8));
-                }
-                if (this->attrs[j].type == TypeInt || this->attrs[j].type == TypeReal) {
-                    memcpy((char *) projectDataValue + projectOffset, (char *) page + offset, sizeof(int));
-                    offset += sizeof(int);
-                    projectOffset += sizeof(int);
-                } else {
-                    int localLength;
-                    memcpy(&localLength, (char *) page + 5, sizeof(int));
-                    memcpy((char *) projectDataValue + projectOffset, &localLength, sizeof(int));
-                    offset += sizeof(int);
-                    projectOffset += sizeof(int);
-                    memcpy((char *) projectDataValue + projectNullIndicatorSize, (char *) page + offset, localLength);
-                    offset += localLength;
-                    projectOffset += localLength;
-                }
-                break;
-            } else if (!isNull) {
-                if (this->attrs[j].type == TypeInt || this->attrs[j].type == TypeReal) {
-                    offset += sizeof(int);
-                } else {
-                    int localLength;
-                    memcpy(&localLength, (char *) page + offset, sizeof(int));
-                    offset += sizeof(int) + localLength;
-                }
-            }
+    for (int i = 0; i < this->projectPlans.size(); i++) {
+        const char *value = this->projectPlans[i].locate(page);
+        if (value == nullptr) {
+            projectNullIndicator[i / CHAR_BIT] |= 1 << (7 - i % CHAR_BIT);
+            continue;
         }
+        int size = sizeof(int);
+        if (this->projectAttrs[i].type == TypeVarChar) {
+            int length;
+            memcpy(&length, value, sizeof(int));
+            size += length;
+        }
+        memcpy((char *) projectDataValue + projectOffset, value, size);
+        projectOffset += size;
     }
-    if (count < this->projectAttrs.size()) {
-        // Some project attributes are missing, report error
-        return -1;
-    }
-    memcpy(projectDataValue, projectNullIndicator, projectNullIndicatorSize);
     return projectOffset;
 }
 
@@ -234,16 +482,29 @@ BNLJoin::BNLJoin(Iterator *leftIn, TableScan *rightIn, const Condition &conditio
     this->BlockLoaded = false;
     this->invalid = false;
     this->blockPtr = 0;
+    this->count = 0;
+    this->pendingOffset = 0;
+    this->pendingSize = 0;
+    // Every buffer is allocated once here, the join itself allocates nothing per tuple
+    this->block = malloc((numPages + 1) * PAGE_SIZE);
+    this->leftTuple = malloc(PAGE_SIZE);
+    this->rightTuple = malloc(PAGE_SIZE);
     for (int i = 0; i < this->leftAttrs.size(); i++) {
         excludeTableName(this->leftAttrs[i].name);
     }
     for (int i = 0; i < this->rightAttrs.size(); i++) {
         excludeTableName(this->rightAttrs[i].name);
     }
+    this->lhsPlan = AttrPlan(this->leftAttrs, condition.lhsAttr);
+    this->rhsPlan = AttrPlan(this->rightAttrs, condition.rhsAttr);
+    this->comparable = this->lhsPlan.index != -1 && this->rhsPlan.index != -1 &&
+                       compareAttr(this->lhsPlan.attr, this->rhsPlan.attr);
 }
 
 BNLJoin::~BNLJoin() {
-    free(block);
+    free(this->block);
+    free(this->leftTuple);
+    free(this->rightTuple);
 }
 
 void BNLJoin::getAttributes(std::vector<Attribute> &attrs) const {
@@ -258,8 +519,7 @@ void BNLJoin::getAttributes(std::vector<Attribute> &attrs) const {
 int BNLJoin::getLeftTupleSize(void *page) {
     int nullIndicatorSize = ceil((double) leftAttrs.size() / CHAR_BIT);
     int offset = 0;
-    char *nullIndicator = (char *) malloc(nullIndicatorSize);
-    memcpy(nullIndicator, (char *) page + offset, nullIndicatorSize);
+    char *nullIndicator = (char *) page;
     offset += nullIndicatorSize;
     for (int i = 0; i < leftAttrs.size(); i++) {
         bool isNull = nullIndicator[i / 8] & (1 << (7 - i % 8));
@@ -271,7 +531,7 @@ int BNLJoin::getLeftTupleSize(void *page) {
         } else {
             int length;
             memcpy(&length, (char *) page + offset, sizeof(int));
-            offset + sizeof(int) + length;
+            offset += sizeof(int) + length;
         }
     }
     return offset;
@@ -281,21 +541,31 @@ RC BNLJoin::getNextBlock() {
     BlockLoaded = true;
     blockPtr = 0;
     int size = 0;
-    int blockOffset = 0;
     this->tupleOffsets.clear();
-    block = malloc(numPages * PAGE_SIZE);
     count = 0;
     int initialPos = 0;
     tupleOffsets.push_back(initialPos);
-    while (leftIn->getNextTuple((char *) block + blockOffset) != RM_EOF) {
-        int length = getLeftTupleSize((char *) block + blockOffset);
-        size += length;
-        if (size > numPages * PAGE_SIZE) {
+    if (this->pendingSize > 0) {
+        // The tuple that did not fit into the last block starts this one
+        memmove(block, (char *) block + this->pendingOffset, this->pendingSize);
+        size = this->pendingSize;
+        tupleOffsets.push_back(size);
+        this->pendingSize = 0;
+    }
+    RC rc;
+    while ((rc = leftIn->getNextTuple((char *) block + size)) == 0) {
+        int length = getLeftTupleSize((char *) block + size);
+        if (size > 0 && size + length > numPages * PAGE_SIZE) {
             // Not EOF, but full
+            this->pendingOffset = size;
+            this->pendingSize = length;
             return 1;
         }
+        size += length;
         tupleOffsets.push_back(size);
-        blockOffset += length;
+    }
+    if (rc != QE_EOF) {
+        return rc;
     }
     if (size == 0) {
         return QE_EOF;
@@ -305,33 +575,52 @@ RC BNLJoin::getNextBlock() {
 }
 
 RC BNLJoin::getNextTuple(void *data) {
+    const void *left, *right;
+    RC rc = this->getNextMatch(left, right);
+    if (rc != 0) {
+        return rc;
+    }
+    integrateJoinResult((void *) left, (void *) right, data, leftAttrs, rightAttrs);
+    return 0;
+}
+
+RC BNLJoin::getNextBatch(Batch &batch) {
+    return getNextJoinBatch(this, batch);
+}
+
+RC BNLJoin::getNextMatch(const void *&left, const void *&right) {
+    RC rc;
     if (!BlockLoaded) {
-        leftTuple = malloc(PAGE_SIZE);
-        rightTuple = malloc(PAGE_SIZE);
-        if (this->getNextBlock() == QE_EOF || rightIn->getNextTuple(rightTuple) == QE_EOF) {
-            free(leftTuple);
-            free(rightTuple);
-            return QE_EOF;
+        // QE_EOF or the error of either input ends the join
+        rc = this->getNextBlock();
+        if (rc < 0) {
+            return rc;
+        }
+        rc = rightIn->getNextTuple(rightTuple);
+        if (rc != 0) {
+            return rc;
         }
     }
     if (this->tupleOffsets.size() == 0) {
-        free(leftTuple);
-        free(rightTuple);
         return QE_EOF;
     }
 
     do {
         if (count == tupleOffsets.size() - 1) {
             // Get next rightTuple
-            if (rightIn->getNextTuple(rightTuple) == QE_EOF) {
+            rc = rightIn->getNextTuple(rightTuple);
+            if (rc == QE_EOF) {
                 // Load next block
-                if (this->getNextBlock() == QE_EOF) {
-                    return QE_EOF;
+                rc = this->getNextBlock();
+                if (rc < 0) {
+                    return rc;
                 } else {
                     // Iterate from begin of right table
                     rightIn->reset();
                     rightIn->getNextTuple(rightTuple);
                 }
+            } else if (rc != 0) {
+                return rc;
             } else {
                 count = 0;
             }
@@ -342,35 +631,29 @@ RC BNLJoin::getNextTuple(void *data) {
 
     if (invalid) {
         invalid = false;
-        free(leftTuple);
-        free(rightTuple);
         return -1;
     }
-    integrateJoinResult(leftTuple, rightTuple, data, leftAttrs, rightAttrs);
+    left = leftTuple;
+    right = rightTuple;
     return 0;
 }
 
 bool BNLJoin::isEqual() {
-    void *valueL = malloc(PAGE_SIZE);
-    int indexL = getAttrValue(leftAttrs, condition.lhsAttr, valueL, leftTuple);
-    void *valueR = malloc(PAGE_SIZE);
-    int indexR = getAttrValue(rightAttrs, condition.rhsAttr, valueR, rightTuple);
-    if (indexL == -1 || indexR == -1) {
+    if (lhsPlan.index == -1 || rhsPlan.index == -1) {
         // when compare is invalid, return true to break the loop
         invalid = true;
-        free(valueL);
-        free(valueR);
         return invalid;
     }
-    if (compareAttr(leftAttrs[indexL], rightAttrs[indexR])) {
-        bool res = compareEqual(leftAttrs[indexL], valueL, valueR);
-        free(valueL);
-        free(valueR);
-        return res;
+    if (!comparable) {
+        return false;
     }
-    free(valueL);
-    free(valueR);
-    return false;
+    // A null matches nothing
+    const char *valueL = lhsPlan.locate(leftTuple);
+    const char *valueR = rhsPlan.locate(rightTuple);
+    if (valueL == nullptr || valueR == nullptr) {
+        return false;
+    }
+    return compareEqual(lhsPlan.attr, valueL, valueR);
 }
 
 INLJoin::INLJoin(Iterator *leftIn, IndexScan *rightIn, const Condition &condition) {
@@ -379,7 +662,17 @@ INLJoin::INLJoin(Iterator *leftIn, IndexScan *rightIn, const Condition &conditio
     this->condition = condition;
     leftIn->getAttributes(this->leftAttrs);
     rightIn->getAttributes(this->rightAttrs);
-    this->leftLoaded = false;
+    this->leftKey = malloc(PAGE_SIZE);
+    this->lhsPlan = AttrPlan(this->leftAttrs, condition.lhsAttr);
+    this->leftSize = getMaxTupleSize(this->leftAttrs);
+    this->rightSize = getMaxTupleSize(this->rightAttrs);
+    this->batchSize = getFetchBatchSize(max(this->leftSize, this->rightSize));
+    this->leftTuples = (char *) malloc(this->batchSize * this->leftSize);
+    this->leftCount = 0;
+    this->probing = false;
+    this->leftDone = false;
+    this->batchTuples = (char *) malloc(this->batchSize * this->rightSize);
+    this->batchPos = 0;
     for (int i = 0; i < this->leftAttrs.size(); i++) {
         excludeTableName(this->leftAttrs[i].name);
     }
@@ -389,6 +682,9 @@ INLJoin::INLJoin(Iterator *leftIn, IndexScan *rightIn, const Condition &conditio
 }
 
 INLJoin::~INLJoin() {
+    free(this->leftKey);
+    free(this->leftTuples);
+    free(this->batchTuples);
 }
 
 void INLJoin::getAttributes(std::vector<Attribute> &attrs) const {
@@ -401,40 +697,341 @@ void INLJoin::getAttributes(std::vector<Attribute> &attrs) const {
 }
 
 RC INLJoin::getNextTuple(void *data) {
-    while (true) {
-        if (!leftLoaded) {
-            leftLoaded = true;
-            leftTuple = malloc(PAGE_SIZE);
-            leftKey = malloc(PAGE_SIZE);
-            if (this->leftIn->getNextTuple(leftTuple) != QE_EOF) {
-                int pos = getAttrValue(this->leftAttrs, this->condition.lhsAttr, leftKey, leftTuple);
-                if (pos == -1) {
-                    free(leftTuple);
-                    free(leftKey);
-                    return -1;
-                }
-                this->rightIn->setIterator(leftKey, leftKey, true, true);
+    const void *left, *right;
+    RC rc = this->getNextMatch(left, right);
+    if (rc != 0) {
+        return rc;
+    }
+    integrateJoinResult((void *) left, (void *) right, data, leftAttrs, rightAttrs);
+    return 0;
+}
+
+RC INLJoin::getNextBatch(Batch &batch) {
+    return getNextJoinBatch(this, batch);
+}
+
+RC INLJoin::getNextMatch(const void *&left, const void *&right) {
+    while (this->batchPos == this->batchRids.size() || !this->batchFound[this->batchPos]) {
+        if (this->batchPos < this->batchRids.size()) {
+            this->batchPos++;
+            continue;
+        }
+        RC rc = this->fetchBatch();
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    left = this->leftTuples + this->batchLefts[this->batchPos] * this->leftSize;
+    right = this->batchTuples + this->batchPos * this->rightSize;
+    this->batchPos++;
+    return 0;
+}
+
+RC INLJoin::fetchBatch() {
+    this->batchRids.clear();
+    this->batchLefts.clear();
+    this->batchPos = 0;
+    if (this->probing && this->leftCount > 1) {
+        // The left tuple whose matches did not all fit in the last batch goes on in this one
+        memcpy(this->leftTuples, this->leftTuples + (this->leftCount - 1) * this->leftSize, this->leftSize);
+    }
+    this->leftCount = this->probing ? 1 : 0;
+    while (this->batchRids.size() < this->batchSize) {
+        if (!this->probing) {
+            if (this->leftDone || this->leftCount == this->batchSize) {
+                break;
+            }
+            char *leftTuple = this->leftTuples + this->leftCount * this->leftSize;
+            RC rc = this->leftIn->getNextTuple(leftTuple);
+            if (rc == QE_EOF) {
+                this->leftDone = true;
+                break;
             }
+            if (rc != 0) {
+                return rc;
+            }
+            if (this->lhsPlan.read(leftTuple, this->leftKey) == -1) {
+                return -1;
+            }
+            this->rightIn->setIterator(this->leftKey, this->leftKey, true, true);
+            this->leftCount++;
+            this->probing = true;
+        }
+        RID rid;
+        while (this->batchRids.size() < this->batchSize &&
+               this->rightIn->iter->getNextEntry(rid, this->rightIn->key) == 0) {
+            this->batchRids.push_back(rid);
+            this->batchLefts.push_back(this->leftCount - 1);
+        }
+        if (this->batchRids.size() < this->batchSize) {
+            this->probing = false;
+        }
+    }
+    if (this->batchRids.empty()) {
+        return this->leftDone ? QE_EOF : 0;
+    }
+    vector<void *> tuples;
+    for (int i = 0; i < this->batchRids.size(); i++) {
+        tuples.push_back(this->batchTuples + i * this->rightSize);
+    }
+    RC rc = this->rightIn->readTuples(this->batchRids, tuples, this->batchFound);
+    if (rc != 0) {
+        this->batchRids.clear();
+    }
+    return rc;
+}
+
+unsigned GHJoin::joinCount = 0;
+
+GHJoin::GHJoin(Iterator *leftIn, Iterator *rightIn, const Condition &condition, const unsigned numPartitions) {
+    this->leftIn = leftIn;
+    this->rightIn = rightIn;
+    this->condition = condition;
+    this->numPartitions = numPartitions == 0 ? 1 : numPartitions;
+    leftIn->getAttributes(this->leftAttrs);
+    rightIn->getAttributes(this->rightAttrs);
+    for (int i = 0; i < this->leftAttrs.size(); i++) {
+        excludeTableName(this->leftAttrs[i].name);
+        this->leftRecordAttrs.push_back(this->leftAttrs[i]);
+        this->leftRecordAttrs[i].name = to_string(i);
+        this->leftRecordNames.push_back(this->leftRecordAttrs[i].name);
+    }
+    for (int i = 0; i < this->rightAttrs.size(); i++) {
+        excludeTableName(this->rightAttrs[i].name);
+        this->rightRecordAttrs.push_back(this->rightAttrs[i]);
+        this->rightRecordAttrs[i].name = to_string(i);
+        this->rightRecordNames.push_back(this->rightRecordAttrs[i].name);
+    }
+    string id = to_string(getpid()) + "_" + to_string(joinCount++);
+    this->leftPrefix = "left_join" + id + "_";
+    this->rightPrefix = "right_join" + id + "_";
+    this->partitioned = false;
+    this->failure = 0;
+    this->partition = -1;
+    this->leftTuple = malloc(PAGE_SIZE);
+    this->rightTuple = malloc(PAGE_SIZE);
+    this->leftPlan = AttrPlan(this->leftAttrs, condition.lhsAttr);
+    this->rightPlan = AttrPlan(this->rightAttrs, condition.rhsAttr);
+    this->joinable = this->leftPlan.index != -1 && this->rightPlan.index != -1;
+    this->match = this->hashTable.end();
+    this->matchEnd = this->hashTable.end();
+    this->probing = false;
+}
+
+GHJoin::~GHJoin() {
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+    if (this->probing) {
+        this->rightScan.close();
+        rbfm.closeFile(this->rightHandle);
+    }
+    for (const string &fileName : this->partitionFiles) {
+        rbfm.destroyFile(fileName);
+    }
+    free(this->leftTuple);
+    free(this->rightTuple);
+}
+
+void GHJoin::getAttributes(std::vector<Attribute> &attrs) const {
+    for (int i = 0; i < this->leftAttrs.size(); i++) {
+        attrs.push_back(leftAttrs[i]);
+    }
+    for (int i = 0; i < this->rightAttrs.size(); i++) {
+        attrs.push_back(this->rightAttrs[i]);
+    }
+}
+
+RC GHJoin::getNextTuple(void *data) {
+    const void *left, *right;
+    RC rc = this->getNextMatch(left, right);
+    if (rc != 0) {
+        return rc;
+    }
+    integrateJoinResult((void *) left, (void *) right, data, this->leftAttrs, this->rightAttrs);
+    return 0;
+}
+
+RC GHJoin::getNextBatch(Batch &batch) {
+    return getNextJoinBatch(this, batch);
+}
+
+RC GHJoin::getNextMatch(const void *&left, const void *&right) {
+    if (!this->joinable) {
+        return -7; // AttributeNotFoundException
+    }
+    if (this->failure != 0) {
+        // The partitions are not to be trusted after an error, it is returned again instead
+        return this->failure;
+    }
+    if (!this->partitioned) {
+        this->partitioned = true;
+        RC rc = this->partitionInput(this->leftIn, this->leftAttrs, this->leftRecordAttrs, this->leftPlan,
+                                     this->leftPrefix);
+        if (rc == 0) {
+            rc = this->partitionInput(this->rightIn, this->rightAttrs, this->rightRecordAttrs, this->rightPlan,
+                                      this->rightPrefix);
         }
-        rightTuple = malloc(PAGE_SIZE);
-        if (this->rightIn->getNextTuple(rightTuple) != QE_EOF) {
-            integrateJoinResult(leftTuple, rightTuple, data, leftAttrs, rightAttrs);
-            free(rightTuple);
+        if (rc != 0) {
+            this->failure = rc;
+            return rc;
+        }
+    }
+    RID rid;
+    while (true) {
+        if (this->match != this->matchEnd) {
+            left = this->partitionTuples.data() + this->match->second;
+            right = this->rightTuple;
+            this->match++;
             return 0;
         }
-        if (this->leftIn->getNextTuple(leftTuple) != QE_EOF) {
-            int pos = getAttrValue(leftAttrs, this->condition.lhsAttr, leftKey, leftTuple);
-            if (pos == -1) {
-                free(leftTuple);
-                free(leftKey);
-                return -1;
+        if (this->probing) {
+            RC rc = this->rightScan.getNextRecord(rid, this->rightTuple);
+            if (rc == 0) {
+                if (this->getJoinKey(this->rightPlan, this->rightTuple)) {
+                    auto range = this->hashTable.equal_range(this->key);
+                    this->match = range.first;
+                    this->matchEnd = range.second;
+                }
+                continue;
+            }
+            if (rc != RBFM_EOF) {
+                this->failure = rc;
+                return rc;
             }
-            this->rightIn->setIterator(leftKey, leftKey, true, true);
+            this->rightScan.close();
+            RecordBasedFileManager::instance().closeFile(this->rightHandle);
+            this->probing = false;
+        }
+        if (this->partition + 1 >= (int) this->numPartitions) {
+            return QE_EOF;
+        }
+        this->partition++;
+        RC rc = this->loadPartition();
+        if (rc != 0) {
+            this->failure = rc;
+            return rc;
+        }
+    }
+}
+
+RC GHJoin::partitionInput(Iterator *input, const vector<Attribute> &attrs, const vector<Attribute> &recordAttrs,
+                          const AttrPlan &keyPlan, const string &prefix) {
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+    vector<FileHandle> handles(this->numPartitions);
+    RC rc = 0;
+    for (unsigned i = 0; i < this->numPartitions && rc == 0; i++) {
+        // A file left there by someone else is not ours to overwrite
+        string fileName = prefix + to_string(i);
+        rc = rbfm.createFile(fileName);
+        if (rc == 0) {
+            this->partitionFiles.push_back(fileName);
+            rc = rbfm.openFile(fileName, handles[i]);
+        }
+    }
+    // Tuples wait in memory until about a page of them can go to their partition at once
+    vector<vector<char>> pending(this->numPartitions);
+    vector<vector<int>> pendingOffsets(this->numPartitions);
+    vector<const void *> records;
+    vector<RID> rids;
+    auto flush = [&](unsigned i) {
+        records.clear();
+        for (int offset : pendingOffsets[i]) {
+            records.push_back(pending[i].data() + offset);
+        }
+        RC flushed = rbfm.insertRecords(handles[i], recordAttrs, records, rids);
+        pending[i].clear();
+        pendingOffsets[i].clear();
+        return flushed;
+    };
+    hash<string> hasher;
+    RC inputRc = 0;
+    while (rc == 0 && (inputRc = input->getNextTuple(this->leftTuple)) == 0) {
+        // Null keys match nothing, so they are left out
+        if (!this->getJoinKey(keyPlan, this->leftTuple)) {
             continue;
         }
-        free(rightTuple);
-        return QE_EOF;
+        unsigned i = hasher(this->key) % this->numPartitions;
+        int size = getTupleSize(attrs, this->leftTuple);
+        pendingOffsets[i].push_back(pending[i].size());
+        pending[i].insert(pending[i].end(), (char *) this->leftTuple, (char *) this->leftTuple + size);
+        if (pending[i].size() >= PAGE_SIZE) {
+            rc = flush(i);
+        }
+    }
+    for (unsigned i = 0; i < this->numPartitions; i++) {
+        if (rc == 0 && !pendingOffsets[i].empty()) {
+            rc = flush(i);
+        }
+        rbfm.closeFile(handles[i]);
+    }
+    if (rc == 0 && inputRc != QE_EOF) {
+        rc = inputRc;
+    }
+    return rc;
+}
+
+RC GHJoin::loadPartition() {
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+    this->hashTable.clear();
+    this->partitionTuples.clear();
+    this->match = this->hashTable.end();
+    this->matchEnd = this->hashTable.end();
+
+    FileHandle leftHandle;
+    RC rc = rbfm.openFile(this->leftPrefix + to_string(this->partition), leftHandle);
+    if (rc != 0) {
+        return rc;
+    }
+    RBFM_ScanIterator leftScan;
+    rbfm.scan(leftHandle, this->leftRecordAttrs, "", NO_OP, NULL, this->leftRecordNames, leftScan);
+    RID rid;
+    while ((rc = leftScan.getNextRecord(rid, this->leftTuple)) == 0) {
+        this->getJoinKey(this->leftPlan, this->leftTuple);
+        int size = getTupleSize(this->leftAttrs, this->leftTuple);
+        this->hashTable.emplace(this->key, this->partitionTuples.size());
+        this->partitionTuples.insert(this->partitionTuples.end(), (char *) this->leftTuple,
+                                     (char *) this->leftTuple + size);
+    }
+    leftScan.close();
+    rbfm.closeFile(leftHandle);
+    if (rc != RBFM_EOF) {
+        return rc;
+    }
+    if (this->hashTable.empty()) {
+        // Nothing on the right can match
+        return 0;
+    }
+
+    rc = rbfm.openFile(this->rightPrefix + to_string(this->partition), this->rightHandle);
+    if (rc != 0) {
+        return rc;
     }
+    rbfm.scan(this->rightHandle, this->rightRecordAttrs, "", NO_OP, NULL, this->rightRecordNames, this->rightScan);
+    this->probing = true;
+    return 0;
+}
+
+bool GHJoin::getJoinKey(const AttrPlan &keyPlan, const void *tuple) {
+    const char *value = keyPlan.locate(tuple);
+    if (value == nullptr) {
+        return false;
+    }
+    this->key.assign(1, (char) keyPlan.attr.type);
+    if (keyPlan.attr.type == TypeVarChar) {
+        int length;
+        memcpy(&length, value, sizeof(int));
+        this->key.append(value + sizeof(int), length);
+        return true;
+    }
+    float real;
+    memcpy(&real, value, sizeof(float));
+    if (keyPlan.attr.type == TypeReal && real == 0) {
+        // 0.0 and -0.0 are equal but differ in their bits
+        float zero = 0;
+        this->key.append((char *) &zero, sizeof(float));
+    } else {
+        this->key.append(value, sizeof(int));
+    }
+    return true;
 }
 
 bool compareAttr(Attribute &attrL, Attribute &attrR) {
@@ -447,14 +1044,12 @@ bool compareAttr(Attribute &attrL, Attribute &attrR) {
 void integrateJoinResult(void *leftTuple, void *rightTuple, void *integratedResuelt, vector<Attribute> &leftAttrs,
                          vector<Attribute> &rightAttrs) {
     int nullIndicatorSize = ceil((double) (leftAttrs.size() + rightAttrs.size()) / CHAR_BIT);
-    char *nullIndicator = (char *) malloc(nullIndicatorSize);
+    char *nullIndicator = (char *) integratedResuelt;
     memset(nullIndicator, 0, nullIndicatorSize);
     int nullIndicatorLSize = ceil((double) leftAttrs.size() / CHAR_BIT);
-    char *nullIndicatorL = (char *) malloc(nullIndicatorLSize);
-    memcpy(nullIndicatorL, leftTuple, nullIndicatorLSize);
+    char *nullIndicatorL = (char *) leftTuple;
     int nullIndicatorRSize = ceil((double) rightAttrs.size() / CHAR_BIT);
-    char *nullIndicatorR = (char *) malloc(nullIndicatorRSize);
-    memcpy(nullIndicatorR, rightTuple, nullIndicatorRSize);
+    char *nullIndicatorR = (char *) rightTuple;
     int offset = nullIndicatorSize;
     int offsetL = nullIndicatorLSize;
     int offsetR = nullIndicatorRSize;
@@ -476,10 +1071,6 @@ void integrateJoinResult(void *leftTuple, void *rightTuple, void *integratedResu
             FillAttrValue(integratedResuelt, rightTuple, offset, offsetR, rightAttrs[index]);
         }
     }
-    memcpy(integratedResuelt, nullIndicator, nullIndicatorSize);
-    free(nullIndicator);
-    free(nullIndicatorL);
-    free(nullIndicatorR);
 }
 
 void FillAttrValue(void *des, void *srs, int &desOffset, int &srsOffset, Attribute &attr) {
@@ -499,12 +1090,70 @@ void FillAttrValue(void *des, void *srs, int &desOffset, int &srsOffset, Attribu
     }
 }
 
+int getTupleSize(const vector<Attribute> &attrs, const void *data) {
+    int nullIndicatorSize = ceil((double) attrs.size() / CHAR_BIT);
+    int offset = nullIndicatorSize;
+    for (int i = 0; i < attrs.size(); i++) {
+        bool isNull = ((char *) data)[i / CHAR_BIT] & (1 << (7 - i % CHAR_BIT));
+        if (isNull) {
+            continue;
+        }
+        if (attrs[i].type == TypeVarChar) {
+            int length;
+            memcpy(&length, (char *) data + offset, sizeof(int));
+            offset += length;
+        }
+        offset += sizeof(int);
+    }
+    return offset;
+}
+
+int getMaxTupleSize(const vector<Attribute> &attrs) {
+    int size = ceil((double) attrs.size() / CHAR_BIT);
+    for (const Attribute &attr : attrs) {
+        size += attr.type == TypeVarChar ? sizeof(int) + attr.length : sizeof(int);
+    }
+    return size;
+}
+
+int getFetchBatchSize(int tupleSize) {
+    return max(1, min(QE_FETCH_BATCH, QE_FETCH_BYTES / tupleSize));
+}
+
+bool getProjectedAttributes(const vector<Attribute> &attrs, const vector<string> &attrNames,
+                            vector<Attribute> &projected) {
+    projected.clear();
+    for (const string &attrName : attrNames) {
+        auto it = find_if(attrs.begin(), attrs.end(), [&attrName](const Attribute &attr) {
+            return attr.name == attrName;
+        });
+        if (it == attrs.end()) {
+            return false;
+        }
+        projected.push_back(*it);
+    }
+    return true;
+}
+
 void excludeTableName(string &name) {
     int pos = name.find('.');
     string attrName = name.substr(pos + 1, name.length() - pos + 1);
     name = attrName;
 }
 
+int compareVarChar(const void *compValue, const void *compKey) {
+    int valueLen;
+    int keyLen;
+    memcpy(&valueLen, compValue, sizeof(int));
+    memcpy(&keyLen, compKey, sizeof(int));
+    int order = memcmp((const char *) compValue + sizeof(int), (const char *) compKey + sizeof(int),
+                       min(valueLen, keyLen));
+    if (order != 0) {
+        return order;
+    }
+    return valueLen - keyLen;
+}
+
 bool compareEqual(Attribute &attr, const void *compValue, const void *compKey) {
     bool equal;
     switch (attr.type) {
@@ -523,23 +1172,7 @@ bool compareEqual(Attribute &attr, const void *compValue, const void *compKey) {
             equal = valueII == keyII;
             break;
         case TypeVarChar:
-            string valueStr;
-            string keyStr;
-            int valueLen;
-            int keyLen;
-            memcpy(&valueLen, (char *) compValue, sizeof(int));
-            memcpy(&keyLen, (char *) compKey, sizeof(int));
-            char *value = (char *) malloc(valueLen + 1);
-            char *key = (char *) malloc(keyLen + 1);
-            memcpy(value, (char *) compValue + sizeof(int), valueLen);
-            memcpy(key, (char *) compKey + sizeof(int), keyLen);
-            value[valueLen] = '\0';
-            key[keyLen] = '\0';
-            valueStr = string(value);
-            keyStr = string(key);
-            equal = valueStr == keyStr;
-            free(value);
-            free(key);
+            equal = compareVarChar(compValue, compKey) == 0;
             break;
     }
     return equal;
@@ -567,31 +1200,12 @@ int compareLess(Attribute &attr, const void *compValue, const void *compKey) {
             return 0;
         }
     } else if (attr.type == TypeVarChar) {
-        string valueStr;
-        string keyStr;
-        int valueLen;
-        int keyLen;
-        memcpy(&valueLen, (char *) compValue, sizeof(int));
-        memcpy(&keyLen, (char *) compKey, sizeof(int));
-        char *value = (char *) malloc(valueLen + 1);
-        char *key = (char *) malloc(keyLen + 1);
-        memcpy(value, (char *) compValue + sizeof(int), valueLen);
-        memcpy(key, (char *) compKey + sizeof(int), keyLen);
-        value[valueLen] = '\0';
-        key[keyLen] = '\0';
-        valueStr = string(value);
-        keyStr = string(key);
-        if (valueStr < keyStr) {
-            free(value);
-            free(key);
+        int order = compareVarChar(compValue, compKey);
+        if (order < 0) {
             return 1;
-        } else if (valueStr == keyStr) {
-            free(value);
-            free(key);
+        } else if (order == 0) {
             return 0;
         }
-        free(value);
-        free(key);
     }
     return -1;
 }
@@ -618,31 +1232,12 @@ int compareLarge(Attribute &attr, const void *compValue, const void *compKey) {
             return 0;
         }
     } else if (attr.type == TypeVarChar) {
-        string valueStr;
-        string keyStr;
-        int valueLen;
-        int keyLen;
-        memcpy(&valueLen, (char *) compValue, sizeof(int));
-        memcpy(&keyLen, (char *) compKey, sizeof(int));
-        char *value = (char *) malloc(valueLen + 1);
-        char *key = (char *) malloc(keyLen + 1);
-        memcpy(value, (char *) compValue + sizeof(int), valueLen);
-        memcpy(key, (char *) compKey + sizeof(int), keyLen);
-        value[valueLen] = '\0';
-        key[keyLen] = '\0';
-        valueStr = string(value);
-        keyStr = string(key);
-        if (valueStr > keyStr) {
-            free(value);
-            free(key);
+        int order = compareVarChar(compValue, compKey);
+        if (order > 0) {
             return 1;
-        } else if (valueStr == keyStr) {
-            free(value);
-            free(key);
+        } else if (order == 0) {
             return 0;
         }
-        free(value);
-        free(key);
     }
     return -1;
 }
@@ -699,175 +1294,130 @@ Aggregate::Aggregate(Iterator *input, Attribute aggAttr, Attribute groupAttr, Ag
 }
 
 void Aggregate::buildAggResult() {
-    void *data = malloc(PAGE_SIZE);
-    memset(data, 0, PAGE_SIZE);
-    while (this->input->getNextTuple(data) != RM_EOF) {
-        void *value = malloc(PAGE_SIZE);
-        int rc = this->getAttrValueByName(data, this->attrs, this->aggAttr.name, value);
-        if (rc != 0) {
-            free(value);
-            free(data);
-            return;
+    int aggIndex = -1;
+    int groupIndex = -1;
+    for (int i = 0; i < this->attrs.size(); i++) {
+        if (aggIndex == -1 && this->attrs[i].name == this->aggAttr.name) {
+            aggIndex = i;
         }
-        float numeric = 0;
-        switch (this->aggAttr.type) {
-            case TypeInt: {
-                int itg;
-                memcpy(&itg, value, sizeof(int));
-                numeric = (float) itg;
-                break;
-            }
-            case TypeReal: {
-                float flt;
-                memcpy(&flt, value, sizeof(float));
-                numeric = flt;
-                break;
-            }
-            case TypeVarChar: {
-                numeric = 0;
-                break;
-            }
+        if (groupIndex == -1 && this->groupOpFlag && this->attrs[i].name == this->groupAttr.name) {
+            groupIndex = i;
         }
-        if (this->groupOpFlag) {
-            void *groupVal = malloc(PAGE_SIZE);
-            memset(groupVal, 0, PAGE_SIZE);
-            rc = this->getAttrValueByName(data, this->attrs, this->groupAttr.name, groupVal);
-            switch (this->groupAttr.type) {
-                case TypeInt: {
-                    int itg;
-                    memcpy(&itg, groupVal, sizeof(int));
-
-                    auto itgItr = this->itgMap.find(itg);
-                    if (itgItr == this->itgMap.end()) {
-                        GroupAttr gAttr;
-                        gAttr.sum += numeric;
-                        gAttr.count++;
-                        this->itgMap[itg] = gAttr;
-                    } else {
-                        itgItr->second.sum += numeric;
-                        itgItr->second.count++;
-                        itgItr->second.max = numeric > (itgItr->second.max) ? numeric : itgItr->second.max;
-                        itgItr->second.min = numeric < (itgItr->second.min) ? numeric : itgItr->second.min;
-                    }
-                    this->itgIter = this->itgMap.begin();
-                    this->mapSize = this->itgMap.size();
-                    break;
-                }
-                case TypeReal: {
-                    int flt;
-                    memcpy(&flt, groupVal, sizeof(float));
-
-                    auto fltItr = this->fltMap.find(flt);
-                    if (fltItr == this->fltMap.end()) {
-                        GroupAttr gAttr;
-                        gAttr.sum += numeric;
-                        gAttr.count++;
-                        this->fltMap[flt] = gAttr;
-                    } else {
-                        fltItr->second.sum += numeric;
-                        fltItr->second.count++;
-                        fltItr->second.max = numeric > (fltItr->second.max) ?
-                                             numeric : fltItr->second.max;
-                        fltItr->second.min = numeric < (fltItr->second.min) ?
-                                             numeric : fltItr->second.min;
-                    }
-                    this->fltIter = this->fltMap.begin();
-                    this->mapSize = this->fltMap.size();
-                    break;
-                }
-                case TypeVarChar: {
-                    int len;
-                    memcpy(&len, groupVal, sizeof(int));
-                    void *str = malloc(len);
-                    memset(str, 0, len);
-                    memcpy(str, (char *) groupVal + sizeof(int), len);
-                    string vchar = string((char *) str, len);
-                    free(str);
-                    auto vcharItr = this->vcharMap.find(vchar);
-                    if (vcharItr == this->vcharMap.end()) {
-                        GroupAttr gAttr;
-                        gAttr.sum += numeric;
-                        gAttr.count++;
-                        this->vcharMap[vchar] = gAttr;
-                    } else {
-                        vcharItr->second.sum += numeric;
-                        vcharItr->second.count++;
-                        vcharItr->second.min = numeric;
-                        vcharItr->second.max = numeric;
-                    }
-                    this->vcharIter = this->vcharMap.begin();
-                    this->mapSize = this->vcharMap.size();
-                    break;
-                }
+    }
+    if (aggIndex == -1 || (this->groupOpFlag && groupIndex == -1)) {
+        return;
+    }
+
+    // The input comes in batches, the values are read in place from their columns
+    Batch batch;
+    while (this->input->getNextBatch(batch) == 0) {
+        for (int row : batch.selection) {
+            const char *value = batch.getValue(aggIndex, row);
+            if (value == nullptr) {
+                continue;
             }
-            free(groupVal);
-        } else {
-            this->gpAttr.count++;
-            this->gpAttr.sum += numeric;
-            this->gpAttr.max = numeric > this->gpAttr.max ?
-                               numeric : this->gpAttr.max;
-            this->gpAttr.min = numeric < this->gpAttr.min ?
-                               numeric : this->gpAttr.min;
+            this->accumulate(value, this->groupOpFlag ? batch.getValue(groupIndex, row) : nullptr);
         }
-        free(value);
     }
-    free(data);
 }
 
-RC Aggregate::getAttrValueByName(const void *data, vector<Attribute> &attrs, string &attrName, void *value) {
-    int pos;
-    for (pos = 0; pos < attrs.size(); pos++) {
-        if (attrs[pos].name == attrName) {
+void Aggregate::accumulate(const char *value, const char *groupVal) {
+    float numeric = 0;
+    switch (this->aggAttr.type) {
+        case TypeInt: {
+            int itg;
+            memcpy(&itg, value, sizeof(int));
+            numeric = (float) itg;
+            break;
+        }
+        case TypeReal: {
+            float flt;
+            memcpy(&flt, value, sizeof(float));
+            numeric = flt;
+            break;
+        }
+        case TypeVarChar: {
+            numeric = 0;
             break;
         }
     }
-    if (pos == attrs.size()) {
-        return -1;
-    }
-
-    int fieldCount = attrs.size();
-    int nullFlagSize = ceil((double) fieldCount / CHAR_BIT);
-    unsigned char *nullFlags = (unsigned char *) malloc(nullFlagSize);
-    memset(nullFlags, 0, nullFlagSize);
-    memcpy((char *) nullFlags, (char *) data, nullFlagSize);
-
-    int offset = nullFlagSize;
-    int nByte = pos / 8;
-    int nBit = pos % 8;
-    bool nullBit = nullFlags[nByte] & (1 << (7 - nBit));
-
-    if (nullBit) {
-        return -1;
-    }
-
-    for (int i = 0; i < fieldCount; i++) {
-        nByte = i / 8;
-        nBit = i % 8;
-        nullBit = nullFlags[nByte] & (1 << (7 - nBit));
-        if (nullBit) {
-            continue;
+    if (this->groupOpFlag) {
+        if (groupVal == nullptr) {
+            return;
         }
+        switch (this->groupAttr.type) {
+            case TypeInt: {
+                int itg;
+                memcpy(&itg, groupVal, sizeof(int));
 
-        if (attrs[i].type == TypeVarChar) {
-            int len;
-            memcpy(&len, (char *) data + offset, sizeof(int));
-            offset += sizeof(int);
-            memcpy(value, &len, sizeof(int));
-            memcpy((char *) value + sizeof(int), (char *) data + offset, len);
-            offset += len;
-        } else if (attrs[i].type == TypeInt) {
-            memcpy(value, (char *) data + offset, sizeof(int));
-            offset += attrs[i].length;
-        } else if (attrs[i].type == TypeReal) {
-            memcpy(value, (char *) data + offset, sizeof(float));
-            offset += attrs[i].length;
-        }
-        if (i == pos) {
-            break;
+                auto itgItr = this->itgMap.find(itg);
+                if (itgItr == this->itgMap.end()) {
+                    GroupAttr gAttr;
+                    gAttr.sum += numeric;
+                    gAttr.count++;
+                    this->itgMap[itg] = gAttr;
+                } else {
+                    itgItr->second.sum += numeric;
+                    itgItr->second.count++;
+                    itgItr->second.max = numeric > (itgItr->second.max) ? numeric : itgItr->second.max;
+                    itgItr->second.min = numeric < (itgItr->second.min) ? numeric : itgItr->second.min;
+                }
+                this->itgIter = this->itgMap.begin();
+                this->mapSize = this->itgMap.size();
+                break;
+            }
+            case TypeReal: {
+                int flt;
+                memcpy(&flt, groupVal, sizeof(float));
+
+                auto fltItr = this->fltMap.find(flt);
+                if (fltItr == this->fltMap.end()) {
+                    GroupAttr gAttr;
+                    gAttr.sum += numeric;
+                    gAttr.count++;
+                    this->fltMap[flt] = gAttr;
+                } else {
+                    fltItr->second.sum += numeric;
+                    fltItr->second.count++;
+                    fltItr->second.max = numeric > (fltItr->second.max) ?
+                                         numeric : fltItr->second.max;
+                    fltItr->second.min = numeric < (fltItr->second.min) ?
+                                         numeric : fltItr->second.min;
+                }
+                this->fltIter = this->fltMap.begin();
+                this->mapSize = this->fltMap.size();
+                break;
+            }
+            case TypeVarChar: {
+                int len;
+                memcpy(&len, groupVal, sizeof(int));
+                string &vchar = this->groupKey;
+                vchar.assign(groupVal + sizeof(int), len);
+                auto vcharItr = this->vcharMap.find(vchar);
+                if (vcharItr == this->vcharMap.end()) {
+                    GroupAttr gAttr;
+                    gAttr.sum += numeric;
+                    gAttr.count++;
+                    this->vcharMap[vchar] = gAttr;
+                } else {
+                    vcharItr->second.sum += numeric;
+                    vcharItr->second.count++;
+                    vcharItr->second.min = numeric;
+                    vcharItr->second.max = numeric;
+                }
+                this->vcharIter = this->vcharMap.begin();
+                this->mapSize = this->vcharMap.size();
+                break;
+            }
         }
+    } else {
+        this->gpAttr.count++;
+        this->gpAttr.sum += numeric;
+        this->gpAttr.max = numeric > this->gpAttr.max ?
+                           numeric : this->gpAttr.max;
+        this->gpAttr.min = numeric < this->gpAttr.min ?
+                           numeric : this->gpAttr.min;
     }
-    free(nullFlags);
-    return 0;
 }
 
 RC Aggregate::getNextTuple(void *data) {
@@ -875,10 +1425,9 @@ RC Aggregate::getNextTuple(void *data) {
         return QE_EOF;
     }
 
-    int fieldCount = 1;
+    int fieldCount = this->groupOpFlag ? 2 : 1;
     int nullFlagSize = ceil((double) fieldCount / CHAR_BIT);
-    unsigned char *nullFlags = (unsigned char *) malloc(nullFlagSize);
-    memset(nullFlags, 0, nullFlagSize);
+    memset(data, 0, nullFlagSize);
     int offset = nullFlagSize;
     float numeric;
     if (this->groupOpFlag) {
@@ -902,7 +1451,8 @@ RC Aggregate::getNextTuple(void *data) {
                 int len = this->vcharIter->first.length();
                 memcpy((char *) data + offset, &len, sizeof(int));
                 offset += sizeof(int);
-                memcpy((char *) data + offset, &this->vcharIter->first, len);
+                memcpy((char *) data + offset, this->vcharIter->first.data(), len);
+                offset += len;
                 gAttr = this->vcharIter->second;
                 this->vcharIter++;
                 break;
@@ -929,9 +1479,6 @@ RC Aggregate::getNextTuple(void *data) {
     }
     memcpy((char *) data + offset, &numeric, sizeof(float));
     this->current++;
-
-    memcpy(data, nullFlags, nullFlagSize);
-    free(nullFlags);
     return 0;
 }
 
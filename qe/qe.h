@@ -9,6 +9,10 @@
 
 #define QE_EOF (-1)  // end of the index scan
 
+#define QE_FETCH_BATCH 1024             // Index entries whose tuples are read from the table together
+#define QE_FETCH_BYTES (64 * PAGE_SIZE)  // Upper bound on the tuples of a batch when they are wide
+#define QE_BATCH_SIZE 256               // Rows returned at once by getNextBatch
+
 typedef enum {
     MIN = 0, MAX, COUNT, SUM, AVG
 } AggregateOp;
@@ -31,7 +35,28 @@ struct Condition {
     Value rhsValue;             // right-hand side value if bRhsIsAttr = FALSE
 };
 
-int getAttrValue(vector<Attribute> attrs, string attrName, void *filterValue, void *data);
+// Where an attribute sits in the tuples of an input. Operators resolve it once from the attribute name,
+// reading the value from a tuple then only walks the null indicator and the fields in front of it.
+class AttrPlan {
+public:
+    int index = -1;                     // Position among the attributes, -1 if the name is missing
+    Attribute attr;
+    int nullFlagSize = 0;
+    bool fixedOffset = false;           // No VarChar in front, so the value is at offset unless a field is null
+    int offset = 0;
+    std::vector<bool> varChars;         // Which attributes in front are VarChars
+
+    AttrPlan() = default;
+
+    // attrName may come with its relation or without, so may the names of attrs
+    AttrPlan(const vector<Attribute> &attrs, const string &attrName);
+
+    // Start of the value in tuple, in the format of Value. nullptr if it is null or the attribute is missing.
+    const char *locate(const void *tuple) const;
+
+    // Copy the value out of tuple. Returns index, -1 if the value is null or the attribute is missing.
+    int read(const void *tuple, void *value) const;
+};
 
 bool compareAttr(Attribute &attrL, Attribute &attrR);
 
@@ -41,13 +66,78 @@ void FillAttrValue(void *des, void *srs, int &desOffset, int &srsOffset,  Attrib
 
 void excludeTableName(string &name);
 
+// Bytes of a tuple in the format above, null indicator included
+int getTupleSize(const vector<Attribute> &attrs, const void *data);
+
+// Bytes of the largest tuple the attributes allow
+int getMaxTupleSize(const vector<Attribute> &attrs);
+
+// Index entries to fetch at once when each tuple may take up to tupleSize bytes
+int getFetchBatchSize(int tupleSize);
+
+// The attributes named attrNames, in that order. False if one of them is missing.
+bool getProjectedAttributes(const vector<Attribute> &attrs, const vector<string> &attrNames,
+                            vector<Attribute> &projected);
+
+// Rows of an iterator stored column by column, attribute i of every row is in columns[i].
+// The rows still in are the ones in selection, a Filter only takes rows out of it.
+class Batch {
+public:
+    // values and offsets are laid out as a scan fills them, one entry per row
+    struct Column : public RecordColumn {
+        Attribute attr;
+    };
+
+    std::vector<Column> columns;
+    int rowCount = 0;
+    std::vector<int> selection;         // Rows in order
+    std::vector<char> tuple;            // Room for one tuple, for iterators that fill the batch tuple by tuple
+
+    // Drop the rows and take columns of attrs, the buffers keep their room
+    void reset(const std::vector<Attribute> &attrs);
+
+    // Split the fields of a tuple in the format of insertTuple into the columns from firstColumn on
+    void appendFields(const void *data, int firstColumn, int fieldCount);
+
+    // The row whose fields were appended is complete and selected
+    void endRow() {
+        selection.push_back(rowCount++);
+    };
+
+    void appendTuple(const void *data) {
+        appendFields(data, 0, columns.size());
+        endRow();
+    };
+
+    // Value of a row in a column, nullptr if it is null
+    const char *getValue(int column, int row) const {
+        int offset = columns[column].offsets[row];
+        return offset == -1 ? nullptr : columns[column].values.data() + offset;
+    };
+
+    // Put a row back together in the format of insertTuple, returns its size
+    int getTuple(int row, void *data) const;
+};
+
 class Iterator {
     // All the relational operators and access methods are iterators.
 public:
     virtual RC getNextTuple(void *data) = 0;
 
+    // Up to QE_BATCH_SIZE rows at once, QE_EOF when there are none left. By default the batch is filled
+    // from getNextTuple, so every iterator has one and tuple by tuple iterators work under batch ones.
+    virtual RC getNextBatch(Batch &batch);
+
     virtual void getAttributes(std::vector<Attribute> &attrs) const = 0;
 
+    // Take over a Filter of attrName against a constant so the tuples are dropped further down.
+    // False if the iterator cannot, then the Filter checks every tuple itself.
+    virtual bool pushCondition(const std::string &attrName, CompOp op, const Value &value) { return false; }
+
+    // Return only the attributes attrNames, in that order, so the others are never copied.
+    // False if the iterator cannot, then the tuples keep all of their attributes.
+    virtual bool pushProjection(const std::vector<std::string> &attrNames) { return false; }
+
     virtual ~Iterator() = default;
 };
 
@@ -56,13 +146,18 @@ class TableScan : public Iterator {
 public:
     RelationManager &rm;
     RM_ScanIterator *iter;
+    std::string relation;                       // Table in the catalog, tableName is its alias if one is given
     std::string tableName;
     std::vector<Attribute> attrs;
     std::vector<std::string> attrNames;
+    std::vector<ScanCondition> conditions;      // Pushed down by Filters, the constants are owned copies
+    std::vector<Attribute> batchAttrs;          // attrs named rel.attr, kept for the batches
+    std::vector<RecordColumn *> batchColumns;
     RID rid{};
 
     TableScan(RelationManager &rm, const std::string &tableName, const char *alias = NULL) : rm(rm) {
         //Set members
+        this->relation = tableName;
         this->tableName = tableName;
 
         // Get Attributes from RM
@@ -76,7 +171,7 @@ public:
 
         // Call RM scan to get an iterator
         iter = new RM_ScanIterator();
-        rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+        rm.scan(tableName, conditions, attrNames, *iter);
 
         // Set alias
         if (alias) this->tableName = alias;
@@ -87,13 +182,16 @@ public:
         iter->close();
         delete iter;
         iter = new RM_ScanIterator();
-        rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+        rm.scan(relation, conditions, attrNames, *iter);
     };
 
     RC getNextTuple(void *data) override {
         return iter->getNextTuple(rid, data);
     };
 
+    // The fields go from the table pages straight into the columns
+    RC getNextBatch(Batch &batch) override;
+
     void getAttributes(std::vector<Attribute> &attributes) const override {
         attributes.clear();
         attributes = this->attrs;
@@ -107,15 +205,52 @@ public:
         }
     };
 
+    // The condition is checked on the page, a rejected record is never copied out. Restarts the scan.
+    bool pushCondition(const std::string &attrName, CompOp op, const Value &value) override {
+        if (op == NO_OP || value.data == nullptr) {
+            return false;
+        }
+        for (Attribute &attr : attrs) {
+            if (attr.name == attrName && attr.type == value.type) {
+                int length = sizeof(int);
+                if (attr.type == TypeVarChar) {
+                    length += *(int *) value.data;
+                }
+                void *constant = malloc(length);
+                memcpy(constant, value.data, length);
+                conditions.push_back({attrName, op, constant});
+                setIterator();
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Only the projected attributes are copied out of the page. Restarts the scan.
+    bool pushProjection(const std::vector<std::string> &names) override {
+        std::vector<Attribute> projected;
+        if (!getProjectedAttributes(attrs, names, projected)) {
+            return false;
+        }
+        attrs = projected;
+        attrNames = names;
+        batchAttrs.clear();
+        setIterator();
+        return true;
+    };
+
     ~TableScan() override {
         iter->close();
+        for (ScanCondition &condition : conditions) {
+            free((void *) condition.value);
+        }
     };
 
     void reset() {
         iter->close();
         delete iter;
         iter = new RM_ScanIterator;
-        rm.scan(tableName, "", NO_OP, NULL, attrNames, *iter);
+        rm.scan(relation, conditions, attrNames, *iter);
     };
 };
 
@@ -124,25 +259,48 @@ class IndexScan : public Iterator {
 public:
     RelationManager &rm;
     RM_IndexScanIterator *iter;
+    std::string relation;           // Table in the catalog, tableName is its alias if one is given
     std::string tableName;
     std::string attrName;
+    AttrType keyType;
     std::vector<Attribute> attrs;
+    std::vector<std::string> projectNames;  // Attributes read from the table, empty for all of them
+    std::vector<char> lowKey;       // Range of the last setIterator, empty for an open end
+    std::vector<char> highKey;
+    bool lowKeyInclusive = true;
+    bool highKeyInclusive = true;
     char key[PAGE_SIZE]{};
     RID rid{};
+    int tupleSize;                  // Room for the largest tuple of the table
+    size_t batchSize;
+    std::vector<RID> batchRids;     // Entries of the current batch, in index order
+    std::vector<bool> batchFound;   // Whether the entry still has its tuple
+    char *batchTuples;              // Their tuples, tupleSize apart
+    size_t batchPos = 0;
 
     IndexScan(RelationManager &rm, const std::string &tableName, const std::string &attrName, const char *alias = NULL)
             : rm(rm) {
         // Set members
+        this->relation = tableName;
         this->tableName = tableName;
         this->attrName = attrName;
 
 
         // Get Attributes from RM
         rm.getAttributes(tableName, attrs);
+        keyType = TypeInt;
+        for (const Attribute &attr : attrs) {
+            if (attr.name == attrName) {
+                keyType = attr.type;
+            }
+        }
 
         // Call rm indexScan to get iterator
         iter = new RM_IndexScanIterator();
         rm.indexScan(tableName, attrName, NULL, NULL, true, true, *iter);
+        tupleSize = getMaxTupleSize(attrs);
+        batchSize = getFetchBatchSize(tupleSize);
+        batchTuples = (char *) malloc(batchSize * tupleSize);
 
         // Set alias
         if (alias) this->tableName = alias;
@@ -150,20 +308,52 @@ public:
 
     // Start a new iterator given the new key range
     void setIterator(void *lowKey, void *highKey, bool lowKeyInclusive, bool highKeyInclusive) {
+        saveKey(lowKey, this->lowKey);
+        saveKey(highKey, this->highKey);
+        this->lowKeyInclusive = lowKeyInclusive;
+        this->highKeyInclusive = highKeyInclusive;
+        restartIterator();
+    };
+
+    // Start a new iterator over the key range last set
+    void restartIterator() {
         iter->close();
         delete iter;
         iter = new RM_IndexScanIterator();
-        rm.indexScan(tableName, attrName, lowKey, highKey, lowKeyInclusive, highKeyInclusive, *iter);
+        rm.indexScan(relation, attrName, lowKey.empty() ? NULL : lowKey.data(),
+                     highKey.empty() ? NULL : highKey.data(), lowKeyInclusive, highKeyInclusive, *iter);
+        batchRids.clear();
+        batchPos = 0;
     };
 
-    RC getNextTuple(void *data) override {
-        int rc = iter->getNextEntry(rid, key);
-        if (rc == 0) {
-            rc = rm.readTuple(tableName, rid, data);
+    // Keep a copy of a key of attrName, empty for NULL
+    void saveKey(const void *key, std::vector<char> &copy) {
+        copy.clear();
+        if (key == NULL) {
+            return;
+        }
+        int size = sizeof(int);
+        if (keyType == TypeVarChar) {
+            int length;
+            memcpy(&length, key, sizeof(int));
+            size += length;
+        }
+        copy.insert(copy.end(), (const char *) key, (const char *) key + size);
+    };
+
+    // Take the next batchSize entries from the index and read their tuples, each table page once
+    RC fetchBatch();
+
+    // Read the tuples of rids with the attributes this scan returns, each table page once
+    RC readTuples(const std::vector<RID> &rids, const std::vector<void *> &tuples, std::vector<bool> &found) {
+        if (projectNames.empty()) {
+            return rm.readTuples(relation, rids, tuples, found);
         }
-        return rc;
+        return rm.readTuples(relation, rids, projectNames, tuples, found);
     };
 
+    RC getNextTuple(void *data) override;
+
     void getAttributes(std::vector<Attribute> &attributes) const override {
         attributes.clear();
         attributes = this->attrs;
@@ -178,8 +368,25 @@ public:
         }
     };
 
+    // Only the projected attributes are copied out of the table pages. Restarts the scan over the key range.
+    bool pushProjection(const std::vector<std::string> &names) override {
+        std::vector<Attribute> projected;
+        if (names.empty() || !getProjectedAttributes(attrs, names, projected)) {
+            return false;
+        }
+        attrs = projected;
+        projectNames = names;
+        tupleSize = getMaxTupleSize(attrs);
+        batchSize = getFetchBatchSize(tupleSize);
+        free(batchTuples);
+        batchTuples = (char *) malloc(batchSize * tupleSize);
+        restartIterator();
+        return true;
+    };
+
     ~IndexScan() override {
         iter->close();
+        free(batchTuples);
     };
 };
 
@@ -189,6 +396,8 @@ public:
     Condition condition;
     Iterator *input;
     vector<Attribute> attrs;
+    bool pushedDown;                      // The input drops the tuples that fail the condition
+    AttrPlan lhsPlan;                     // condition.lhsAttr in attrs
 
     Filter(Iterator *input,               // Iterator of input R
            const Condition &condition     // Selection condition
@@ -198,10 +407,19 @@ public:
 
     RC getNextTuple(void *data);
 
+    // Narrows the selection of each input batch, the columns are left as they are
+    RC getNextBatch(Batch &batch) override;
+
     // For attribute in std::vector<Attribute>, name it as rel.attr
     void getAttributes(std::vector<Attribute> &attrs) const override;
 
-    bool compare(void *filterValue, Value rhsValue);
+    // Filters are conjunctive, the condition of one above can move past this one
+    bool pushCondition(const std::string &attrName, CompOp op, const Value &value) override;
+
+    // Only once the input checks the condition, which then needs no attribute here
+    bool pushProjection(const std::vector<std::string> &attrNames) override;
+
+    bool compare(const void *filterValue, const Value &rhsValue);
 };
 
 class Project : public Iterator {
@@ -210,13 +428,20 @@ public:
     Iterator *input;
     vector<Attribute> attrs;
     vector<Attribute> projectAttrs;
+    bool pushedDown;                            // The input returns projectAttrs already
+    vector<int> projectIndex;                   // Position of each of projectAttrs in attrs
+    vector<AttrPlan> projectPlans;              // Where each of projectAttrs is in an input tuple
+    void *tuple;                                // Input tuple being projected
 
     Project(Iterator *input,                    // Iterator of input R
             const std::vector<std::string> &attrNames);   // std::vector containing attribute names
-    ~Project() override = default;
+    ~Project() override;
 
     RC getNextTuple(void *data) override;
 
+    // Picks the columns of each input batch, no value is copied
+    RC getNextBatch(Batch &batch) override;
+
     int getProjectValue(void *projectDataValue, void *page);
 
     // For attribute in std::vector<Attribute>, name it as rel.attr
@@ -231,10 +456,15 @@ public:
     Condition condition;
     unsigned numPages;
     bool BlockLoaded;
-    void *block;
+    void *block;                          // numPages of left tuples, plus a page for the one that overflows
     int blockPtr;
+    int pendingOffset;                    // Offset in block of the tuple left over for the next block
+    int pendingSize;                      // Size of that tuple, 0 if there is none
     void *leftTuple;
     void *rightTuple;
+    AttrPlan lhsPlan;                     // Join attribute in leftAttrs
+    AttrPlan rhsPlan;                     // Join attribute in rightAttrs
+    bool comparable;                      // Both join attributes are there and can be compared
     vector<Attribute> leftAttrs;
     vector<Attribute> rightAttrs;
     RecordBasedFileManager *rbfm;
@@ -257,6 +487,11 @@ public:
 
     RC getNextTuple(void *data) override;
 
+    RC getNextBatch(Batch &batch) override;
+
+    // The left and right tuple of the next result, the join writes them out or splits them into a batch
+    RC getNextMatch(const void *&left, const void *&right);
+
     bool isEqual();
 
     // For attribute in std::vector<Attribute>, name it as rel.attr
@@ -271,11 +506,20 @@ public:
     Condition condition;
     vector<Attribute> leftAttrs;
     vector<Attribute> rightAttrs;
-    bool leftLoaded;
-    void *leftTuple;
     void *leftKey;
-    void *rightTuple;
-    RID rid;
+    AttrPlan lhsPlan;               // Join attribute in leftAttrs
+    int leftSize;                   // Room for the largest left tuple
+    int rightSize;                  // Room for the largest right tuple
+    int batchSize;
+    char *leftTuples;               // Left tuples of the current batch, leftSize apart
+    int leftCount;
+    bool probing;                   // The last left tuple may have more matches in the index
+    bool leftDone;
+    vector<RID> batchRids;          // Matches of the batch, in the order they are joined
+    vector<int> batchLefts;         // Left tuple each of them goes with
+    vector<bool> batchFound;        // Whether the match still has its tuple
+    char *batchTuples;              // Right tuples of the matches, rightSize apart
+    int batchPos;
 
     INLJoin(Iterator *leftIn,           // Iterator of input R
             IndexScan *rightIn,          // IndexScan Iterator of input S
@@ -286,6 +530,15 @@ public:
 
     RC getNextTuple(void *data) override;
 
+    RC getNextBatch(Batch &batch) override;
+
+    // The left and right tuple of the next result, the join writes them out or splits them into a batch
+    RC getNextMatch(const void *&left, const void *&right);
+
+    // Look up the next left tuples until batchSize matches are found, then read the matching
+    // tuples together so that each page of the right table is read once per batch
+    RC fetchBatch();
+
     // For attribute in std::vector<Attribute>, name it as rel.attr
     void getAttributes(std::vector<Attribute> &attrs) const override;
 };
@@ -294,18 +547,65 @@ public:
 class GHJoin : public Iterator {
     // Grace hash join operator
 public:
+    Iterator *leftIn;
+    Iterator *rightIn;
+    Condition condition;
+    unsigned numPartitions;
+    vector<Attribute> leftAttrs;
+    vector<Attribute> rightAttrs;
+    vector<Attribute> leftRecordAttrs;      // Of the partition files, named by position since joins repeat names
+    vector<Attribute> rightRecordAttrs;
+    vector<string> leftRecordNames;
+    vector<string> rightRecordNames;
+    string leftPrefix;                      // Partition files are the prefix followed by the partition number
+    string rightPrefix;
+    vector<string> partitionFiles;          // Created by this join, destroyed with it
+    bool partitioned;
+    RC failure;                             // First error of the join, every later call returns it again
+    int partition;                          // Partition being joined, -1 before the first one
+    void *leftTuple;
+    void *rightTuple;
+    AttrPlan leftPlan;                      // Join attribute in leftAttrs
+    AttrPlan rightPlan;                     // Join attribute in rightAttrs
+    bool joinable;                          // Both join attributes are there
+    string key;
+    vector<char> partitionTuples;           // Left tuples of the partition, one after another
+    unordered_multimap<string, int> hashTable;              // Join key to the left tuples carrying it
+    unordered_multimap<string, int>::iterator match;        // Left tuples still to join with the right tuple
+    unordered_multimap<string, int>::iterator matchEnd;
+    FileHandle rightHandle;
+    RBFM_ScanIterator rightScan;
+    bool probing;                           // rightScan is open over the right partition
+
+    static unsigned joinCount;              // With the process id, keeps the partition files of joins apart
+
     GHJoin(Iterator *leftIn,               // Iterator of input R
            Iterator *rightIn,               // Iterator of input S
            const Condition &condition,      // Join condition (CompOp is always EQ)
            const unsigned numPartitions     // # of partitions for each relation (decided by the optimizer)
-    ) {};
+    );
+
+    ~GHJoin() override;
+
+    RC getNextTuple(void *data) override;
+
+    RC getNextBatch(Batch &batch) override;
 
-    ~GHJoin() override = default;
+    // The left and right tuple of the next result, the join writes them out or splits them into a batch
+    RC getNextMatch(const void *&left, const void *&right);
 
-    RC getNextTuple(void *data) override { return QE_EOF; };
+    // Spread the tuples of the input over its partition files by the hash of the join key
+    RC partitionInput(Iterator *input, const vector<Attribute> &attrs, const vector<Attribute> &recordAttrs,
+                      const AttrPlan &keyPlan, const string &prefix);
+
+    // Build the hash table over the current left partition and start scanning the right one
+    RC loadPartition();
+
+    // The join key of a tuple, tagged with its type. False when the attribute is null.
+    bool getJoinKey(const AttrPlan &keyPlan, const void *tuple);
 
     // For attribute in std::vector<Attribute>, name it as rel.attr
-    void getAttributes(std::vector<Attribute> &attrs) const override {};
+    void getAttributes(std::vector<Attribute> &attrs) const override;
 };
 
 class GroupAttr {
@@ -350,7 +650,8 @@ public:
 
     void buildAggResult();
 
-    RC getAttrValueByName(const void *data, vector<Attribute> &attrs, string &attrName, void *value);
+    // Add an aggregated value to the result of its group, groupVal is nullptr when there is no grouping
+    void accumulate(const char *value, const char *groupVal);
 
     Iterator *input;
     int current = 0;
@@ -370,8 +671,12 @@ public:
     unordered_map<string, GroupAttr>::iterator vcharIter;
     unordered_map<float, GroupAttr>::iterator fltIter;
     unordered_map<int, GroupAttr>::iterator itgIter;
+    string groupKey;                    // VarChar group of the current row, reused to look up its group
 };
 
+// Order of two VarChars with their lengths in front, compared in place as strings would be
+int compareVarChar(const void *compValue, const void *compKey);
+
 bool compareEqual(Attribute &attr, const void *compValue, const void *compKey);
 int compareLess(Attribute &attr, const void *compValue, const void *compKey);
 int compareLarge(Attribute &attr, const void *compValue, const void *compKey);
@@ -6,7 +6,9 @@
 const int fail = -1;
 #endif
 
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <iostream>
 
 #include <vector>
@@ -1114,6 +1116,77 @@ int deleteAndCreateCatalog() {
     return rc;
 }
 
-#endif
+// Hides the iterator below from the operators above. Nothing is pushed down into it, and its batches
+// are filled through getNextTuple, the way operators worked before they could do better.
+class OpaqueScan : public Iterator {
+public:
+    Iterator *input;
+
+    explicit OpaqueScan(Iterator *input) : input(input) {}
+
+    RC getNextTuple(void *data) override {
+        return input->getNextTuple(data);
+    };
+
+    void getAttributes(std::vector<Attribute> &attrs) const override {
+        input->getAttributes(attrs);
+    };
+};
+
+Attribute makeAttribute(const std::string &name, AttrType type, AttrLength length = 4) {
+    Attribute attr;
+    attr.name = name;
+    attr.type = type;
+    attr.length = length;
+    return attr;
+}
+
+// Create tableName and insert rows tuples at once, writeTuple(i, tuple) writes tuple i in the format of insertTuple
+int createFilledTable(const std::string &tableName, const std::vector<Attribute> &attrs, int rows,
+                      const std::function<void(int, char *)> &writeTuple) {
+    RC rc = rm.createTable(tableName, attrs);
+    if (rc != success) {
+        return rc;
+    }
+    int tupleSize = getMaxTupleSize(attrs);
+    char *tuples = (char *) malloc((size_t) rows * tupleSize);
+    std::vector<const void *> data;
+    for (int i = 0; i < rows; i++) {
+        char *tuple = tuples + (size_t) i * tupleSize;
+        writeTuple(i, tuple);
+        data.push_back(tuple);
+    }
+    std::vector<RID> rids;
+    rc = rm.insertTuples(tableName, data, rids);
+    free(tuples);
+    return rc;
+}
 
+// attr op value
+Condition constantCondition(const std::string &attr, CompOp op, AttrType type, void *value) {
+    Condition cond;
+    cond.lhsAttr = attr;
+    cond.op = op;
+    cond.bRhsIsAttr = false;
+    cond.rhsValue.type = type;
+    cond.rhsValue.data = value;
+    return cond;
+}
 
+// lhsAttr = rhsAttr
+Condition joinCondition(const std::string &lhsAttr, const std::string &rhsAttr) {
+    Condition cond;
+    cond.lhsAttr = lhsAttr;
+    cond.op = EQ_OP;
+    cond.bRhsIsAttr = true;
+    cond.rhsAttr = rhsAttr;
+    return cond;
+}
+
+// Milliseconds since start
+double elapsedMs(const std::chrono::steady_clock::time_point &start) {
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+#endif
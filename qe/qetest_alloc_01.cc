@@ -0,0 +1,200 @@
+#include "qe_test_util.h"
+
+// Tuples in the alloc table
+const int allocTupleCount = 20000;
+
+// Tuples of the table the join runs on, BNLJoin compares every pair so it gets a small one
+const int allocJoinCount = 500;
+
+// Distinct groups in the alloc table, each name is too long to fit into a string without allocating
+const int allocGroupCount = 20;
+
+// Allocations seen since the start, counted by the hook below
+size_t allocations = 0;
+
+#if defined(__SANITIZE_ADDRESS__)
+// The sanitizer owns malloc, it reports each allocation to the installed hook instead
+extern "C" int __sanitizer_install_malloc_and_free_hooks(void (*mallocHook)(const volatile void *, size_t),
+                                                         void (*freeHook)(const volatile void *));
+
+void countMalloc(const volatile void *ptr, size_t size) {
+    allocations++;
+}
+
+void countFree(const volatile void *ptr) {
+}
+
+bool installAllocHook() {
+    return __sanitizer_install_malloc_and_free_hooks(countMalloc, countFree) != 0;
+}
+#else
+// malloc is replaced, new goes through it as well
+extern "C" void *__libc_malloc(size_t size);
+
+extern "C" void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+bool installAllocHook() {
+    return true;
+}
+#endif
+
+// alloc(A, B, C): A = i, B = "group-name-number-" followed by i % 20 in two digits, C = i / 2
+int createAllocTable(const std::string &tableName, int rows) {
+    std::cerr << std::endl << "****Create " << tableName << " Table****" << std::endl;
+
+    std::vector<Attribute> attrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeVarChar, 30),
+                                 makeAttribute("C", TypeReal)};
+    return createFilledTable(tableName, attrs, rows, [](int i, char *tuple) {
+        char group[32];
+        int length = snprintf(group, sizeof(group), "group-name-number-%02d", i % allocGroupCount);
+        auto c = (float) i / 2;
+        int offset = 0;
+        tuple[offset] = 0;
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, group, length);
+        offset += length;
+        memcpy(tuple + offset, &c, sizeof(float));
+    });
+}
+
+// Run the iterator to the end, counting its results and the allocations they took. -1 if it fails.
+int drain(Iterator *iterator, size_t &allocated) {
+    void *data = malloc(bufSize);
+    int count = 0;
+    size_t before = allocations;
+    RC rc;
+    while ((rc = iterator->getNextTuple(data)) == success) {
+        count++;
+    }
+    allocated = allocations - before;
+    free(data);
+    if (rc != QE_EOF) {
+        std::cerr << "***** The iterator failed with " << rc << ". *****" << std::endl;
+        return -1;
+    }
+    return count;
+}
+
+// Allocations of the operator per result, what its input allocates for the same tuples is taken off
+RC checkAllocations(const std::string &query, int count, int expected, size_t allocated, size_t inputAllocated,
+                    double ms) {
+    if (count != expected) {
+        std::cerr << "***** " << query << " returned " << count << " tuples, it should be " << expected
+                  << ". *****" << std::endl;
+        return fail;
+    }
+    size_t own = allocated > inputAllocated ? allocated - inputAllocated : 0;
+    double perTuple = (double) own / count;
+    std::cerr << query << ": " << count << " tuples, " << perTuple << " allocations per tuple (" << allocated
+              << " in all, " << inputAllocated << " by the input), " << ms << " ms" << std::endl;
+    // A few allocations of the whole run are fine, one per tuple is not
+    if (perTuple >= 0.1) {
+        std::cerr << "***** " << query << " allocates per tuple. *****" << std::endl;
+        return fail;
+    }
+    return success;
+}
+
+RC testCase_alloc_1() {
+    // Functions Tested
+    // 1. Filter checking every tuple allocates nothing per tuple **
+    // 2. BNLJoin allocates nothing per comparison or result **
+    // 3. Aggregate grouped on a VarChar allocates per group, not per tuple **
+    // 4. Allocations per result of each operator
+    std::cerr << std::endl << "***** In QE Test Alloc Case 01 *****" << std::endl;
+
+    if (!installAllocHook()) {
+        std::cerr << "***** The allocation hook could not be installed. *****" << std::endl;
+        return fail;
+    }
+    rm.deleteTable("alloc");
+    rm.deleteTable("allocjoin");
+    if (createAllocTable("alloc", allocTupleCount) != success ||
+        createAllocTable("allocjoin", allocJoinCount) != success) {
+        std::cerr << "***** Creating the alloc tables failed. *****" << std::endl;
+        return fail;
+    }
+
+    // What the scan allocates by itself for the whole table
+    size_t scanAllocated;
+    auto *tableScan = new TableScan(rm, "alloc");
+    drain(tableScan, scanAllocated);
+    delete tableScan;
+
+    // SELECT * FROM alloc WHERE A < 10000
+    int aValue = allocTupleCount / 2;
+    tableScan = new TableScan(rm, "alloc");
+    auto *opaqueScan = new OpaqueScan(tableScan);
+    auto *filter = new Filter(opaqueScan, constantCondition("alloc.A", LT_OP, TypeInt, &aValue));
+    size_t allocated;
+    auto start = std::chrono::steady_clock::now();
+    int count = drain(filter, allocated);
+    RC rc = checkAllocations("Filter", count, aValue, allocated, scanAllocated, elapsedMs(start));
+    delete filter;
+    delete opaqueScan;
+    delete tableScan;
+
+    // SELECT * FROM allocjoin, allocjoin WHERE allocjoin.A = allocjoin.A, the right one is scanned once per block
+    if (rc == success) {
+        size_t joinScanAllocated;
+        tableScan = new TableScan(rm, "allocjoin");
+        drain(tableScan, joinScanAllocated);
+        delete tableScan;
+
+        auto *leftIn = new TableScan(rm, "allocjoin");
+        auto *rightIn = new TableScan(rm, "allocjoin");
+        auto *bnlJoin = new BNLJoin(leftIn, rightIn, joinCondition("allocjoin.A", "allocjoin.A"), 10);
+        start = std::chrono::steady_clock::now();
+        count = drain(bnlJoin, allocated);
+        rc = checkAllocations("BNLJoin", count, allocJoinCount, allocated, 2 * joinScanAllocated, elapsedMs(start));
+        delete bnlJoin;
+        delete leftIn;
+        delete rightIn;
+    }
+
+    // SELECT B, COUNT(C) FROM alloc GROUP BY B, the groups are collected on construction
+    if (rc == success) {
+        Attribute aggAttr = makeAttribute("alloc.C", TypeReal);
+        Attribute groupAttr = makeAttribute("alloc.B", TypeVarChar, 30);
+        tableScan = new TableScan(rm, "alloc");
+        opaqueScan = new OpaqueScan(tableScan);
+        size_t before = allocations;
+        start = std::chrono::steady_clock::now();
+        auto *agg = new Aggregate(opaqueScan, aggAttr, groupAttr, COUNT);
+        size_t built = allocations - before;
+        int groups = drain(agg, allocated);
+        double ms = elapsedMs(start);
+        // Per input tuple here, as the input is what the aggregate goes through
+        rc = checkAllocations("Aggregate", allocTupleCount, allocTupleCount, built + allocated, scanAllocated, ms);
+        if (rc == success && groups != allocGroupCount) {
+            std::cerr << "***** Aggregate returned " << groups << " groups, it should be " << allocGroupCount
+                      << ". *****" << std::endl;
+            rc = fail;
+        }
+        delete agg;
+        delete opaqueScan;
+        delete tableScan;
+    }
+
+    rm.deleteTable("alloc");
+    rm.deleteTable("allocjoin");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_alloc_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Alloc Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Alloc Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
@@ -0,0 +1,266 @@
+#include "qe_test_util.h"
+
+// Tuples in the batch table, enough for many batches
+const int batchTupleCount = 30000;
+
+// Tuples in the table joined with it
+const int batchJoinCount = 600;
+
+// The iterators of a query, the last one is the top. They are deleted top first.
+typedef std::vector<Iterator *> Plan;
+
+void deletePlan(Plan &plan) {
+    for (auto it = plan.rbegin(); it != plan.rend(); it++) {
+        delete *it;
+    }
+    plan.clear();
+}
+
+// batch(A, B, C): A = i, B = i % 50 times 'x', C = i / 4 or null for every seventh tuple
+// batchleft(A, B): A = i, B = i * 31 % batchTupleCount
+int createBatchTables() {
+    std::cerr << std::endl << "****Create Batch Tables****" << std::endl;
+
+    std::vector<Attribute> attrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeVarChar, 50),
+                                 makeAttribute("C", TypeReal)};
+    RC rc = createFilledTable("batch", attrs, batchTupleCount, [](int i, char *tuple) {
+        int length = i % 50;
+        auto c = (float) i / 4;
+        int offset = 0;
+        tuple[offset] = i % 7 == 0 ? 1 << 5 : 0;
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'x', length);
+        offset += length;
+        if (i % 7 != 0) {
+            memcpy(tuple + offset, &c, sizeof(float));
+        }
+    });
+    if (rc != success) {
+        return rc;
+    }
+    rc = rm.createIndex("batch", "A");
+    if (rc != success) {
+        return rc;
+    }
+
+    attrs = {makeAttribute("A", TypeInt), makeAttribute("B", TypeInt)};
+    return createFilledTable("batchleft", attrs, batchJoinCount, [](int i, char *tuple) {
+        int b = i * 31 % batchTupleCount;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &i, sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &b, sizeof(int));
+    });
+}
+
+// Every tuple of the top iterator, through getNextTuple or getNextBatch
+RC collectTuples(Iterator *top, bool batched, std::vector<std::string> &tuples) {
+    std::vector<Attribute> attrs;
+    top->getAttributes(attrs);
+    char *data = (char *) malloc(PAGE_SIZE);
+    tuples.clear();
+    RC rc;
+    if (batched) {
+        Batch batch;
+        while ((rc = top->getNextBatch(batch)) == success) {
+            if (batch.columns.size() != attrs.size() || batch.selection.empty()) {
+                std::cerr << "***** A batch has " << batch.columns.size() << " columns and "
+                          << batch.selection.size() << " selected rows. *****" << std::endl;
+                free(data);
+                return fail;
+            }
+            for (int row : batch.selection) {
+                int size = batch.getTuple(row, data);
+                tuples.emplace_back(data, size);
+            }
+        }
+    } else {
+        while ((rc = top->getNextTuple(data)) == success) {
+            tuples.emplace_back(data, getTupleSize(attrs, data));
+        }
+    }
+    free(data);
+    if (rc != QE_EOF) {
+        std::cerr << "***** The query failed with " << rc << ". *****" << std::endl;
+        return fail;
+    }
+    return success;
+}
+
+// Run the query once tuple by tuple and once batch by batch, both have to return expected tuples in the same order
+RC compareQuery(const std::string &query, const std::function<Plan()> &makePlan, int expected) {
+    std::vector<std::string> tuples;
+    std::vector<std::string> batchTuples;
+
+    Plan plan = makePlan();
+    auto start = std::chrono::steady_clock::now();
+    RC rc = collectTuples(plan.back(), false, tuples);
+    double tupleMs = elapsedMs(start);
+    deletePlan(plan);
+
+    plan = makePlan();
+    start = std::chrono::steady_clock::now();
+    if (rc == success) {
+        rc = collectTuples(plan.back(), true, batchTuples);
+    }
+    double batchMs = elapsedMs(start);
+    deletePlan(plan);
+
+    if (rc == success && (tuples.size() != expected || batchTuples != tuples)) {
+        std::cerr << "***** " << query << " returned " << tuples.size() << " tuples and " << batchTuples.size()
+                  << " in batches, it should be " << expected << " of each. *****" << std::endl;
+        rc = fail;
+    }
+    if (rc == success) {
+        std::cerr << query << ": getNextTuple " << tupleMs << " ms, getNextBatch " << batchMs << " ms" << std::endl;
+    }
+    return rc;
+}
+
+// The single tuple of an aggregate, through getNextBatch
+RC batchAggregate(Iterator *input, const std::string &attr, AttrType type, AggregateOp op, float &result) {
+    Attribute aggAttr;
+    aggAttr.name = attr;
+    aggAttr.type = type;
+    aggAttr.length = 4;
+    auto *agg = new Aggregate(input, aggAttr, op);
+    Batch batch;
+    RC rc = agg->getNextBatch(batch);
+    if (rc == success && batch.selection.size() == 1) {
+        memcpy(&result, batch.getValue(0, batch.selection[0]), sizeof(float));
+    } else {
+        rc = fail;
+    }
+    delete agg;
+    return rc;
+}
+
+RC testCase_batch_1() {
+    // Functions Tested
+    // 1. getNextBatch of TableScan, Filter and Project, with and without pushdown **
+    // 2. getNextBatch filled from getNextTuple under a Filter and a Project **
+    // 3. getNextBatch of BNLJoin, INLJoin and GHJoin **
+    // 4. Aggregate reading its input in batches **
+    // 5. Time of the queries tuple by tuple and batch by batch
+    std::cerr << std::endl << "***** In QE Test Batch Case 01 *****" << std::endl;
+
+    rm.deleteTable("batch");
+    rm.deleteTable("batchleft");
+    if (createBatchTables() != success) {
+        std::cerr << "***** Creating the batch tables failed. *****" << std::endl;
+        return fail;
+    }
+
+    // C is null for every seventh A, which no comparison keeps
+    float cValue = 5000;
+    int cExpected = 0;
+    for (int i = 0; i < batchTupleCount; i++) {
+        cExpected += i % 7 != 0 && (float) i / 4 >= cValue;
+    }
+
+    // SELECT * FROM batch
+    RC rc = compareQuery("SELECT * FROM batch", []() {
+        return Plan{new TableScan(rm, "batch")};
+    }, batchTupleCount);
+
+    // SELECT * FROM batch WHERE C >= 5000, checked by the Filter
+    if (rc == success) {
+        rc = compareQuery("SELECT * FROM batch WHERE C >= 5000", [&cValue]() {
+            auto *tableScan = new TableScan(rm, "batch");
+            auto *opaqueScan = new OpaqueScan(tableScan);
+            auto *filter = new Filter(opaqueScan, constantCondition("batch.C", GE_OP, TypeReal, &cValue));
+            return Plan{tableScan, opaqueScan, filter};
+        }, cExpected);
+    }
+
+    // SELECT B, C FROM batch WHERE C >= 5000, both pushed down
+    if (rc == success) {
+        rc = compareQuery("SELECT B, C FROM batch WHERE C >= 5000 pushed down", [&cValue]() {
+            auto *tableScan = new TableScan(rm, "batch");
+            auto *filter = new Filter(tableScan, constantCondition("batch.C", GE_OP, TypeReal, &cValue));
+            auto *project = new Project(filter, {"batch.B", "batch.C"});
+            return Plan{tableScan, filter, project};
+        }, cExpected);
+    }
+
+    // SELECT A FROM batch, picked by the Project
+    if (rc == success) {
+        rc = compareQuery("SELECT A FROM batch", []() {
+            auto *tableScan = new TableScan(rm, "batch");
+            auto *opaqueScan = new OpaqueScan(tableScan);
+            auto *project = new Project(opaqueScan, {"batch.A"});
+            return Plan{tableScan, opaqueScan, project};
+        }, batchTupleCount);
+    }
+
+    // SELECT * FROM batchleft, batchleft WHERE batchleft.A = batchleft.A.
+    // BNLJoin compares every pair, so it gets the small table on both sides.
+    Condition cond = joinCondition("batchleft.A", "batchleft.A");
+    if (rc == success) {
+        rc = compareQuery("BNLJoin", [&cond]() {
+            auto *leftIn = new TableScan(rm, "batchleft");
+            auto *rightIn = new TableScan(rm, "batchleft");
+            auto *join = new BNLJoin(leftIn, rightIn, cond, 10);
+            return Plan{leftIn, rightIn, join};
+        }, batchJoinCount);
+    }
+
+    // SELECT * FROM batchleft, batch WHERE batchleft.B = batch.A
+    cond = joinCondition("batchleft.B", "batch.A");
+    if (rc == success) {
+        rc = compareQuery("INLJoin", [&cond]() {
+            auto *leftIn = new TableScan(rm, "batchleft");
+            auto *rightIn = new IndexScan(rm, "batch", "A");
+            auto *join = new INLJoin(leftIn, rightIn, cond);
+            return Plan{leftIn, rightIn, join};
+        }, batchJoinCount);
+    }
+    if (rc == success) {
+        rc = compareQuery("GHJoin", [&cond]() {
+            auto *leftIn = new TableScan(rm, "batchleft");
+            auto *rightIn = new TableScan(rm, "batch");
+            auto *join = new GHJoin(leftIn, rightIn, cond, 5);
+            return Plan{leftIn, rightIn, join};
+        }, batchJoinCount);
+    }
+
+    // SELECT MAX(A), COUNT(C) FROM batch, over batches of the scan and batches filled tuple by tuple
+    float max = 0, count = 0;
+    if (rc == success) {
+        auto *tableScan = new TableScan(rm, "batch");
+        rc = batchAggregate(tableScan, "batch.A", TypeInt, MAX, max);
+        delete tableScan;
+    }
+    if (rc == success) {
+        auto *tableScan = new TableScan(rm, "batch");
+        auto *opaqueScan = new OpaqueScan(tableScan);
+        rc = batchAggregate(opaqueScan, "batch.C", TypeReal, COUNT, count);
+        delete opaqueScan;
+        delete tableScan;
+    }
+    auto expectedMax = (float) (batchTupleCount - 1);
+    auto expectedCount = (float) (batchTupleCount - (batchTupleCount + 6) / 7);
+    if (rc == success && (max != expectedMax || count != expectedCount)) {
+        std::cerr << "***** MAX(A) is " << max << " and COUNT(C) " << count << " instead of " << expectedMax
+                  << " and " << expectedCount << ". *****" << std::endl;
+        rc = fail;
+    }
+
+    rm.deleteTable("batch");
+    rm.deleteTable("batchleft");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_batch_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Batch Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Batch Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
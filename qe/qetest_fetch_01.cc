@@ -0,0 +1,231 @@
+#include <chrono>
+
+#include "qe_test_util.h"
+
+// Tuples in the table, stored in A order while B follows a shuffle of A
+const int fetchTupleCount = 20000;
+
+// Frames in the buffer pool while the scans run, a fraction of the table
+const unsigned fetchPoolSize = 64;
+
+int createFetchTable(std::vector<int> &bValues) {
+    // Functions Tested;
+    // 1. Create Table
+    // 2. Insert Tuples
+    // 3. Create Index
+    std::cerr << std::endl << "****Create Fetch Table****" << std::endl;
+
+    std::vector<Attribute> attrs;
+    Attribute attr;
+    attr.name = "A";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+
+    attr.name = "B";
+    attr.type = TypeInt;
+    attr.length = 4;
+    attrs.push_back(attr);
+
+    attr.name = "C";
+    attr.type = TypeVarChar;
+    attr.length = 60;
+    attrs.push_back(attr);
+
+    RC rc = rm.createTable("fetch", attrs);
+    if (rc != success) {
+        return rc;
+    }
+
+    // Three tuples share each value of B, their rids lie on unrelated pages
+    std::vector<int> order;
+    for (int i = 0; i < fetchTupleCount; i++) {
+        order.push_back(i);
+    }
+    srand(19);
+    for (int i = fetchTupleCount - 1; i > 0; i--) {
+        std::swap(order[i], order[rand() % (i + 1)]);
+    }
+    bValues.clear();
+    for (int i = 0; i < fetchTupleCount; i++) {
+        bValues.push_back(order[i] / 3);
+    }
+
+    int length = attrs[2].length;
+    int tupleSize = 1 + 3 * sizeof(int) + length;
+    char *tuples = (char *) malloc(fetchTupleCount * tupleSize);
+    std::vector<const void *> data;
+    for (int i = 0; i < fetchTupleCount; i++) {
+        char *tuple = tuples + i * tupleSize;
+        int offset = 0;
+        tuple[offset] = 0;
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &bValues[i], sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'a' + i % 26, length);
+        data.push_back(tuple);
+    }
+    std::vector<RID> rids;
+    rc = rm.insertTuples("fetch", data, rids);
+    free(tuples);
+    if (rc != success) {
+        return rc;
+    }
+
+    rc = rm.createIndex("fetch", "B");
+    if (rc == success) {
+        std::cerr << "****Fetch Table Created!****" << std::endl;
+    }
+    return rc;
+}
+
+RC testCase_fetch_1() {
+    // Functions Tested
+    // 1. IndexScan over an index whose order has nothing to do with the table's **
+    // 2. INLJoin with several matches per left tuple, spread over more than one batch **
+    // 3. Buffer pool misses and time of the batched fetch against one readTuple per entry
+    std::cerr << std::endl << "***** In QE Test Fetch Case 01 *****" << std::endl;
+
+    BufferManager &bm = BufferManager::instance();
+    std::vector<int> bValues;
+    rm.deleteTable("fetch");
+    RC rc = createFetchTable(bValues);
+    if (rc != success) {
+        std::cerr << "***** Creating the fetch table failed. *****" << std::endl;
+        return fail;
+    }
+    rc = bm.resize(fetchPoolSize);
+    assert(rc == success && "Resizing an idle buffer pool should not fail.");
+
+    unsigned hit, miss, evict;
+    unsigned missBefore;
+    void *data = malloc(bufSize);
+
+    // One readTuple per index entry, as the scan used to do
+    RM_IndexScanIterator rmIter;
+    RID rid;
+    char key[PAGE_SIZE];
+    int entryCount = 0;
+    bm.collectCounterValues(hit, missBefore, evict);
+    auto start = std::chrono::steady_clock::now();
+    rm.indexScan("fetch", "B", NULL, NULL, true, true, rmIter);
+    while (rmIter.getNextEntry(rid, key) == success) {
+        if (rm.readTuple("fetch", rid, data) != success) {
+            rc = fail;
+            break;
+        }
+        entryCount++;
+    }
+    rmIter.close();
+    auto end = std::chrono::steady_clock::now();
+    bm.collectCounterValues(hit, miss, evict);
+    unsigned entryMisses = miss - missBefore;
+    double entryMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // The same scan through IndexScan, whose tuples come in batches read in page order
+    std::vector<bool> seen(fetchTupleCount, false);
+    int batchCount = 0;
+    int lastB = -1;
+    bm.collectCounterValues(hit, missBefore, evict);
+    start = std::chrono::steady_clock::now();
+    auto *indexScan = new IndexScan(rm, "fetch", "B");
+    RC scanRc = QE_EOF;
+    while (rc == success && (scanRc = indexScan->getNextTuple(data)) == success) {
+        int a = *(int *) ((char *) data + 1);
+        int b = *(int *) ((char *) data + 1 + sizeof(int));
+        if (a < 0 || a >= fetchTupleCount || seen[a] || b != bValues[a] || b < lastB) {
+            std::cerr << "***** IndexScan returned A " << a << ", B " << b << " out of place. *****" << std::endl;
+            rc = fail;
+            break;
+        }
+        seen[a] = true;
+        lastB = b;
+        batchCount++;
+    }
+    if (rc == success && scanRc != QE_EOF) {
+        std::cerr << "***** IndexScan failed with " << scanRc << ". *****" << std::endl;
+        rc = fail;
+    }
+    delete indexScan;
+    end = std::chrono::steady_clock::now();
+    bm.collectCounterValues(hit, miss, evict);
+    unsigned batchMisses = miss - missBefore;
+    double batchMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    if (rc == success && (entryCount != fetchTupleCount || batchCount != fetchTupleCount)) {
+        std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+        rc = fail;
+    }
+    if (rc == success) {
+        std::cerr << "readTuple per entry: " << entryMisses << " buffer misses, " << entryMs << " ms" << std::endl;
+        std::cerr << "IndexScan batches:   " << batchMisses << " buffer misses, " << batchMs << " ms" << std::endl;
+        if (batchMisses >= entryMisses) {
+            std::cerr << "***** Batched fetch should read fewer pages. *****" << std::endl;
+            rc = fail;
+        }
+    }
+
+    // SELECT * FROM fetch, fetch WHERE fetch.A = fetch.B, every right tuple matches exactly one left tuple
+    if (rc == success) {
+        auto *leftIn = new TableScan(rm, "fetch");
+        auto *rightIn = new IndexScan(rm, "fetch", "B");
+        Condition cond;
+        cond.lhsAttr = "fetch.A";
+        cond.op = EQ_OP;
+        cond.bRhsIsAttr = true;
+        cond.rhsAttr = "fetch.B";
+        auto *inlJoin = new INLJoin(leftIn, rightIn, cond);
+
+        seen.assign(fetchTupleCount, false);
+        int joinCount = 0;
+        int length = 60;
+        RC joinRc;
+        while ((joinRc = inlJoin->getNextTuple(data)) == success) {
+            int offset = 1;
+            int leftA = *(int *) ((char *) data + offset);
+            offset += 2 * sizeof(int) + sizeof(int) + length;
+            int rightA = *(int *) ((char *) data + offset);
+            offset += sizeof(int);
+            int rightB = *(int *) ((char *) data + offset);
+            if (rightA < 0 || rightA >= fetchTupleCount || seen[rightA] || rightB != leftA ||
+                rightB != bValues[rightA]) {
+                std::cerr << "***** INLJoin matched A " << leftA << " with B " << rightB << ". *****" << std::endl;
+                rc = fail;
+                break;
+            }
+            seen[rightA] = true;
+            joinCount++;
+        }
+        if (rc == success && joinRc != QE_EOF) {
+            std::cerr << "***** INLJoin failed with " << joinRc << ". *****" << std::endl;
+            rc = fail;
+        }
+        if (rc == success && joinCount != fetchTupleCount) {
+            std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+            rc = fail;
+        }
+        delete inlJoin;
+        delete leftIn;
+        delete rightIn;
+    }
+
+    free(data);
+    bm.resize(BUFFER_POOL_SIZE);
+    rm.deleteTable("fetch");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_fetch_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Fetch Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Fetch Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
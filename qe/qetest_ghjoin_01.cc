@@ -0,0 +1,240 @@
+#include <algorithm>
+
+#include "qe_test_util.h"
+
+// Rows of the tables both joins run on, BNLJoin compares every pair so it gets small ones
+const int smallJoinCount = 1000;
+
+// Rows of the tables only GHJoin runs on
+const int largeJoinCount = 100000;
+
+// ghleft(A, B, C): A = i, B = i % (rows / 2), so each B appears twice
+// ghright(B, C, D): B = i * 7 % rows, D = i, so half of the rows find two partners
+int createJoinTables(const std::string &suffix, int rows) {
+    std::cerr << std::endl << "****Create Join Tables of " << rows << " Rows****" << std::endl;
+
+    std::vector<Attribute> leftAttrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeInt),
+                                     makeAttribute("C", TypeReal)};
+    RC rc = createFilledTable("ghleft" + suffix, leftAttrs, rows, [rows](int i, char *tuple) {
+        int b = i % (rows / 2);
+        auto c = (float) b;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &i, sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &b, sizeof(int));
+        memcpy(tuple + 1 + 2 * sizeof(int), &c, sizeof(float));
+    });
+    if (rc != success) {
+        return rc;
+    }
+
+    std::vector<Attribute> rightAttrs{makeAttribute("B", TypeInt), makeAttribute("C", TypeReal),
+                                      makeAttribute("D", TypeInt)};
+    return createFilledTable("ghright" + suffix, rightAttrs, rows, [rows](int i, char *tuple) {
+        auto b = (int) ((long long) i * 7 % rows);
+        auto c = (float) b;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &b, sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &c, sizeof(float));
+        memcpy(tuple + 1 + sizeof(int) + sizeof(float), &i, sizeof(int));
+    });
+}
+
+// Run the join to the end and collect (left.A, right.D) of every result. -1 when a result joins unequal keys
+// or the join fails.
+RC collectJoin(Iterator *join, std::vector<std::pair<int, int>> &results) {
+    void *data = malloc(bufSize);
+    RC rc = success;
+    RC joinRc;
+    results.clear();
+    while ((joinRc = join->getNextTuple(data)) == success) {
+        // left.A, left.B, left.C, right.B, right.C, right.D
+        int offset = 1;
+        int leftA = *(int *) ((char *) data + offset);
+        offset += sizeof(int);
+        int leftB = *(int *) ((char *) data + offset);
+        offset += 2 * sizeof(int);
+        int rightB = *(int *) ((char *) data + offset);
+        offset += 2 * sizeof(int);
+        int rightD = *(int *) ((char *) data + offset);
+        if (leftB != rightB) {
+            std::cerr << "***** Joined left.B " << leftB << " with right.B " << rightB << ". *****" << std::endl;
+            rc = fail;
+            break;
+        }
+        results.emplace_back(leftA, rightD);
+    }
+    free(data);
+    if (rc == success && joinRc != QE_EOF) {
+        std::cerr << "***** The join failed with " << joinRc << ". *****" << std::endl;
+        rc = fail;
+    }
+    return rc;
+}
+
+// ghleft.B = ghright.B on the tables of suffix
+Condition joinOnB(const std::string &suffix) {
+    return joinCondition("ghleft" + suffix + ".B", "ghright" + suffix + ".B");
+}
+
+RC testCase_ghjoin_1() {
+    // Functions Tested
+    // 1. GHJoin returns the same pairs as BNLJoin **
+    // 2. GHJoin on 100k x 100k rows, with every partition file gone afterwards **
+    // 3. A partition file already there is left alone, and the join fails **
+    // 4. An unknown join attribute is an error, not an empty result **
+    // 5. Time of both joins
+    std::cerr << std::endl << "***** In QE Test GHJoin Case 01 *****" << std::endl;
+
+    rm.deleteTable("ghleft_s");
+    rm.deleteTable("ghright_s");
+    rm.deleteTable("ghleft_l");
+    rm.deleteTable("ghright_l");
+    if (createJoinTables("_s", smallJoinCount) != success || createJoinTables("_l", largeJoinCount) != success) {
+        std::cerr << "***** Creating the join tables failed. *****" << std::endl;
+        return fail;
+    }
+
+    RC rc = success;
+    std::vector<std::pair<int, int>> bnlResults;
+    std::vector<std::pair<int, int>> ghResults;
+
+    auto *leftIn = new TableScan(rm, "ghleft_s");
+    auto *rightIn = new TableScan(rm, "ghright_s");
+    auto start = std::chrono::steady_clock::now();
+    auto *bnlJoin = new BNLJoin(leftIn, rightIn, joinOnB("_s"), 10);
+    rc = collectJoin(bnlJoin, bnlResults);
+    double bnlMs = elapsedMs(start);
+    delete bnlJoin;
+    delete leftIn;
+    delete rightIn;
+
+    std::vector<std::string> prefixes;
+    double ghMs = 0;
+    if (rc == success) {
+        leftIn = new TableScan(rm, "ghleft_s");
+        rightIn = new TableScan(rm, "ghright_s");
+        start = std::chrono::steady_clock::now();
+        auto *ghJoin = new GHJoin(leftIn, rightIn, joinOnB("_s"), 10);
+        prefixes.push_back(ghJoin->leftPrefix);
+        rc = collectJoin(ghJoin, ghResults);
+        ghMs = elapsedMs(start);
+        delete ghJoin;
+        delete leftIn;
+        delete rightIn;
+    }
+
+    std::sort(bnlResults.begin(), bnlResults.end());
+    std::sort(ghResults.begin(), ghResults.end());
+    if (rc == success && (bnlResults.size() != smallJoinCount || ghResults != bnlResults)) {
+        std::cerr << "***** BNLJoin returned " << bnlResults.size() << " and GHJoin " << ghResults.size()
+                  << " results, they should be the same " << smallJoinCount << ". *****" << std::endl;
+        rc = fail;
+    }
+    if (rc == success) {
+        std::cerr << smallJoinCount << " x " << smallJoinCount << ": BNLJoin " << bnlMs << " ms, GHJoin " << ghMs
+                  << " ms" << std::endl;
+    }
+
+    // Each right row with B below half the rows finds the two left rows of that B
+    if (rc == success) {
+        leftIn = new TableScan(rm, "ghleft_l");
+        rightIn = new TableScan(rm, "ghright_l");
+        start = std::chrono::steady_clock::now();
+        auto *ghJoin = new GHJoin(leftIn, rightIn, joinOnB("_l"), 20);
+        prefixes.push_back(ghJoin->leftPrefix);
+        rc = collectJoin(ghJoin, ghResults);
+        ghMs = elapsedMs(start);
+        delete ghJoin;
+        delete leftIn;
+        delete rightIn;
+
+        std::sort(ghResults.begin(), ghResults.end());
+        if (rc == success && (ghResults.size() != largeJoinCount ||
+                              std::unique(ghResults.begin(), ghResults.end()) != ghResults.end())) {
+            std::cerr << "***** GHJoin returned " << ghResults.size() << " results instead of " << largeJoinCount
+                      << " distinct ones. *****" << std::endl;
+            rc = fail;
+        }
+        if (rc == success) {
+            std::cerr << largeJoinCount << " x " << largeJoinCount << ": GHJoin " << ghMs << " ms" << std::endl;
+        }
+    }
+
+    // The partition files of both GHJoins are gone
+    for (int i = 0; i < prefixes.size() && rc == success; i++) {
+        std::string fileName = prefixes[i] + "0";
+        FILE *file = fopen(fileName.c_str(), "r");
+        if (file != nullptr) {
+            fclose(file);
+            std::cerr << "***** " << fileName << " was not destroyed. *****" << std::endl;
+            rc = fail;
+        }
+    }
+
+    // A file of the same name as a partition stays as it is, and the join keeps failing instead of
+    // going on with the partitions it has
+    if (rc == success) {
+        leftIn = new TableScan(rm, "ghleft_s");
+        rightIn = new TableScan(rm, "ghright_s");
+        auto *ghJoin = new GHJoin(leftIn, rightIn, joinOnB("_s"), 10);
+        std::string fileName = ghJoin->rightPrefix + "3";
+        RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+        rbfm.createFile(fileName);
+        void *data = malloc(PAGE_SIZE);
+        RC firstRc = ghJoin->getNextTuple(data);
+        RC secondRc = ghJoin->getNextTuple(data);
+        if (firstRc == success || firstRc == QE_EOF) {
+            std::cerr << "***** GHJoin wrote into " << fileName << ", a file it did not create. *****" << std::endl;
+            rc = fail;
+        } else if (secondRc != firstRc) {
+            std::cerr << "***** GHJoin returned " << secondRc << " after failing with " << firstRc << ". *****"
+                      << std::endl;
+            rc = fail;
+        }
+        free(data);
+        delete ghJoin;
+        delete leftIn;
+        delete rightIn;
+        if (rbfm.destroyFile(fileName) != success) {
+            std::cerr << "***** GHJoin destroyed " << fileName << ", a file it did not create. *****" << std::endl;
+            rc = fail;
+        }
+    }
+
+    // The join attribute is not in the right input
+    if (rc == success) {
+        leftIn = new TableScan(rm, "ghleft_s");
+        rightIn = new TableScan(rm, "ghright_s");
+        Condition cond = joinOnB("_s");
+        cond.rhsAttr = "ghright_s.X";
+        auto *ghJoin = new GHJoin(leftIn, rightIn, cond, 10);
+        void *data = malloc(PAGE_SIZE);
+        RC joinRc = ghJoin->getNextTuple(data);
+        if (joinRc == success || joinRc == QE_EOF) {
+            std::cerr << "***** GHJoin on an unknown attribute returned " << joinRc << " instead of an error. *****"
+                      << std::endl;
+            rc = fail;
+        }
+        free(data);
+        delete ghJoin;
+        delete leftIn;
+        delete rightIn;
+    }
+
+    rm.deleteTable("ghleft_s");
+    rm.deleteTable("ghright_s");
+    rm.deleteTable("ghleft_l");
+    rm.deleteTable("ghright_l");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_ghjoin_1() != success) {
+        std::cerr << "***** [FAIL] QE Test GHJoin Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test GHJoin Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
@@ -0,0 +1,171 @@
+#include "qe_test_util.h"
+
+// Tuples in the plan table
+const int planTupleCount = 20000;
+
+// B of tuple i, i % 7 times the letter 'a' + i % 3
+std::string planB(int i) {
+    return std::string(i % 7, (char) ('a' + i % 3));
+}
+
+// plan(A, B, C, D): A = i, B = planB(i), C = i / 2 or null for every fourth tuple, D = 3 * i or null
+// for every ninth tuple. D sits behind a VarChar and a null, so where it starts differs from tuple to tuple.
+int createPlanTable() {
+    std::cerr << std::endl << "****Create Plan Table****" << std::endl;
+
+    std::vector<Attribute> attrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeVarChar, 10),
+                                 makeAttribute("C", TypeReal), makeAttribute("D", TypeInt)};
+    return createFilledTable("plan", attrs, planTupleCount, [](int i, char *tuple) {
+        std::string b = planB(i);
+        int length = b.length();
+        auto c = (float) i / 2;
+        int d = 3 * i;
+        int offset = 0;
+        tuple[offset] = (i % 4 == 0 ? 1 << 5 : 0) | (i % 9 == 0 ? 1 << 4 : 0);
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, b.data(), length);
+        offset += length;
+        if (i % 4 != 0) {
+            memcpy(tuple + offset, &c, sizeof(float));
+            offset += sizeof(float);
+        }
+        if (i % 9 != 0) {
+            memcpy(tuple + offset, &d, sizeof(int));
+        }
+    });
+}
+
+// Run a Filter with cond over the hidden scan, each returned A has to satisfy keep and expected of them come back
+RC runFilter(const std::string &query, const Condition &cond, bool (*keep)(int), int expected) {
+    auto *tableScan = new TableScan(rm, "plan");
+    auto *opaqueScan = new OpaqueScan(tableScan);
+    auto start = std::chrono::steady_clock::now();
+    auto *filter = new Filter(opaqueScan, cond);
+    void *data = malloc(bufSize);
+    RC rc = success;
+    int count = 0;
+    while (filter->getNextTuple(data) != QE_EOF) {
+        int a = *(int *) ((char *) data + 1);
+        if (!keep(a)) {
+            std::cerr << "***** " << query << " returned A " << a << ". *****" << std::endl;
+            rc = fail;
+            break;
+        }
+        count++;
+    }
+    double ms = elapsedMs(start);
+    if (rc == success && count != expected) {
+        std::cerr << "***** " << query << " returned " << count << " tuples, it should be " << expected
+                  << ". *****" << std::endl;
+        rc = fail;
+    }
+    if (rc == success) {
+        std::cerr << query << ": " << count << " tuples, " << ms << " ms" << std::endl;
+    }
+    free(data);
+    delete filter;
+    delete opaqueScan;
+    delete tableScan;
+    return rc;
+}
+
+bool dBelow3000(int a) {
+    return a < 1000 && a % 9 != 0;
+}
+
+bool bAfterBB(int a) {
+    return planB(a) > "bb";
+}
+
+RC testCase_plan_1() {
+    // Functions Tested
+    // 1. Filter on an attribute behind a VarChar and a nullable attribute **
+    // 2. Filter comparing VarChars **
+    // 3. Project reading attributes out of order, with VarChars and nulls **
+    std::cerr << std::endl << "***** In QE Test Plan Case 01 *****" << std::endl;
+
+    rm.deleteTable("plan");
+    if (createPlanTable() != success) {
+        std::cerr << "***** Creating the plan table failed. *****" << std::endl;
+        return fail;
+    }
+
+    // SELECT * FROM plan WHERE D < 3000
+    int dValue = 3000;
+    RC rc = runFilter("D < 3000", constantCondition("plan.D", LT_OP, TypeInt, &dValue), dBelow3000,
+                      1000 - (1000 + 8) / 9);
+
+    // SELECT * FROM plan WHERE B > 'bb'
+    int expected = 0;
+    for (int i = 0; i < planTupleCount; i++) {
+        expected += bAfterBB(i) ? 1 : 0;
+    }
+    char bValue[sizeof(int) + 2];
+    int length = 2;
+    memcpy(bValue, &length, sizeof(int));
+    memcpy(bValue + sizeof(int), "bb", length);
+    if (rc == success) {
+        rc = runFilter("B > 'bb'", constantCondition("plan.B", GT_OP, TypeVarChar, bValue), bAfterBB, expected);
+    }
+
+    // SELECT D, B, C FROM plan
+    if (rc == success) {
+        auto *tableScan = new TableScan(rm, "plan");
+        auto *opaqueScan = new OpaqueScan(tableScan);
+        auto *project = new Project(opaqueScan, {"plan.D", "plan.B", "plan.C"});
+        void *data = malloc(bufSize);
+        int count = 0;
+        while (project->getNextTuple(data) != QE_EOF) {
+            // Tuples come back in the order they were inserted
+            int i = count;
+            unsigned char nullFlags = *(unsigned char *) data;
+            unsigned char expectedFlags = (i % 9 == 0 ? 1 << 7 : 0) | (i % 4 == 0 ? 1 << 5 : 0);
+            int offset = 1;
+            int d = 3 * i;
+            if (i % 9 != 0) {
+                d = *(int *) ((char *) data + offset);
+                offset += sizeof(int);
+            }
+            int bLength = *(int *) ((char *) data + offset);
+            offset += sizeof(int);
+            std::string b((char *) data + offset, bLength);
+            offset += bLength;
+            float c = (float) i / 2;
+            if (i % 4 != 0) {
+                c = *(float *) ((char *) data + offset);
+            }
+            if (nullFlags != expectedFlags || d != 3 * i || b != planB(i) || c != (float) i / 2) {
+                std::cerr << "***** Project returned a wrong tuple for A " << i << ". *****" << std::endl;
+                rc = fail;
+                break;
+            }
+            count++;
+        }
+        if (rc == success && count != planTupleCount) {
+            std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+            rc = fail;
+        }
+        free(data);
+        delete project;
+        delete opaqueScan;
+        delete tableScan;
+    }
+
+    rm.deleteTable("plan");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_plan_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Plan Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Plan Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
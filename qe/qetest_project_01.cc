@@ -0,0 +1,218 @@
+#include <algorithm>
+
+#include "qe_test_util.h"
+
+// Tuples in the wide table
+const int projectTupleCount = 20000;
+
+// Length of each VarChar in the wide table, most of a tuple is in them
+const int projectVarCharLength = 200;
+
+// wide(A, B, C, D, E): A = i, B = 200 times 'a' + i % 26, C = i / 2, D = 200 times 'z' - i % 26, E = -i.
+// Every tenth C is null.
+int createWideTable() {
+    std::cerr << std::endl << "****Create Wide Table****" << std::endl;
+
+    std::vector<Attribute> attrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeVarChar, projectVarCharLength),
+                                 makeAttribute("C", TypeReal), makeAttribute("D", TypeVarChar, projectVarCharLength),
+                                 makeAttribute("E", TypeInt)};
+    RC rc = createFilledTable("wide", attrs, projectTupleCount, [](int i, char *tuple) {
+        int length = projectVarCharLength;
+        auto c = (float) i / 2;
+        int e = -i;
+        int offset = 0;
+        tuple[offset] = i % 10 == 0 ? 1 << 5 : 0;
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'a' + i % 26, length);
+        offset += length;
+        if (i % 10 != 0) {
+            memcpy(tuple + offset, &c, sizeof(float));
+            offset += sizeof(float);
+        }
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'z' - i % 26, length);
+        offset += length;
+        memcpy(tuple + offset, &e, sizeof(int));
+    });
+    if (rc != success) {
+        return rc;
+    }
+    return rm.createIndex("wide", "A");
+}
+
+// SELECT E, A FROM wide, run to the end. Each returned tuple must match its A.
+RC runNarrowProject(Iterator *input, bool pushed, double &ms) {
+    auto start = std::chrono::steady_clock::now();
+    auto *project = new Project(input, {"wide.E", "wide.A"});
+    RC rc = success;
+    if (project->pushedDown != pushed) {
+        std::cerr << "***** The projection should " << (pushed ? "" : "not ") << "be pushed down. *****"
+                  << std::endl;
+        rc = fail;
+    }
+
+    void *data = malloc(bufSize);
+    std::vector<bool> seen(projectTupleCount, false);
+    int count = 0;
+    while (rc == success && project->getNextTuple(data) != QE_EOF) {
+        int e = *(int *) ((char *) data + 1);
+        int a = *(int *) ((char *) data + 1 + sizeof(int));
+        if (*(unsigned char *) data != 0 || a < 0 || a >= projectTupleCount || seen[a] || e != -a) {
+            std::cerr << "***** Project returned E " << e << ", A " << a << ". *****" << std::endl;
+            rc = fail;
+            break;
+        }
+        seen[a] = true;
+        count++;
+    }
+    ms = elapsedMs(start);
+    if (rc == success && count != projectTupleCount) {
+        std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+        rc = fail;
+    }
+    free(data);
+    delete project;
+    return rc;
+}
+
+RC testCase_project_1() {
+    // Functions Tested
+    // 1. Project pushed down into TableScan **
+    // 2. Project pushed down into IndexScan, with VarChar and null attributes **
+    // 3. Project pushed down into IndexScan keeps the key range set before **
+    // 4. Project pushed down through a pushed down Filter **
+    // 5. Time of the projection pushed down against Project copying from full tuples
+    std::cerr << std::endl << "***** In QE Test Project Case 01 *****" << std::endl;
+
+    rm.deleteTable("wide");
+    if (createWideTable() != success) {
+        std::cerr << "***** Creating the wide table failed. *****" << std::endl;
+        return fail;
+    }
+
+    double pushedMs = 0, plainMs = 0;
+    auto *tableScan = new TableScan(rm, "wide");
+    RC rc = runNarrowProject(tableScan, true, pushedMs);
+    delete tableScan;
+
+    if (rc == success) {
+        tableScan = new TableScan(rm, "wide");
+        auto *opaqueScan = new OpaqueScan(tableScan);
+        rc = runNarrowProject(opaqueScan, false, plainMs);
+        delete opaqueScan;
+        delete tableScan;
+    }
+    if (rc == success) {
+        std::cerr << "SELECT E, A FROM wide: pushed down " << pushedMs << " ms, copied by Project " << plainMs
+                  << " ms" << std::endl;
+    }
+
+    // SELECT C, D FROM wide ORDER BY A, through the index
+    void *data = malloc(bufSize + 2 * projectVarCharLength);
+    if (rc == success) {
+        auto *indexScan = new IndexScan(rm, "wide", "A");
+        auto *project = new Project(indexScan, {"wide.C", "wide.D"});
+        int count = 0;
+        while (project->getNextTuple(data) != QE_EOF) {
+            unsigned char nullFlags = *(unsigned char *) data;
+            int offset = 1;
+            float c = -1;
+            if ((nullFlags & (1 << 7)) == 0) {
+                c = *(float *) ((char *) data + offset);
+                offset += sizeof(float);
+            }
+            int length = *(int *) ((char *) data + offset);
+            char d = *((char *) data + offset + sizeof(int));
+            bool cNull = count % 10 == 0;
+            if (!project->pushedDown || (nullFlags != 0) != cNull || (!cNull && c != (float) count / 2) ||
+                length != projectVarCharLength || d != 'z' - count % 26) {
+                std::cerr << "***** Project on IndexScan returned a wrong tuple for A " << count << ". *****"
+                          << std::endl;
+                rc = fail;
+                break;
+            }
+            count++;
+        }
+        if (rc == success && count != projectTupleCount) {
+            std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+            rc = fail;
+        }
+        delete project;
+        delete indexScan;
+    }
+
+    // SELECT E FROM wide WHERE A >= 5000 AND A < 5010, through the index
+    if (rc == success) {
+        int lowKey = 5000;
+        int highKey = 5010;
+        auto *indexScan = new IndexScan(rm, "wide", "A");
+        indexScan->setIterator(&lowKey, &highKey, true, false);
+        auto *project = new Project(indexScan, {"wide.E"});
+        int count = 0;
+        while (project->getNextTuple(data) != QE_EOF) {
+            int e = *(int *) ((char *) data + 1);
+            if (!project->pushedDown || e != -(lowKey + count)) {
+                std::cerr << "***** Project on IndexScan returned E " << e << " outside the key range. *****"
+                          << std::endl;
+                rc = fail;
+                break;
+            }
+            count++;
+        }
+        if (rc == success && count != highKey - lowKey) {
+            std::cerr << "***** Project on IndexScan returned " << count << " tuples instead of "
+                      << highKey - lowKey << ". *****" << std::endl;
+            rc = fail;
+        }
+        delete project;
+        delete indexScan;
+    }
+
+    // SELECT B FROM wide WHERE A < 100
+    if (rc == success) {
+        int aValue = 100;
+        tableScan = new TableScan(rm, "wide");
+        auto *filter = new Filter(tableScan, constantCondition("wide.A", LT_OP, TypeInt, &aValue));
+        auto *project = new Project(filter, {"wide.B"});
+        std::vector<bool> seen(26, false);
+        int count = 0;
+        while (project->getNextTuple(data) != QE_EOF) {
+            int length = *(int *) ((char *) data + 1);
+            char b = *((char *) data + 1 + sizeof(int));
+            if (!project->pushedDown || length != projectVarCharLength || b < 'a' || b > 'z') {
+                std::cerr << "***** Project on Filter returned a wrong tuple. *****" << std::endl;
+                rc = fail;
+                break;
+            }
+            seen[b - 'a'] = true;
+            count++;
+        }
+        if (rc == success && (count != aValue || std::find(seen.begin(), seen.end(), false) != seen.end())) {
+            std::cerr << "***** The number of returned tuple is not correct. *****" << std::endl;
+            rc = fail;
+        }
+        delete project;
+        delete filter;
+        delete tableScan;
+    }
+    free(data);
+
+    rm.deleteTable("wide");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_project_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Project Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Project Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
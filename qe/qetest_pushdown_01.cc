@@ -0,0 +1,163 @@
+#include "qe_test_util.h"
+
+// Tuples in the table, every query keeps a small fraction of them
+const int pushdownTupleCount = 50000;
+
+// pushdown(A, B, C): A = i, B = i % 1000, C = 40 times the letter 'a' + i % 26
+int createPushdownTable() {
+    std::cerr << std::endl << "****Create Pushdown Table****" << std::endl;
+
+    std::vector<Attribute> attrs{makeAttribute("A", TypeInt), makeAttribute("B", TypeReal),
+                                 makeAttribute("C", TypeVarChar, 40)};
+    int length = attrs[2].length;
+    return createFilledTable("pushdown", attrs, pushdownTupleCount, [length](int i, char *tuple) {
+        auto b = (float) (i % 1000);
+        int offset = 0;
+        tuple[offset] = 0;
+        offset += 1;
+        memcpy(tuple + offset, &i, sizeof(int));
+        offset += sizeof(int);
+        memcpy(tuple + offset, &b, sizeof(float));
+        offset += sizeof(float);
+        memcpy(tuple + offset, &length, sizeof(int));
+        offset += sizeof(int);
+        memset(tuple + offset, 'a' + i % 26, length);
+    });
+}
+
+// Stack a Filter per condition on the input and run them to the end. Every Filter has to be pushed down
+// or none, depending on pushed. Each returned A has to satisfy keep.
+RC runFilters(Iterator *input, const std::vector<Condition> &conds, bool pushed, bool (*keep)(int),
+              int &count, double &ms) {
+    std::vector<Filter *> filters;
+    Iterator *top = input;
+    RC rc = success;
+    auto start = std::chrono::steady_clock::now();
+    for (const Condition &cond : conds) {
+        auto *filter = new Filter(top, cond);
+        if (filter->pushedDown != pushed) {
+            std::cerr << "***** The filter on " << cond.lhsAttr << " should " << (pushed ? "" : "not ")
+                      << "be pushed down. *****" << std::endl;
+            rc = fail;
+        }
+        filters.push_back(filter);
+        top = filter;
+    }
+
+    void *data = malloc(bufSize);
+    count = 0;
+    while (rc == success && top->getNextTuple(data) != QE_EOF) {
+        int a = *(int *) ((char *) data + 1);
+        if (!keep(a)) {
+            std::cerr << "***** Filter returned A " << a << ". *****" << std::endl;
+            rc = fail;
+            break;
+        }
+        count++;
+    }
+    ms = elapsedMs(start);
+
+    free(data);
+    for (Filter *filter : filters) {
+        delete filter;
+    }
+    return rc;
+}
+
+// Run the filters once over the table scan and once over the hidden one, both have to return expected tuples
+RC compareFilters(const std::string &query, const std::vector<Condition> &conds, bool (*keep)(int), int expected) {
+    int pushedCount, plainCount;
+    double pushedMs, plainMs;
+
+    auto *tableScan = new TableScan(rm, "pushdown");
+    RC rc = runFilters(tableScan, conds, true, keep, pushedCount, pushedMs);
+    delete tableScan;
+
+    if (rc == success) {
+        tableScan = new TableScan(rm, "pushdown");
+        auto *opaqueScan = new OpaqueScan(tableScan);
+        rc = runFilters(opaqueScan, conds, false, keep, plainCount, plainMs);
+        delete opaqueScan;
+        delete tableScan;
+    }
+
+    if (rc == success && (pushedCount != expected || plainCount != expected)) {
+        std::cerr << "***** " << query << " returned " << pushedCount << " tuples pushed down and " << plainCount
+                  << " checked by Filter, it should be " << expected << ". *****" << std::endl;
+        rc = fail;
+    }
+    if (rc == success) {
+        std::cerr << query << ": pushed down " << pushedMs << " ms, checked by Filter " << plainMs << " ms"
+                  << std::endl;
+    }
+    return rc;
+}
+
+bool aBelow500(int a) {
+    return a < 500;
+}
+
+bool upperHalfBBelow5(int a) {
+    return a >= pushdownTupleCount / 2 && a % 1000 < 5;
+}
+
+bool letterBBelow260(int a) {
+    return a % 26 == 1 && a < 260;
+}
+
+RC testCase_pushdown_1() {
+    // Functions Tested
+    // 1. Filter on a table scan with a single condition **
+    // 2. Stacked Filters on a table scan, each pushed down **
+    // 3. Filter on a VarChar attribute **
+    // 4. Time of the filters pushed down against the same filters checking every tuple
+    std::cerr << std::endl << "***** In QE Test Pushdown Case 01 *****" << std::endl;
+
+    rm.deleteTable("pushdown");
+    if (createPushdownTable() != success) {
+        std::cerr << "***** Creating the pushdown table failed. *****" << std::endl;
+        return fail;
+    }
+
+    // SELECT * FROM pushdown WHERE A < 500
+    int aValue = 500;
+    RC rc = compareFilters("A < 500", {constantCondition("pushdown.A", LT_OP, TypeInt, &aValue)}, aBelow500, 500);
+
+    // SELECT * FROM pushdown WHERE A >= 25000 AND B < 5.0
+    int halfValue = pushdownTupleCount / 2;
+    float bValue = 5.0;
+    if (rc == success) {
+        rc = compareFilters("A >= 25000 AND B < 5.0",
+                            {constantCondition("pushdown.A", GE_OP, TypeInt, &halfValue),
+                             constantCondition("pushdown.B", LT_OP, TypeReal, &bValue)},
+                            upperHalfBBelow5, pushdownTupleCount / 2 / 1000 * 5);
+    }
+
+    // SELECT * FROM pushdown WHERE C = 'bb...b' AND A < 260
+    int length = 40;
+    char *cValue = (char *) malloc(sizeof(int) + length);
+    memcpy(cValue, &length, sizeof(int));
+    memset(cValue + sizeof(int), 'b', length);
+    int a260Value = 260;
+    if (rc == success) {
+        rc = compareFilters("C = 'b...b' AND A < 260",
+                            {constantCondition("pushdown.C", EQ_OP, TypeVarChar, cValue),
+                             constantCondition("pushdown.A", LT_OP, TypeInt, &a260Value)},
+                            letterBBelow260, 10);
+    }
+    free(cValue);
+
+    rm.deleteTable("pushdown");
+    return rc;
+}
+
+int main() {
+
+    if (testCase_pushdown_1() != success) {
+        std::cerr << "***** [FAIL] QE Test Pushdown Case 01 failed. *****" << std::endl;
+        return fail;
+    } else {
+        std::cerr << "***** QE Test Pushdown Case 01 finished. The result will be examined. *****" << std::endl;
+        return success;
+    }
+}
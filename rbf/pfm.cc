@@ -49,12 +49,17 @@ RC PagedFileManager::destroyFile(const string &fileName) {
     if (!fileExist(fileName)) {
         return -1; //FileNotFoundException
     }
+    // A page still pinned by a reader of the file keeps it from going
+    RC rc = BufferManager::instance().discardFile(fileName);
+    if (rc != 0) {
+        return rc;
+    }
     remove(fileName.c_str());
     return 0;
 }
 
-RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle) {
-    return fileHandle.openFile(fileName);
+RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle, FileMode fileMode) {
+    return fileHandle.openFile(fileName, fileMode);
 }
 
 RC PagedFileManager::closeFile(FileHandle &fileHandle) {
@@ -65,6 +70,15 @@ FileHandle::FileHandle() {
     this->readPageCounter = 0;
     this->writePageCounter = 0;
     this->appendPageCounter = 0;
+#ifndef PFM_FSTREAM_IO
+    this->fd = -1;
+#endif
+    this->bufferFileId = -1;
+    this->mappedFile = nullptr;
+    this->mappedSize = 0;
+    this->numberOfPages = 0;
+    this->counterSyncInterval = COUNTER_SYNC_INTERVAL;
+    this->pendingCounterUpdates = 0;
 }
 
 FileHandle::~FileHandle() {
@@ -72,46 +86,127 @@ FileHandle::~FileHandle() {
 }
 
 bool FileHandle::fileHandleOccupied() {
-    return fs.is_open();
+    if (this->mappedFile != nullptr) {
+        return true;
+    }
+#ifdef PFM_FSTREAM_IO
+    return this->fs.is_open();
+#else
+    return this->fd != -1;
+#endif
+}
+
+bool FileHandle::isReadOnly() {
+    return this->mappedFile != nullptr;
 }
 
-RC FileHandle::openFile(const string &fileName) {
+RC FileHandle::openFile(const string &fileName, FileMode fileMode) {
     if (!fileExist(fileName)) {
         return -1; //FileNotFoundException
     }
-    if (this->fs.is_open()) {
+    if (this->fileHandleOccupied()) {
         return -4; //FileHandleOccupiedException
     }
+    if (fileMode == READ_ONLY_MMAP) {
+        return this->mapFile(fileName);
+    }
+#ifdef PFM_FSTREAM_IO
     try {
         this->fs.open(fileName);
-        this->readHiddenPage();
+        this->fs.seekg(0, this->fs.end);
+        this->numberOfPages = this->fs.tellg() / PAGE_SIZE - 1;
     } catch (fstream::failure &e) {
         return -3; //FileOpException
     }
+#else
+    this->fd = open(fileName.c_str(), O_RDWR);
+    if (this->fd == -1) {
+        return -3; //FileOpException
+    }
+    struct stat buf;
+    if (fstat(this->fd, &buf) == -1) {
+        close(this->fd);
+        this->fd = -1;
+        return -3; //FileOpException
+    }
+    this->numberOfPages = buf.st_size / PAGE_SIZE - 1;
+#endif
+    this->readHiddenPage();
+    this->pendingCounterUpdates = 0;
+    this->bufferFileId = BufferManager::instance().registerFile(fileName, this);
+    return 0;
+}
+
+RC FileHandle::mapFile(const string &fileName) {
+    // Pages still dirty in the buffer pool would be missing from the mapping
+    BufferManager::instance().flushFile(fileName);
+    int mapFd = open(fileName.c_str(), O_RDONLY);
+    struct stat buf;
+    if (mapFd == -1 || fstat(mapFd, &buf) == -1 || buf.st_size < PAGE_SIZE) {
+        if (mapFd != -1) {
+            close(mapFd);
+        }
+        return -3; //FileOpException
+    }
+    void *mapping = mmap(nullptr, buf.st_size, PROT_READ, MAP_SHARED, mapFd, 0);
+    close(mapFd);
+    if (mapping == MAP_FAILED) {
+        return -3; //FileOpException
+    }
+    this->mappedFile = (char *) mapping;
+    this->mappedSize = buf.st_size;
+    this->numberOfPages = buf.st_size / PAGE_SIZE - 1;
+    this->readHiddenPage();
+    this->pendingCounterUpdates = 0;
     return 0;
 }
 
 RC FileHandle::closeFile() {
-    if (!this->fs.is_open()) {
+    if (!this->fileHandleOccupied()) {
         return -1;  // FileNotFoundException
     }
-    try {
-        this->updateCounterValues();
-        this->fs.close();
-    } catch (fstream::failure &e) {
-        return -3; // FileOpException
+    if (this->mappedFile != nullptr) {
+        // Counters of a read-only handle cannot be persisted
+        munmap(this->mappedFile, this->mappedSize);
+        this->mappedFile = nullptr;
+        this->mappedSize = 0;
+        this->numberOfPages = 0;
+        this->pendingCounterUpdates = 0;
+        return 0;
     }
-    return 0;
+    BufferManager::instance().unregisterFile(this->bufferFileId, this);
+    this->bufferFileId = -1;
+    this->numberOfPages = 0;
+    RC rc = this->flushCounterValues();
+#ifdef PFM_FSTREAM_IO
+    this->fs.close();
+#else
+    close(this->fd);
+    this->fd = -1;
+#endif
+    return rc == 0 ? 0 : -3; // FileOpException
 }
 
 RC FileHandle::readPage(PageNum pageNum, void *data) {
     if (pageNum >= this->getNumberOfPages()) {
         return -1; // PageNotFoundException
     }
-    this->fs.seekg((pageNum + 1) * PAGE_SIZE);
-    this->fs.read((char *) data, PAGE_SIZE);
+    if (this->mappedFile != nullptr) {
+        memcpy(data, this->mappedFile + (size_t) (pageNum + 1) * PAGE_SIZE, PAGE_SIZE);
+        this->readPageCounter++;
+        this->countersChanged();
+        return 0;
+    }
+    BufferManager &bm = BufferManager::instance();
+    char *frame;
+    RC rc = bm.pinPage(this->bufferFileId, pageNum, true, frame);
+    if (rc != 0) {
+        return rc;
+    }
+    memcpy(data, frame, PAGE_SIZE);
+    bm.unpinPage(this->bufferFileId, pageNum, false);
     this->readPageCounter++;
-    this->updateCounterValues();
+    this->countersChanged();
     return 0;
 }
 
@@ -119,24 +214,150 @@ RC FileHandle::writePage(PageNum pageNum, const void *data) {
     if (pageNum >= this->getNumberOfPages()) {
         return -1; //PageNotFoundException
     }
-    this->fs.seekp((pageNum + 1) * PAGE_SIZE);
-    this->fs.write((char *) data, PAGE_SIZE);
+    if (this->mappedFile != nullptr) {
+        return -18; // ReadOnlyFileException
+    }
+    // The whole page is overwritten, so there is no need to fetch it first
+    BufferManager &bm = BufferManager::instance();
+    char *frame;
+    RC rc = bm.pinPage(this->bufferFileId, pageNum, false, frame);
+    if (rc != 0) {
+        return rc;
+    }
+    memcpy(frame, data, PAGE_SIZE);
+    bm.unpinPage(this->bufferFileId, pageNum, true);
     this->writePageCounter++;
-    this->updateCounterValues();
+    this->countersChanged();
     return 0;
 }
 
 RC FileHandle::appendPage(const void *data) {
-    this->fs.seekp(0, this->fs.end);
-    this->fs.write((char *) data, PAGE_SIZE);
+    PageNum pageNum;
+    return this->appendPage(data, pageNum);
+}
+
+RC FileHandle::appendPage(const void *data, PageNum &pageNum) {
+    if (this->mappedFile != nullptr) {
+        return -18; // ReadOnlyFileException
+    }
+    RC rc = BufferManager::instance().appendPage(this->bufferFileId, this, data, pageNum);
+    if (rc != 0) {
+        return rc;
+    }
     this->appendPageCounter++;
-    this->updateCounterValues();
+    this->countersChanged();
+    return 0;
+}
+
+RC FileHandle::pinPage(PageNum pageNum, void *&data) {
+    if (pageNum >= this->getNumberOfPages()) {
+        return -1; // PageNotFoundException
+    }
+    if (this->mappedFile != nullptr) {
+        data = this->mappedFile + (size_t) (pageNum + 1) * PAGE_SIZE;
+        this->readPageCounter++;
+        this->countersChanged();
+        return 0;
+    }
+    char *frame;
+    RC rc = BufferManager::instance().pinPage(this->bufferFileId, pageNum, true, frame);
+    if (rc != 0) {
+        return rc;
+    }
+    data = frame;
+    this->readPageCounter++;
+    this->countersChanged();
+    return 0;
+}
+
+RC FileHandle::unpinPage(PageNum pageNum, bool dirty) {
+    if (this->mappedFile != nullptr) {
+        return dirty ? -18 : 0; // ReadOnlyFileException
+    }
+    RC rc = BufferManager::instance().unpinPage(this->bufferFileId, pageNum, dirty);
+    if (rc != 0) {
+        return rc;
+    }
+    if (dirty) {
+        this->writePageCounter++;
+        this->countersChanged();
+    }
+    return 0;
+}
+
+RC FileHandle::latchPage(PageNum pageNum, bool exclusive) {
+    unsigned long long version;
+    return this->latchPage(pageNum, exclusive, version);
+}
+
+RC FileHandle::latchPage(PageNum pageNum, bool exclusive, unsigned long long &version) {
+    if (this->mappedFile != nullptr) {
+        // Nothing writes to a mapped file
+        version = 0;
+        return 0;
+    }
+    return BufferManager::instance().latchPage(this->bufferFileId, pageNum, exclusive, version);
+}
+
+RC FileHandle::unlatchPage(PageNum pageNum) {
+    if (this->mappedFile != nullptr) {
+        return 0;
+    }
+    return BufferManager::instance().unlatchPage(this->bufferFileId, pageNum);
+}
+
+RC FileHandle::readPageFromDisk(PageNum pageNum, void *data) {
+    return this->readBytes((off_t) (pageNum + 1) * PAGE_SIZE, data, PAGE_SIZE);
+}
+
+RC FileHandle::writePageToDisk(PageNum pageNum, const void *data) {
+    return this->writeBytes((off_t) (pageNum + 1) * PAGE_SIZE, data, PAGE_SIZE);
+}
+
+RC FileHandle::readBytes(off_t offset, void *data, size_t length) {
+    if (this->mappedFile != nullptr) {
+        if (offset + length > this->mappedSize) {
+            return -3; // FileOpException
+        }
+        memcpy(data, this->mappedFile + offset, length);
+        return 0;
+    }
+#ifdef PFM_FSTREAM_IO
+    this->fs.seekg(offset);
+    this->fs.read((char *) data, length);
+    if (this->fs.fail()) {
+        this->fs.clear();
+        return -3; // FileOpException
+    }
+#else
+    if (pread(this->fd, data, length, offset) != (ssize_t) length) {
+        return -3; // FileOpException
+    }
+#endif
+    return 0;
+}
+
+RC FileHandle::writeBytes(off_t offset, const void *data, size_t length) {
+    if (this->mappedFile != nullptr) {
+        return -18; // ReadOnlyFileException
+    }
+#ifdef PFM_FSTREAM_IO
+    this->fs.seekp(offset);
+    this->fs.write((const char *) data, length);
+    if (this->fs.fail()) {
+        this->fs.clear();
+        return -3; // FileOpException
+    }
+#else
+    if (pwrite(this->fd, data, length, offset) != (ssize_t) length) {
+        return -3; // FileOpException
+    }
+#endif
     return 0;
 }
 
 int FileHandle::getNumberOfPages() {
-    this->fs.seekg(0, this->fs.end);
-    return fs.tellg() / PAGE_SIZE - 1;
+    return this->numberOfPages;
 }
 
 RC FileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount) {
@@ -147,27 +368,563 @@ RC FileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePage
 }
 
 RC FileHandle::updateCounterValues() {
-    this->fs.seekp(0);
     int length = 3 * sizeof(unsigned);
     char *cache = (char *) malloc(length);
     memset(cache, '\0', length);
     memcpy(cache, &this->readPageCounter, sizeof(unsigned));
     memcpy(cache + 1 * sizeof(unsigned), &this->writePageCounter, sizeof(unsigned));
     memcpy(cache + 2 * sizeof(unsigned), &this->appendPageCounter, sizeof(unsigned));
-    this->fs.write(cache, length);
+    RC rc = this->writeBytes(0, cache, length);
     free(cache);
+    return rc;
+}
+
+RC FileHandle::flushCounterValues() {
+    if (this->pendingCounterUpdates == 0 || this->mappedFile != nullptr) {
+        return 0;
+    }
+    this->pendingCounterUpdates = 0;
+    return this->updateCounterValues();
+}
+
+RC FileHandle::setCounterSyncInterval(unsigned interval) {
+    this->counterSyncInterval = interval;
+    if (this->fileHandleOccupied() && interval != 0 && this->pendingCounterUpdates >= interval) {
+        return this->flushCounterValues();
+    }
+    return 0;
+}
+
+RC FileHandle::countersChanged() {
+    // The counters live in memory, the hidden page only needs to catch up eventually
+    this->pendingCounterUpdates++;
+    if (this->counterSyncInterval != 0 && this->pendingCounterUpdates >= this->counterSyncInterval) {
+        return this->flushCounterValues();
+    }
     return 0;
 }
 
 RC FileHandle::readHiddenPage() {
-    this->fs.seekg(0);
     int length = 3 * sizeof(unsigned);
     char *cache = (char *) malloc(length);
     memset(cache, '\0', length);
-    this->fs.read(cache, length);
+    this->readBytes(0, cache, length);
     memcpy(&this->readPageCounter, cache, sizeof(unsigned));
     memcpy(&this->writePageCounter, cache + 1 * sizeof(unsigned), sizeof(unsigned));
     memcpy(&this->appendPageCounter, cache + 2 * sizeof(unsigned), sizeof(unsigned));
     free(cache);
     return 0;
 }
+
+BufferManager &BufferManager::instance() {
+    static BufferManager _buffer_manager = BufferManager();
+    return _buffer_manager;
+}
+
+BufferManager::BufferManager() {
+    this->hitCounter = 0;
+    this->missCounter = 0;
+    this->evictCounter = 0;
+    this->policyType = LRU;
+    this->policy = nullptr;
+    this->resize(BUFFER_POOL_SIZE);
+}
+
+BufferManager::~BufferManager() {
+    for (int i = 0; i < this->frames.size(); i++) {
+        this->writeBack(i);
+        free(this->frames[i].data);
+    }
+    delete this->policy;
+    for (auto &latch : this->latches) {
+        pthread_rwlock_destroy(&latch.second->lock);
+        delete latch.second;
+    }
+}
+
+unsigned long long BufferManager::pageKey(int fileId, PageNum pageNum) {
+    return ((unsigned long long) fileId << 32) | pageNum;
+}
+
+ReplacementPolicy *BufferManager::createPolicy(ReplacementPolicyType type, unsigned frameCount) {
+    switch (type) {
+        case CLOCK:
+            return new ClockPolicy(frameCount);
+        case TWO_Q:
+            return new TwoQPolicy(frameCount);
+        default:
+            return new LRUPolicy(frameCount);
+    }
+}
+
+bool BufferManager::pinned() {
+    for (BufferFrame &frame : this->frames) {
+        if (frame.pinCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RC BufferManager::setReplacementPolicy(ReplacementPolicyType type) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    if (this->pinned()) {
+        return -15; // BufferPoolBusyException
+    }
+    ReplacementPolicy *newPolicy = this->createPolicy(type, this->frames.size());
+    for (int i = 0; i < this->frames.size(); i++) {
+        if (this->frames[i].fileId != -1) {
+            newPolicy->pageLoaded(i);
+        }
+    }
+    delete this->policy;
+    this->policy = newPolicy;
+    this->policyType = type;
+    return 0;
+}
+
+RC BufferManager::resize(unsigned frameCount) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    if (frameCount == 0) {
+        return -16; // InvalidBufferSizeException
+    }
+    if (this->pinned()) {
+        return -15; // BufferPoolBusyException
+    }
+    for (int i = 0; i < this->frames.size(); i++) {
+        this->writeBack(i);
+        free(this->frames[i].data);
+    }
+    this->frames.clear();
+    this->pageTable.clear();
+    BufferFrame frame;
+    frame.fileId = -1;
+    frame.pageNum = 0;
+    frame.pinCount = 0;
+    frame.dirty = false;
+    for (unsigned i = 0; i < frameCount; i++) {
+        frame.data = (char *) malloc(PAGE_SIZE);
+        this->frames.emplace_back(frame);
+    }
+    delete this->policy;
+    this->policy = this->createPolicy(this->policyType, frameCount);
+    return 0;
+}
+
+int BufferManager::registerFile(const string &fileName, FileHandle *fileHandle) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    struct stat buf;
+    stat(fileName.c_str(), &buf);
+    int fileId;
+    auto it = this->fileIds.find(fileName);
+    if (it == this->fileIds.end()) {
+        fileId = this->files.size();
+        BufferFile file;
+        file.fileName = fileName;
+        this->files.emplace_back(file);
+        this->fileIds[fileName] = fileId;
+    } else {
+        fileId = it->second;
+        BufferFile &file = this->files[fileId];
+        // Cached pages survive a close, unless the file has been replaced since then
+        if (file.handles.empty() &&
+            (file.device != buf.st_dev || file.inode != buf.st_ino || file.fileSize != buf.st_size)) {
+            this->discardFile(fileName);
+        }
+    }
+    // Appends of other handles may not have reached the file yet, trust their count instead
+    if (!this->files[fileId].handles.empty()) {
+        fileHandle->numberOfPages = this->files[fileId].handles[0]->numberOfPages.load();
+    }
+    this->files[fileId].handles.emplace_back(fileHandle);
+    return fileId;
+}
+
+RC BufferManager::unregisterFile(int fileId, FileHandle *fileHandle) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    if (fileId < 0 || fileId >= this->files.size()) {
+        return -1; // FileNotFoundException
+    }
+    BufferFile &file = this->files[fileId];
+    if (file.handles.size() == 1) {
+        // Nobody will be left to write the dirty pages back
+        this->flushFile(fileId);
+        struct stat buf;
+#ifdef PFM_FSTREAM_IO
+        fileHandle->fs.flush();
+#endif
+        stat(file.fileName.c_str(), &buf);
+        file.device = buf.st_dev;
+        file.inode = buf.st_ino;
+        file.fileSize = buf.st_size;
+    }
+    for (int i = 0; i < file.handles.size(); i++) {
+        if (file.handles[i] == fileHandle) {
+            file.handles.erase(file.handles.begin() + i);
+            break;
+        }
+    }
+    if (file.handles.empty()) {
+        this->dropLatches(fileId);
+    }
+    return 0;
+}
+
+void BufferManager::pageAppended(int fileId) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    if (fileId < 0 || fileId >= this->files.size()) {
+        return;
+    }
+    for (FileHandle *fileHandle : this->files[fileId].handles) {
+        fileHandle->numberOfPages++;
+    }
+}
+
+int BufferManager::grabFrame() {
+    for (int i = 0; i < this->frames.size(); i++) {
+        if (this->frames[i].fileId == -1) {
+            return i;
+        }
+    }
+    int victim = this->policy->pickVictim(this->frames);
+    if (victim == -1) {
+        return -1;
+    }
+    if (this->writeBack(victim) != 0) {
+        return -1;
+    }
+    this->dropFrame(victim);
+    this->evictCounter++;
+    return victim;
+}
+
+RC BufferManager::pinPage(int fileId, PageNum pageNum, bool load, char *&data) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    if (fileId < 0 || fileId >= this->files.size() || this->files[fileId].handles.empty()) {
+        return -1; // FileNotFoundException
+    }
+    auto it = this->pageTable.find(pageKey(fileId, pageNum));
+    if (it != this->pageTable.end()) {
+        BufferFrame &frame = this->frames[it->second];
+        frame.pinCount++;
+        this->policy->pageAccessed(it->second);
+        this->hitCounter++;
+        data = frame.data;
+        return 0;
+    }
+    int victim = this->grabFrame();
+    if (victim == -1) {
+        return -14; // BufferPoolFullException
+    }
+    BufferFrame &frame = this->frames[victim];
+    if (load) {
+        if (this->files[fileId].handles[0]->readPageFromDisk(pageNum, frame.data) != 0) {
+            return -3; // FileOpException
+        }
+        this->missCounter++;
+    }
+    frame.fileId = fileId;
+    frame.pageNum = pageNum;
+    frame.pinCount = 1;
+    frame.dirty = false;
+    this->pageTable[pageKey(fileId, pageNum)] = victim;
+    this->policy->pageLoaded(victim);
+    data = frame.data;
+    return 0;
+}
+
+RC BufferManager::unpinPage(int fileId, PageNum pageNum, bool dirty) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    auto it = this->pageTable.find(pageKey(fileId, pageNum));
+    if (it == this->pageTable.end() || this->frames[it->second].pinCount == 0) {
+        return -17; // PageNotPinnedException
+    }
+    BufferFrame &frame = this->frames[it->second];
+    frame.pinCount--;
+    frame.dirty = frame.dirty || dirty;
+    if (dirty) {
+        auto latch = this->latches.find(pageKey(fileId, pageNum));
+        if (latch != this->latches.end()) {
+            latch->second->version++;
+        }
+    }
+    return 0;
+}
+
+RC BufferManager::appendPage(int fileId, FileHandle *fileHandle, const void *data, PageNum &pageNum) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    // Appends go straight to disk so that the file size always reflects the page count
+    pageNum = fileHandle->numberOfPages;
+    RC rc = fileHandle->writePageToDisk(pageNum, data);
+    if (rc != 0) {
+        return rc;
+    }
+    this->pageAppended(fileId);
+    char *frame;
+    if (this->pinPage(fileId, pageNum, false, frame) == 0) {
+        memcpy(frame, data, PAGE_SIZE);
+        this->unpinPage(fileId, pageNum, false);
+    }
+    return 0;
+}
+
+RC BufferManager::latchPage(int fileId, PageNum pageNum, bool exclusive, unsigned long long &version) {
+    PageLatch *latch;
+    {
+        lock_guard<recursive_mutex> guard(this->mutex);
+        PageLatch *&slot = this->latches[pageKey(fileId, pageNum)];
+        if (slot == nullptr) {
+            slot = new PageLatch;
+            pthread_rwlock_init(&slot->lock, nullptr);
+            slot->version = 0;
+        }
+        latch = slot;
+    }
+    // Latches are freed only once no handle of the file is left, so waiting on one does not need the pool
+    if ((exclusive ? pthread_rwlock_wrlock(&latch->lock) : pthread_rwlock_rdlock(&latch->lock)) != 0) {
+        return -19; // LatchException
+    }
+    // Writers hold the latch exclusively, the version cannot move until it is released
+    version = latch->version;
+    return 0;
+}
+
+RC BufferManager::unlatchPage(int fileId, PageNum pageNum) {
+    PageLatch *latch;
+    {
+        lock_guard<recursive_mutex> guard(this->mutex);
+        auto it = this->latches.find(pageKey(fileId, pageNum));
+        if (it == this->latches.end()) {
+            return -19; // LatchException
+        }
+        latch = it->second;
+    }
+    return pthread_rwlock_unlock(&latch->lock) == 0 ? 0 : -19; // LatchException
+}
+
+RC BufferManager::writeBack(int frame) {
+    BufferFrame &bufferFrame = this->frames[frame];
+    if (bufferFrame.fileId == -1 || !bufferFrame.dirty) {
+        return 0;
+    }
+    BufferFile &file = this->files[bufferFrame.fileId];
+    if (file.handles.empty()) {
+        return -1; // FileNotFoundException
+    }
+    RC rc = file.handles[0]->writePageToDisk(bufferFrame.pageNum, bufferFrame.data);
+    if (rc != 0) {
+        return rc;
+    }
+    bufferFrame.dirty = false;
+    return 0;
+}
+
+void BufferManager::dropFrame(int frame) {
+    BufferFrame &bufferFrame = this->frames[frame];
+    this->pageTable.erase(pageKey(bufferFrame.fileId, bufferFrame.pageNum));
+    this->policy->pageRemoved(frame);
+    bufferFrame.fileId = -1;
+    bufferFrame.pinCount = 0;
+    bufferFrame.dirty = false;
+}
+
+RC BufferManager::flushFile(int fileId) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    for (int i = 0; i < this->frames.size(); i++) {
+        if (this->frames[i].fileId == fileId) {
+            RC rc = this->writeBack(i);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
+    return 0;
+}
+
+RC BufferManager::flushFile(const string &fileName) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    auto it = this->fileIds.find(fileName);
+    if (it == this->fileIds.end() || this->files[it->second].handles.empty()) {
+        return 0;
+    }
+    return this->flushFile(it->second);
+}
+
+RC BufferManager::discardFile(const string &fileName) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    auto it = this->fileIds.find(fileName);
+    if (it == this->fileIds.end()) {
+        return 0;
+    }
+    if (this->pinned(fileName)) {
+        return -15; // BufferPoolBusyException
+    }
+    for (int i = 0; i < this->frames.size(); i++) {
+        if (this->frames[i].fileId == it->second) {
+            this->dropFrame(i);
+        }
+    }
+    if (this->files[it->second].handles.empty()) {
+        this->dropLatches(it->second);
+    }
+    return 0;
+}
+
+bool BufferManager::pinned(const string &fileName) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    auto it = this->fileIds.find(fileName);
+    if (it == this->fileIds.end()) {
+        return false;
+    }
+    for (BufferFrame &frame : this->frames) {
+        if (frame.fileId == it->second && frame.pinCount > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BufferManager::dropLatches(int fileId) {
+    for (auto it = this->latches.begin(); it != this->latches.end();) {
+        // A latch still held would be left dangling, it stays until the destructor
+        if ((int) (it->first >> 32) == fileId && pthread_rwlock_trywrlock(&it->second->lock) == 0) {
+            pthread_rwlock_unlock(&it->second->lock);
+            pthread_rwlock_destroy(&it->second->lock);
+            delete it->second;
+            it = this->latches.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+RC BufferManager::collectCounterValues(unsigned &hitCount, unsigned &missCount, unsigned &evictCount) {
+    lock_guard<recursive_mutex> guard(this->mutex);
+    hitCount = this->hitCounter;
+    missCount = this->missCounter;
+    evictCount = this->evictCounter;
+    return 0;
+}
+
+LRUPolicy::LRUPolicy(unsigned frameCount) {
+    this->position.resize(frameCount);
+    this->linked.resize(frameCount, false);
+}
+
+void LRUPolicy::pageLoaded(int frame) {
+    this->pageAccessed(frame);
+}
+
+void LRUPolicy::pageAccessed(int frame) {
+    if (this->linked[frame]) {
+        this->order.erase(this->position[frame]);
+    }
+    this->order.push_front(frame);
+    this->position[frame] = this->order.begin();
+    this->linked[frame] = true;
+}
+
+void LRUPolicy::pageRemoved(int frame) {
+    if (this->linked[frame]) {
+        this->order.erase(this->position[frame]);
+        this->linked[frame] = false;
+    }
+}
+
+int LRUPolicy::pickVictim(const vector<BufferFrame> &frames) {
+    for (auto it = this->order.rbegin(); it != this->order.rend(); it++) {
+        if (frames[*it].pinCount == 0) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+ClockPolicy::ClockPolicy(unsigned frameCount) {
+    this->referenced.resize(frameCount, false);
+    this->hand = 0;
+}
+
+void ClockPolicy::pageLoaded(int frame) {
+    this->referenced[frame] = true;
+}
+
+void ClockPolicy::pageAccessed(int frame) {
+    this->referenced[frame] = true;
+}
+
+void ClockPolicy::pageRemoved(int frame) {
+    this->referenced[frame] = false;
+}
+
+int ClockPolicy::pickVictim(const vector<BufferFrame> &frames) {
+    // Two sweeps: the first one may only clear reference bits
+    for (unsigned i = 0; i < 2 * frames.size(); i++) {
+        unsigned frame = this->hand;
+        this->hand = (this->hand + 1) % frames.size();
+        if (frames[frame].pinCount > 0) {
+            continue;
+        }
+        if (this->referenced[frame]) {
+            this->referenced[frame] = false;
+            continue;
+        }
+        return frame;
+    }
+    return -1;
+}
+
+TwoQPolicy::TwoQPolicy(unsigned frameCount) {
+    this->position.resize(frameCount);
+    this->queue.resize(frameCount, 0);
+    this->a1Limit = frameCount / 4 > 0 ? frameCount / 4 : 1;
+}
+
+void TwoQPolicy::pageLoaded(int frame) {
+    this->pageRemoved(frame);
+    this->a1.push_front(frame);
+    this->position[frame] = this->a1.begin();
+    this->queue[frame] = 1;
+}
+
+void TwoQPolicy::pageAccessed(int frame) {
+    // A second reference proves the page is hot
+    this->pageRemoved(frame);
+    this->am.push_front(frame);
+    this->position[frame] = this->am.begin();
+    this->queue[frame] = 2;
+}
+
+void TwoQPolicy::pageRemoved(int frame) {
+    if (this->queue[frame] == 1) {
+        this->a1.erase(this->position[frame]);
+    } else if (this->queue[frame] == 2) {
+        this->am.erase(this->position[frame]);
+    }
+    this->queue[frame] = 0;
+}
+
+int TwoQPolicy::pickFrom(list<int> &q, const vector<BufferFrame> &frames) {
+    for (auto it = q.rbegin(); it != q.rend(); it++) {
+        if (frames[*it].pinCount == 0) {
+            return *it;
+        }
+    }
+    return -1;
+}
+
+int TwoQPolicy::pickVictim(const vector<BufferFrame> &frames) {
+    int victim;
+    if (this->a1.size() > this->a1Limit || this->am.empty()) {
+        victim = this->pickFrom(this->a1, frames);
+        if (victim == -1) {
+            victim = this->pickFrom(this->am, frames);
+        }
+    } else {
+        victim = this->pickFrom(this->am, frames);
+        if (victim == -1) {
+            victim = this->pickFrom(this->a1, frames);
+        }
+    }
+    return victim;
+}
@@ -6,25 +6,44 @@ typedef int RC;
 typedef unsigned char byte;
 
 #define PAGE_SIZE 4096
+#define BUFFER_POOL_SIZE 1024   // number of frames in the shared buffer pool
+#define COUNTER_SYNC_INTERVAL 0 // page operations between hidden page updates, 0 = only on close/flush
+// Page I/O uses pread/pwrite on a file descriptor; build with -DPFM_FSTREAM_IO to go through fstream instead
 
 #include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <string>
 #include <cstring>
 #include <climits>
 #include <fstream>
 #include <iostream>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <pthread.h>
 
 using namespace std;
 
 class FileHandle;
 
+// READ_ONLY_MMAP maps the whole file instead of going through the buffer pool. The mapping is a snapshot
+// taken at open: pages appended later by other handles are not visible, and every write is refused.
+typedef enum {
+    READ_WRITE = 0, READ_ONLY_MMAP
+} FileMode;
+
 class PagedFileManager {
 public:
     static PagedFileManager &instance();                                // Access to the _pf_manager instance
 
     RC createFile(const std::string &fileName);                         // Create a new file
     RC destroyFile(const std::string &fileName);                        // Destroy a file
-    RC openFile(const std::string &fileName, FileHandle &fileHandle);   // Open a file
+    RC openFile(const std::string &fileName, FileHandle &fileHandle,
+                FileMode fileMode = READ_WRITE);                        // Open a file
     RC closeFile(FileHandle &fileHandle);                               // Close a file
 
 protected:
@@ -51,17 +70,223 @@ public:
     RC readHiddenPage();                                                // Read counter values
     RC writePage(PageNum pageNum, const void *data);                    // Write a specific page
     RC appendPage(const void *data);                                    // Append a specific page
-    int getNumberOfPages();                                        // Get the number of pages in the file
+    RC appendPage(const void *data, PageNum &pageNum);                  // Same, and tell which page it became
+    int getNumberOfPages();                                             // Get the number of pages in the file
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount,
                             unsigned &appendPageCount);                 // Put current counter values into variables
     RC updateCounterValues();                                           // Update current counter values into hidden page
-    RC openFile(const std::string &fileName);
+    RC flushCounterValues();                                            // Persist counters changed since the last sync
+    RC setCounterSyncInterval(unsigned interval);                       // 1 = every operation, 0 = only on close/flush
+    RC openFile(const std::string &fileName, FileMode fileMode = READ_WRITE);
     RC closeFile();
 
+    // Pin a page in the buffer pool and expose its frame. The frame stays valid until unpinPage().
+    // On a READ_ONLY_MMAP handle this points straight into the mapping and must not be written to.
+    RC pinPage(PageNum pageNum, void *&data);
+    RC unpinPage(PageNum pageNum, bool dirty);
+
+    // Reader/writer latch on a page, shared by every handle of the file. A handle belongs to one thread at
+    // a time: threads working on the same file each open their own. No-ops on a READ_ONLY_MMAP handle.
+    RC latchPage(PageNum pageNum, bool exclusive);
+    RC unlatchPage(PageNum pageNum);
+
+    // Same, and tell the version of the page once latched. It changes whenever the page is written, so
+    // a reader keeping the page pinned between latches can tell whether what it saw still holds.
+    RC latchPage(PageNum pageNum, bool exclusive, unsigned long long &version);
+
     bool fileHandleOccupied();
 
+    bool isReadOnly();
+
 private:
+    friend class BufferManager;
+
+    RC readPageFromDisk(PageNum pageNum, void *data);                   // Bypass the buffer pool
+    RC writePageToDisk(PageNum pageNum, const void *data);
+    RC mapFile(const string &fileName);
+    RC readBytes(off_t offset, void *data, size_t length);              // One positioned read, no shared cursor
+    RC writeBytes(off_t offset, const void *data, size_t length);
+    RC countersChanged();                                               // Sync the hidden page once the interval is due
+
+#ifdef PFM_FSTREAM_IO
     fstream fs;
+#else
+    int fd;
+#endif
+    int bufferFileId;                                                   // -1 for a mapped file
+    char *mappedFile;
+    size_t mappedSize;
+    atomic<unsigned> numberOfPages;                                     // Established at open, kept up by appends
+    unsigned counterSyncInterval;
+    unsigned pendingCounterUpdates;                                     // Operations not yet in the hidden page
+};
+
+typedef enum {
+    LRU = 0, CLOCK, TWO_Q
+} ReplacementPolicyType;
+
+struct BufferFrame {
+    int fileId;                 // -1 when the frame is free
+    PageNum pageNum;
+    unsigned pinCount;
+    bool dirty;
+    char *data;
+};
+
+// Decides which unpinned frame is given up when the pool is full
+class ReplacementPolicy {
+public:
+    virtual ~ReplacementPolicy() = default;
+
+    virtual void pageLoaded(int frame) = 0;                             // A page has been brought into frame
+
+    virtual void pageAccessed(int frame) = 0;                           // A resident page has been hit
+
+    virtual void pageRemoved(int frame) = 0;                            // The frame has become free
+
+    virtual int pickVictim(const vector<BufferFrame> &frames) = 0;      // -1 if every frame is pinned
+};
+
+class LRUPolicy : public ReplacementPolicy {
+public:
+    explicit LRUPolicy(unsigned frameCount);
+
+    void pageLoaded(int frame) override;
+
+    void pageAccessed(int frame) override;
+
+    void pageRemoved(int frame) override;
+
+    int pickVictim(const vector<BufferFrame> &frames) override;
+
+private:
+    list<int> order;                                                    // Most recently used at the front
+    vector<list<int>::iterator> position;
+    vector<bool> linked;
+};
+
+class ClockPolicy : public ReplacementPolicy {
+public:
+    explicit ClockPolicy(unsigned frameCount);
+
+    void pageLoaded(int frame) override;
+
+    void pageAccessed(int frame) override;
+
+    void pageRemoved(int frame) override;
+
+    int pickVictim(const vector<BufferFrame> &frames) override;
+
+private:
+    vector<bool> referenced;
+    unsigned hand;
+};
+
+// Simplified 2Q: first references go to a FIFO queue, re-referenced pages move to an LRU queue
+class TwoQPolicy : public ReplacementPolicy {
+public:
+    explicit TwoQPolicy(unsigned frameCount);
+
+    void pageLoaded(int frame) override;
+
+    void pageAccessed(int frame) override;
+
+    void pageRemoved(int frame) override;
+
+    int pickVictim(const vector<BufferFrame> &frames) override;
+
+private:
+    list<int> a1;                                                       // FIFO of pages seen once
+    list<int> am;                                                       // LRU of hot pages
+    vector<list<int>::iterator> position;
+    vector<char> queue;                                                 // 0: none, 1: a1, 2: am
+    unsigned a1Limit;
+
+    int pickFrom(list<int> &q, const vector<BufferFrame> &frames);
+};
+
+// Process-wide page cache shared by every FileHandle
+class BufferManager {
+public:
+    static BufferManager &instance();                                   // Access to the _buffer_manager instance
+
+    RC setReplacementPolicy(ReplacementPolicyType policyType);          // Only allowed when no page is pinned
+
+    RC resize(unsigned frameCount);                                     // Only allowed when no page is pinned
+
+    int registerFile(const string &fileName, FileHandle *fileHandle);   // Attach an opened handle, return file id
+
+    RC unregisterFile(int fileId, FileHandle *fileHandle);              // Flush when the last handle leaves
+
+    void pageAppended(int fileId);                                      // Grow the page count of every handle
+
+    RC pinPage(int fileId, PageNum pageNum, bool load, char *&data);    // Skip the disk read if !load
+
+    RC unpinPage(int fileId, PageNum pageNum, bool dirty);
+
+    RC appendPage(int fileId, FileHandle *fileHandle, const void *data, PageNum &pageNum);
+
+    RC latchPage(int fileId, PageNum pageNum, bool exclusive, unsigned long long &version);
+
+    RC unlatchPage(int fileId, PageNum pageNum);
+
+    RC flushFile(int fileId);                                           // Write back dirty pages of a file
+
+    RC flushFile(const string &fileName);                               // Same, looked up by name
+
+    RC discardFile(const string &fileName);                             // Drop cached pages of a destroyed file,
+                                                                        // refused while one of them is pinned
+
+    bool pinned(const string &fileName);                                // A page of the file is pinned
+
+    RC collectCounterValues(unsigned &hitCount, unsigned &missCount, unsigned &evictCount);
+
+    unsigned hitCounter;
+    unsigned missCounter;
+    unsigned evictCounter;
+
+protected:
+    BufferManager();                                                    // Prevent construction
+    ~BufferManager();                                                   // Prevent unwanted destruction
+    BufferManager(const BufferManager &);                               // Prevent construction by copying
+    BufferManager &operator=(const BufferManager &);                    // Prevent assignment
+
+private:
+    struct BufferFile {
+        string fileName;
+        vector<FileHandle *> handles;                                   // Open handles able to do the I/O
+        dev_t device;                                                   // Identity at last close, to detect
+        ino_t inode;                                                    // files replaced behind our back
+        off_t fileSize;
+    };
+
+    struct PageLatch {
+        pthread_rwlock_t lock;
+        atomic<unsigned long long> version;                             // Writes of the page since the latch exists
+    };
+
+    vector<BufferFrame> frames;
+    vector<BufferFile> files;
+    unordered_map<string, int> fileIds;
+    unordered_map<unsigned long long, int> pageTable;                   // (fileId, pageNum) -> frame
+    ReplacementPolicy *policy;
+    ReplacementPolicyType policyType;
+    unordered_map<unsigned long long, PageLatch *> latches;             // (fileId, pageNum) -> page latch
+    recursive_mutex mutex;                                              // Guards the members above, latches are waited on outside
+
+    static unsigned long long pageKey(int fileId, PageNum pageNum);
+
+    ReplacementPolicy *createPolicy(ReplacementPolicyType type, unsigned frameCount);
+
+    int grabFrame();                                                    // Free frame or evicted victim
+
+    RC writeBack(int frame);
+
+    void dropFrame(int frame);
+
+    void dropLatches(int fileId);                                       // Free the latches of a file nobody has open
+
+    bool pinned();
 };
 
 #endif
\ No newline at end of file
@@ -23,8 +23,8 @@ RC RecordBasedFileManager::destroyFile(const string &fileName) {
     return _pf_manager->destroyFile(fileName);
 }
 
-RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle) {
-    return _pf_manager->openFile(fileName, fileHandle);
+RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle, FileMode fileMode) {
+    return _pf_manager->openFile(fileName, fileHandle, fileMode);
 }
 
 RC RecordBasedFileManager::closeFile(FileHandle &fileHandle) {
@@ -36,14 +36,32 @@ short RecordBasedFileManager::getNullFlagSize(int fieldCount) {
     return ceil((double) fieldCount / CHAR_BIT);
 }
 
+bool RecordBasedFileManager::hasSlotList(const void *page) {
+    short marker;
+    memcpy(&marker, (char *) page + PAGE_SIZE - sizeof(short), sizeof(short));
+    return marker == PAGE_FORMAT_SLOT_LIST;
+}
+
+short RecordBasedFileManager::getPageHeaderSize(const void *page) {
+    return hasSlotList(page) ? 4 * sizeof(short) : 2 * sizeof(short);
+}
+
 short RecordBasedFileManager::getPageSlotTotal(const void *page) {
     short pageSlotTotal;
-    memcpy(&pageSlotTotal, (char *) page + PAGE_SIZE - sizeof(short), sizeof(short));
+    if (hasSlotList(page)) {
+        memcpy(&pageSlotTotal, (char *) page + PAGE_SIZE - 3 * sizeof(short), sizeof(short));
+    } else {
+        memcpy(&pageSlotTotal, (char *) page + PAGE_SIZE - sizeof(short), sizeof(short));
+    }
     return pageSlotTotal;
 }
 
 void RecordBasedFileManager::setPageSlotTotal(const void *page, short slotTotal) {
-    memcpy((char *) page + PAGE_SIZE - sizeof(short), &slotTotal, sizeof(short));
+    if (hasSlotList(page)) {
+        memcpy((char *) page + PAGE_SIZE - 3 * sizeof(short), &slotTotal, sizeof(short));
+    } else {
+        memcpy((char *) page + PAGE_SIZE - sizeof(short), &slotTotal, sizeof(short));
+    }
 }
 
 short RecordBasedFileManager::getPageFreeSpace(const void *page) {
@@ -56,30 +74,48 @@ void RecordBasedFileManager::setPageFreeSpace(const void *page, short space) {
     memcpy((char *) page + PAGE_SIZE - 2 * sizeof(short), &space, sizeof(short));
 }
 
+short RecordBasedFileManager::getFreeSlotHead(const void *page) {
+    short head;
+    memcpy(&head, (char *) page + PAGE_SIZE - 4 * sizeof(short), sizeof(short));
+    return head;
+}
+
+void RecordBasedFileManager::setFreeSlotHead(const void *page, short slotNum) {
+    memcpy((char *) page + PAGE_SIZE - 4 * sizeof(short), &slotNum, sizeof(short));
+}
+
+void RecordBasedFileManager::initDataPage(const void *page) {
+    short marker = PAGE_FORMAT_SLOT_LIST;
+    memcpy((char *) page + PAGE_SIZE - sizeof(short), &marker, sizeof(short));
+    setPageFreeSpace(page, PAGE_SIZE - 4 * sizeof(short));
+    setPageSlotTotal(page, 0);
+    setFreeSlotHead(page, -1);
+}
+
 short RecordBasedFileManager::getRecordOffset(const void *page, short slotNum) {
     short offset;
-    int ptr = PAGE_SIZE - 2 * sizeof(short);
+    int ptr = PAGE_SIZE - getPageHeaderSize(page);
     ptr -= 2 * (slotNum + 1) * sizeof(short);
     memcpy(&offset, (char *) page + ptr, sizeof(short));
     return offset;
 }
 
 void RecordBasedFileManager::setRecordOffset(const void *page, short offset, short slotNum) {
-    int ptr = PAGE_SIZE - 2 * sizeof(short);
+    int ptr = PAGE_SIZE - getPageHeaderSize(page);
     ptr -= 2 * (slotNum + 1) * sizeof(short);
     memcpy((char *) page + ptr, &offset, sizeof(short));
 }
 
 short RecordBasedFileManager::getRecordSize(const void *page, short slotNum) {
     short recordSize;
-    short ptr = PAGE_SIZE - 2 * sizeof(short);
+    short ptr = PAGE_SIZE - getPageHeaderSize(page);
     ptr -= (2 * slotNum + 1) * sizeof(short);
     memcpy(&recordSize, (char *) page + ptr, sizeof(short));
     return recordSize;
 }
 
 void RecordBasedFileManager::setRecordSize(const void *page, short recordSize, short slotNum) {
-    int ptr = PAGE_SIZE - 2 * sizeof(short);
+    int ptr = PAGE_SIZE - getPageHeaderSize(page);
     ptr -= (2 * slotNum + 1) * sizeof(short);
     memcpy((char *) page + ptr, &recordSize, sizeof(short));
 }
@@ -93,10 +129,30 @@ void RecordBasedFileManager::getAttributeOffset(const void *page, short pagePtr,
     }
 }
 
+void RecordBasedFileManager::projectRecord(const void *page, short pagePtr, int fieldCount,
+                                           const vector<short> &attrIdx, void *data) {
+    short nullFlagSize = this->getNullFlagSize(fieldCount);
+    int reNullFlagsSize = this->getNullFlagSize(attrIdx.size());
+    auto *reNullFlags = (unsigned char *) data;
+    memset(reNullFlags, 0, reNullFlagsSize);
+    short offset, prevOffset, sz;
+    short dataPtr = reNullFlagsSize;
+    for (int i = 0; i < attrIdx.size(); i++) {
+        this->getAttributeOffset(page, pagePtr, fieldCount, nullFlagSize, attrIdx[i], offset, prevOffset);
+        sz = offset - prevOffset;
+        if (sz > 0) {
+            memcpy((char *) data + dataPtr, (char *) page + pagePtr + prevOffset, sz);
+            dataPtr += sz;
+        } else {
+            reNullFlags[i / 8] |= (1 << (7 - i % 8));
+        }
+    }
+}
+
 short RecordBasedFileManager::getInsertPtr(const void *page) {
     return PAGE_SIZE - this->getPageFreeSpace(page) -
            this->getPageSlotTotal(page) * 2 * sizeof(short) -
-           2 * sizeof(short);
+           this->getPageHeaderSize(page);
 }
 
 short RecordBasedFileManager::countRemainSpace(const void *page, short freeSpace, short recordSize, bool newFlag) {
@@ -110,6 +166,11 @@ short RecordBasedFileManager::countRemainSpace(const void *page, short freeSpace
 
 short RecordBasedFileManager::findFreeSlot(const void *page) {
     short slotTotal = this->getPageSlotTotal(page);
+    if (this->hasSlotList(page)) {
+        short head = this->getFreeSlotHead(page);
+        return head == -1 ? slotTotal : head;
+    }
+    // Pages from before the free list, walk the directory
     short slot = 0;
     short offset;
     while (slot < slotTotal) {
@@ -122,6 +183,24 @@ short RecordBasedFileManager::findFreeSlot(const void *page) {
     return slot;
 }
 
+void RecordBasedFileManager::takeSlot(const void *page, short slotNum) {
+    short slotTotal = this->getPageSlotTotal(page);
+    if (slotNum == slotTotal) {
+        this->setPageSlotTotal(page, slotTotal + 1);
+    } else if (this->hasSlotList(page)) {
+        // A free slot keeps the next free one in its size field
+        this->setFreeSlotHead(page, this->getRecordSize(page, slotNum));
+    }
+}
+
+void RecordBasedFileManager::releaseSlot(const void *page, short slotNum) {
+    this->setRecordOffset(page, -1, slotNum);
+    if (this->hasSlotList(page)) {
+        this->setRecordSize(page, this->getFreeSlotHead(page), slotNum);
+        this->setFreeSlotHead(page, slotNum);
+    }
+}
+
 // Referenced from test_util prepareRecord function
 short RecordBasedFileManager::parseRecord(const vector<Attribute> &recordDescriptor,
                                           const void *data, const void *offsetTable) {
@@ -172,83 +251,234 @@ RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Att
     short recordSize = this->parseRecord(recordDescriptor, data, offsetTable);
     void *page = malloc(PAGE_SIZE);
     memset(page, '\0', PAGE_SIZE);
-    unsigned numberOfPages = fileHandle.getNumberOfPages();
     bool needNewPage = true;
     short remainSpace = 0;
     unsigned currentPID = 0;
-    if (numberOfPages != 0) {
-        currentPID = numberOfPages - 1;
-        fileHandle.readPage(currentPID, page);
+    if (this->findPageWithSpace(fileHandle, recordSize, -1, page, currentPID) == 0) {
         needNewPage = false;
-        remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page),
-                                             recordSize, true);
+        remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true);
+    }
+    if (needNewPage) {
+        memset(page, '\0', PAGE_SIZE);
+        this->initDataPage(page);
+        remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true);
+        this->getNewPageNum(fileHandle, currentPID);
+    }
+    rid.pageNum = currentPID;
+    rid.slotNum = this->placeRecord(page, recordDescriptor, data, offsetTable, recordSize, remainSpace);
+    RC rc = this->writeDataPage(fileHandle, currentPID, page, needNewPage);
+    free(page);
+    free(offsetTable);
+    return rc;
+}
+
+RC RecordBasedFileManager::insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                                         const vector<const void *> &data, vector<RID> &rids) {
+    rids.clear();
+    rids.reserve(data.size());
+    char *offsetTable = (char *) malloc(recordDescriptor.size() * sizeof(short));
+    void *page = malloc(PAGE_SIZE);
+    bool pageLoaded = false;
+    bool needNewPage = false;
+    unsigned currentPID = 0;
+    RC rc = 0;
+    for (const void *record : data) {
+        short recordSize = this->parseRecord(recordDescriptor, record, offsetTable);
+        short remainSpace = -1;
+        if (pageLoaded) {
+            remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true);
+        }
         if (remainSpace < 0) {
-            needNewPage = true;
-            if (numberOfPages > 1) {
-                for (int i = numberOfPages - 2; i >= 0; i--) {
-                    fileHandle.readPage(i, page);
-                    remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page),
-                                                         recordSize, true);
-                    if (remainSpace >= 0) {
-                        needNewPage = false;
-                        currentPID = i;
-                        break;
-                    }
+            // The page is full, it is written once and the next one is filled in memory
+            if (pageLoaded) {
+                rc = this->writeDataPage(fileHandle, currentPID, page, needNewPage);
+                if (rc != 0) {
+                    break;
                 }
             }
+            needNewPage = this->findPageWithSpace(fileHandle, recordSize, -1, page, currentPID) != 0;
+            if (needNewPage) {
+                memset(page, '\0', PAGE_SIZE);
+                this->initDataPage(page);
+                this->getNewPageNum(fileHandle, currentPID);
+            }
+            pageLoaded = true;
+            remainSpace = this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true);
         }
+        RID rid;
+        rid.pageNum = currentPID;
+        rid.slotNum = this->placeRecord(page, recordDescriptor, record, offsetTable, recordSize, remainSpace);
+        rids.push_back(rid);
     }
-    if (needNewPage) {
-        this->setPageFreeSpace(page, PAGE_SIZE - 2 * sizeof(short));
-        this->setPageSlotTotal(page, 0);
-        remainSpace = this->countRemainSpace(page, PAGE_SIZE - 2 * sizeof(short),
-                                             recordSize, true);
-        numberOfPages++;
-        currentPID = numberOfPages - 1;
+    if (rc == 0 && pageLoaded) {
+        rc = this->writeDataPage(fileHandle, currentPID, page, needNewPage);
     }
-    rid.pageNum = currentPID;
-    rid.slotNum = this->findFreeSlot(page);
-    short slotTotal = this->getPageSlotTotal(page);
+    free(page);
+    free(offsetTable);
+    return rc;
+}
+
+short RecordBasedFileManager::placeRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data,
+                                          const char *offsetTable, short recordSize, short remainSpace) {
+    short slotNum = this->findFreeSlot(page);
     short insertPtr = this->getInsertPtr(page);
     this->copyRecord(page, insertPtr, recordDescriptor.size(),
                      data, offsetTable, recordSize);
+    this->takeSlot(page, slotNum);
     this->setPageFreeSpace(page, remainSpace);
-    if (rid.slotNum == slotTotal) {
-        this->setPageSlotTotal(page, slotTotal + 1);
+    this->setRecordOffset(page, insertPtr + recordSize, slotNum);
+    this->setRecordSize(page, recordSize, slotNum);
+    return slotNum;
+}
+
+RC RecordBasedFileManager::writeDataPage(FileHandle &fileHandle, unsigned pageNum, const void *page, bool append) {
+    RC rc = append ? fileHandle.appendPage(page) : fileHandle.writePage(pageNum, page);
+    if (rc != 0) {
+        return rc;
     }
-    this->setRecordOffset(page, insertPtr + recordSize, rid.slotNum);
-    this->setRecordSize(page, recordSize, rid.slotNum);
-    if (needNewPage) {
-        fileHandle.appendPage(page);
-    } else {
-        fileHandle.writePage(currentPID, page);
+    return this->updateFreeSpaceMap(fileHandle, pageNum, page);
+}
+
+bool RecordBasedFileManager::isFreeSpaceMapPage(const void *page) {
+    return getPageSlotTotal(page) == -1;
+}
+
+unsigned char RecordBasedFileManager::getFreeSpaceBucket(const void *page) {
+    short freeSpace = getPageFreeSpace(page);
+    if (freeSpace <= 0) {
+        return 0;
     }
-    free(page);
-    free(offsetTable);
+    return freeSpace / FSM_BUCKET_SIZE > UCHAR_MAX ? UCHAR_MAX : freeSpace / FSM_BUCKET_SIZE;
+}
+
+RC RecordBasedFileManager::getNewPageNum(FileHandle &fileHandle, unsigned &pageNum) {
+    unsigned numberOfPages = fileHandle.getNumberOfPages();
+    bool mapped = numberOfPages == 0;
+    if (numberOfPages % FSM_INTERVAL == 0 && numberOfPages != 0) {
+        void *firstPage;
+        if (fileHandle.pinPage(0, firstPage) == 0) {
+            mapped = this->isFreeSpaceMapPage(firstPage);
+            fileHandle.unpinPage(0, false);
+        }
+    }
+    if (mapped) {
+        // This page number belongs to a map page, which has to exist before the pages it covers
+        void *fsmPage = malloc(PAGE_SIZE);
+        memset(fsmPage, 0, PAGE_SIZE);
+        *((unsigned char *) fsmPage) = FSM_VERSION;
+        this->setPageFreeSpace(fsmPage, 0);
+        this->setPageSlotTotal(fsmPage, -1);
+        RC rc = fileHandle.appendPage(fsmPage);
+        free(fsmPage);
+        if (rc != 0) {
+            return rc;
+        }
+        numberOfPages++;
+    }
+    pageNum = numberOfPages;
     return 0;
 }
 
+RC RecordBasedFileManager::findPageWithSpace(FileHandle &fileHandle, short recordSize, int excludedPage,
+                                             void *page, unsigned &pageNum) {
+    int numberOfPages = fileHandle.getNumberOfPages();
+    if (numberOfPages == 0) {
+        return -1;
+    }
+    // Worst case need: the record, at least room for a forwarding pointer, and a new slot
+    short needed = (recordSize >= sizeof(unsigned) + sizeof(short) ? recordSize : sizeof(unsigned) + sizeof(short)) +
+                   2 * sizeof(short);
+    int lastPage = numberOfPages - 1;
+    int fsmPageNum = lastPage / FSM_INTERVAL * FSM_INTERVAL;
+    while (fsmPageNum >= 0) {
+        void *fsmPage;
+        if (fileHandle.pinPage(fsmPageNum, fsmPage) != 0) {
+            return -1;
+        }
+        if (!this->isFreeSpaceMapPage(fsmPage)) {
+            fileHandle.unpinPage(fsmPageNum, false);
+            return this->findPageWithSpaceLegacy(fileHandle, recordSize, excludedPage, page, pageNum);
+        }
+        // Prefer the tail of the file, like appending would
+        bool dirty = false;
+        int last = lastPage - fsmPageNum < FSM_INTERVAL - 1 ? lastPage - fsmPageNum : FSM_INTERVAL - 1;
+        for (int i = last; i >= 1; i--) {
+            unsigned char bucket = *((unsigned char *) fsmPage + i);
+            if (bucket * FSM_BUCKET_SIZE < needed || fsmPageNum + i == excludedPage) {
+                continue;
+            }
+            fileHandle.readPage(fsmPageNum + i, page);
+            if (this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true) >= 0) {
+                fileHandle.unpinPage(fsmPageNum, dirty);
+                pageNum = fsmPageNum + i;
+                return 0;
+            }
+            // Out of date entry, repair it and keep looking
+            *((unsigned char *) fsmPage + i) = this->getFreeSpaceBucket(page);
+            dirty = true;
+        }
+        fileHandle.unpinPage(fsmPageNum, dirty);
+        fsmPageNum -= FSM_INTERVAL;
+    }
+    return -1;
+}
+
+RC RecordBasedFileManager::findPageWithSpaceLegacy(FileHandle &fileHandle, short recordSize, int excludedPage,
+                                                   void *page, unsigned &pageNum) {
+    // Files written before the free space map existed are searched backwards page by page
+    for (int i = fileHandle.getNumberOfPages() - 1; i >= 0; i--) {
+        if (i == excludedPage) {
+            continue;
+        }
+        fileHandle.readPage(i, page);
+        if (this->countRemainSpace(page, this->getPageFreeSpace(page), recordSize, true) >= 0) {
+            pageNum = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+RC RecordBasedFileManager::updateFreeSpaceMap(FileHandle &fileHandle, unsigned pageNum, const void *page) {
+    unsigned fsmPageNum = pageNum / FSM_INTERVAL * FSM_INTERVAL;
+    if (fsmPageNum == pageNum) {
+        return 0;
+    }
+    void *fsmPage;
+    RC rc = fileHandle.pinPage(fsmPageNum, fsmPage);
+    if (rc != 0) {
+        return rc;
+    }
+    unsigned char bucket = this->getFreeSpaceBucket(page);
+    bool dirty = false;
+    if (this->isFreeSpaceMapPage(fsmPage) && *((unsigned char *) fsmPage + pageNum - fsmPageNum) != bucket) {
+        *((unsigned char *) fsmPage + pageNum - fsmPageNum) = bucket;
+        dirty = true;
+    }
+    return fileHandle.unpinPage(fsmPageNum, dirty);
+}
+
 RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
                                       const RID &rid, void *data) {
     unsigned numberOfPages = fileHandle.getNumberOfPages();
     if (rid.pageNum >= numberOfPages) {
         return -1;
     }
-    void *page = malloc(PAGE_SIZE);
-    fileHandle.readPage(rid.pageNum, page);
-    if (rid.slotNum >= this->getPageSlotTotal(page)) {
-        free(page);
+    void *page;
+    PageNum pageNum = rid.pageNum;
+    RC rc = fileHandle.pinPage(pageNum, page);
+    if (rc != 0) {
+        return rc;
+    }
+    if ((int) rid.slotNum >= this->getPageSlotTotal(page)) {
+        fileHandle.unpinPage(pageNum, false);
         return -1;
     }
-    RID *id = (RID *) malloc(sizeof(RID));
-    memcpy(id, &rid, sizeof(RID));
     short recordOffset, recordSize;
-    this->locateRecord(fileHandle, page, recordOffset, recordSize, id);
-    if (id == nullptr) {
-        free(page);
-        return -5;
+    rc = this->locatePinnedRecord(fileHandle, page, pageNum, rid.slotNum, recordOffset, recordSize);
+    if (rc != 0) {
+        return rc;
     }
-    free(id);
     int fieldCount = recordDescriptor.size();
     int nullFlagSize = this->getNullFlagSize(fieldCount);
     short pagePtr = recordOffset - recordSize;
@@ -256,10 +486,115 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
     short headerSize = nullFlagSize + fieldCount * sizeof(short);
     memcpy((char *) data + nullFlagSize, (char *) page + pagePtr + headerSize,
            recordSize - headerSize);
-    free(page);
+    fileHandle.unpinPage(pageNum, false);
     return 0;
 }
 
+RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                                       const vector<RID> &rids, const vector<void *> &data, vector<bool> &found) {
+    return this->readRecords(fileHandle, recordDescriptor, rids, nullptr, data, found);
+}
+
+RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                                       const vector<RID> &rids, const vector<string> &attrNames,
+                                       const vector<void *> &data, vector<bool> &found) {
+    vector<short> attrIdx;
+    for (const string &attrName : attrNames) {
+        short j;
+        for (j = 0; j < recordDescriptor.size(); j++) {
+            if (recordDescriptor[j].name == attrName) {
+                break;
+            }
+        }
+        if (j == recordDescriptor.size()) {
+            return -7; // AttributeNotFoundException
+        }
+        attrIdx.push_back(j);
+    }
+    return this->readRecords(fileHandle, recordDescriptor, rids, &attrIdx, data, found);
+}
+
+RC RecordBasedFileManager::readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                                       const vector<RID> &rids, const vector<short> *attrIdx,
+                                       const vector<void *> &data, vector<bool> &found) {
+    vector<int> order(rids.size());
+    for (int i = 0; i < rids.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&rids](int a, int b) {
+        return rids[a].pageNum < rids[b].pageNum ||
+               (rids[a].pageNum == rids[b].pageNum && rids[a].slotNum < rids[b].slotNum);
+    });
+    found.assign(rids.size(), false);
+    unsigned numberOfPages = fileHandle.getNumberOfPages();
+    int fieldCount = recordDescriptor.size();
+    int nullFlagSize = this->getNullFlagSize(fieldCount);
+    short headerSize = nullFlagSize + fieldCount * sizeof(short);
+    void *page = nullptr;
+    PageNum pageNum = 0;
+    RC rc = 0;
+    for (int i : order) {
+        const RID &rid = rids[i];
+        if (page == nullptr || rid.pageNum != pageNum) {
+            if (page != nullptr) {
+                fileHandle.unpinPage(pageNum, false);
+                page = nullptr;
+            }
+            if (rid.pageNum >= numberOfPages) {
+                continue;
+            }
+            pageNum = rid.pageNum;
+            rc = fileHandle.pinPage(pageNum, page);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+        if ((int) rid.slotNum >= this->getPageSlotTotal(page)) {
+            continue;
+        }
+        void *recordPage = page;
+        PageNum recordPageNum = pageNum;
+        short recordOffset = this->getRecordOffset(page, rid.slotNum);
+        if (recordOffset == -1) {
+            continue;
+        }
+        short recordSize = this->getRecordSize(page, rid.slotNum);
+        bool moved = recordSize == -1;
+        if (moved) {
+            // Moved to another page by an update, follow it with a pin of its own
+            rc = fileHandle.pinPage(recordPageNum, recordPage);
+            if (rc != 0) {
+                break;
+            }
+            rc = this->locatePinnedRecord(fileHandle, recordPage, recordPageNum, rid.slotNum, recordOffset,
+                                          recordSize);
+            if (rc == -5) {
+                rc = 0;
+                continue;
+            }
+            if (rc != 0) {
+                break;
+            }
+        }
+        short pagePtr = recordOffset - recordSize;
+        if (attrIdx == nullptr) {
+            memcpy((char *) data[i], (char *) recordPage + pagePtr, nullFlagSize);
+            memcpy((char *) data[i] + nullFlagSize, (char *) recordPage + pagePtr + headerSize,
+                   recordSize - headerSize);
+        } else {
+            this->projectRecord(recordPage, pagePtr, fieldCount, *attrIdx, data[i]);
+        }
+        found[i] = true;
+        if (moved) {
+            fileHandle.unpinPage(recordPageNum, false);
+        }
+    }
+    if (page != nullptr) {
+        fileHandle.unpinPage(pageNum, false);
+    }
+    return rc;
+}
+
 void RecordBasedFileManager::locateRecord(FileHandle &fileHandle, void *page,
                                           short &recordOffset, short &recordSize, RID *&id) {
     recordOffset = this->getRecordOffset(page, id->slotNum);
@@ -289,6 +624,38 @@ void RecordBasedFileManager::locateRecord(FileHandle &fileHandle, void *page,
     }
 }
 
+// Same as locateRecord, but works on a page pinned in the buffer pool. On success the page holding
+// the record stays pinned and pageNum tells which one it is; on failure nothing is left pinned.
+RC RecordBasedFileManager::locatePinnedRecord(FileHandle &fileHandle, void *&page, PageNum &pageNum, short slotNum,
+                                              short &recordOffset, short &recordSize) {
+    recordOffset = this->getRecordOffset(page, slotNum);
+    if (recordOffset == -1) {
+        fileHandle.unpinPage(pageNum, false);
+        return -5; // RecordNotFoundException
+    }
+    recordSize = this->getRecordSize(page, slotNum);
+    short pagePtrSize = sizeof(unsigned) + sizeof(short);
+    while (recordSize == -1) {
+        recordOffset -= pagePtrSize;
+        unsigned nextPageNum;
+        memcpy(&nextPageNum, (char *) page + recordOffset, sizeof(unsigned));
+        memcpy(&slotNum, (char *) page + recordOffset + sizeof(unsigned), sizeof(short));
+        fileHandle.unpinPage(pageNum, false);
+        pageNum = nextPageNum;
+        RC rc = fileHandle.pinPage(pageNum, page);
+        if (rc != 0) {
+            return rc;
+        }
+        recordOffset = this->getRecordOffset(page, slotNum);
+        if (recordOffset == -1) {
+            fileHandle.unpinPage(pageNum, false);
+            return -5; // RecordNotFoundException
+        }
+        recordSize = this->getRecordSize(page, slotNum);
+    }
+    return 0;
+}
+
 void RecordBasedFileManager::shiftRecord(const void *page, short recordOffset, short distance) {
     short slotTotal = this->getPageSlotTotal(page);
     short offset;
@@ -318,7 +685,7 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
     void *page = malloc(PAGE_SIZE);
     fileHandle.readPage(rid.pageNum, page);
     short slotTotal = this->getPageSlotTotal(page);
-    if (rid.slotNum >= slotTotal) {
+    if ((int) rid.slotNum >= slotTotal) {
         free(page);
         return -1;
     }
@@ -331,8 +698,10 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
         return -5;
     }
     this->shiftRecord(page, recordOffset, -recordSize);
-    this->setRecordOffset(page, -1, id->slotNum);
+    this->setPageFreeSpace(page, this->getPageFreeSpace(page) + recordSize);
+    this->releaseSlot(page, id->slotNum);
     fileHandle.writePage(id->pageNum, page);
+    this->updateFreeSpaceMap(fileHandle, id->pageNum, page);
     free(id);
     free(page);
     return 0;
@@ -379,7 +748,8 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
     memset(page, '\0', PAGE_SIZE);
     fileHandle.readPage(rid.pageNum, page);
     short slotTotal = this->getPageSlotTotal(page);
-    if (rid.slotNum >= slotTotal) {
+    if ((int) rid.slotNum >= slotTotal) {
+        free(page);
         return -1;
     }
     short recordOffset, recordSize;
@@ -411,36 +781,24 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
     } else {
         char *cache = (char *) malloc(PAGE_SIZE);
         memset(cache, '\0', PAGE_SIZE);
-        unsigned pageNum = numberOfPages;
+        unsigned pageNum = 0;
         bool needNewPage = true;
-        if (numberOfPages > 1) {
-            for (int i = numberOfPages - 1; i >= 0; i--) {
-                if (i == id->pageNum) continue;
-                pageNum = i;
-                fileHandle.readPage(pageNum, cache);
-                remainSpace = this->countRemainSpace(cache, this->getPageFreeSpace(cache), newSize, true);
-                if (remainSpace >= 0) {
-                    needNewPage = false;
-                    break;
-                }
-            }
+        if (this->findPageWithSpace(fileHandle, newSize, id->pageNum, cache, pageNum) == 0) {
+            needNewPage = false;
+            remainSpace = this->countRemainSpace(cache, this->getPageFreeSpace(cache), newSize, true);
         }
         if (needNewPage) {
-            this->setPageFreeSpace(cache, PAGE_SIZE - 2 * sizeof(short));
-            this->setPageSlotTotal(cache, 0);
-            remainSpace = this->countRemainSpace(cache, PAGE_SIZE - 2 * sizeof(short), newSize, true);
-            numberOfPages++;
-            pageNum = numberOfPages - 1;
+            memset(cache, '\0', PAGE_SIZE);
+            this->initDataPage(cache);
+            remainSpace = this->countRemainSpace(cache, this->getPageFreeSpace(cache), newSize, true);
+            this->getNewPageNum(fileHandle, pageNum);
         }
         short slotNum = this->findFreeSlot(cache);
-        short slotTotal = this->getPageSlotTotal(cache);
         short insertPtr = this->getInsertPtr(cache);
         this->copyRecord(cache, insertPtr, fieldCount,
                          data, offsetTable, newSize);
+        this->takeSlot(cache, slotNum);
         this->setPageFreeSpace(cache, remainSpace);
-        if (slotNum == slotTotal) {
-            this->setPageSlotTotal(cache, slotTotal + 1);
-        }
         this->setRecordOffset(cache, insertPtr + newSize, slotNum);
         this->setRecordSize(cache, newSize, slotNum);
         if (needNewPage) {
@@ -448,6 +806,7 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         } else {
             fileHandle.writePage(pageNum, cache);
         }
+        this->updateFreeSpaceMap(fileHandle, pageNum, cache);
         free(cache);
         insertPtr = recordOffset - recordSize;
         memcpy((char *) page + insertPtr, &pageNum, sizeof(unsigned));
@@ -456,8 +815,10 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         this->shiftRecord(page, recordOffset, distance);
         this->setRecordOffset(page, recordOffset + distance, id->slotNum);
         this->setRecordSize(page, -1, id->slotNum);
+        this->setPageFreeSpace(page, this->getPageFreeSpace(page) - distance);
     }
     fileHandle.writePage(id->pageNum, page);
+    this->updateFreeSpaceMap(fileHandle, id->pageNum, page);
     free(id);
     free(offsetTable);
     free(page);
@@ -470,11 +831,6 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     if (rid.pageNum >= numberOfPages) {
         return -1;
     }
-    void *page = malloc(PAGE_SIZE);
-    fileHandle.readPage(rid.pageNum, page);
-    if (rid.slotNum >= this->getPageSlotTotal(page)) {
-        return -1;
-    }
     int fieldCount = recordDescriptor.size();
     int i;
     for (i = 0; i < fieldCount; i++) {
@@ -486,15 +842,21 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     if (i == fieldCount) {
         return -6;
     }
-    RID *id = (RID *) malloc(sizeof(RID));
-    memcpy(id, &rid, sizeof(RID));
+    void *page;
+    PageNum pageNum = rid.pageNum;
+    RC rc = fileHandle.pinPage(pageNum, page);
+    if (rc != 0) {
+        return rc;
+    }
+    if ((int) rid.slotNum >= this->getPageSlotTotal(page)) {
+        fileHandle.unpinPage(pageNum, false);
+        return -1;
+    }
     short recordOffset, recordSize;
-    this->locateRecord(fileHandle, page, recordOffset, recordSize, id);
-    if (id == nullptr) {
-        free(page);
-        return -5;
+    rc = this->locatePinnedRecord(fileHandle, page, pageNum, rid.slotNum, recordOffset, recordSize);
+    if (rc != 0) {
+        return rc;
     }
-    free(id);
     int nullFlagSize = this->getNullFlagSize(fieldCount);
     short pagePtr = recordOffset - recordSize;
     short offset, prevOffset;
@@ -509,14 +871,32 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
         memcpy(data, &nullBit, sizeof(bool));
         memcpy((char *) data + sizeof(bool), (char *) page + pagePtr + prevOffset, sz);
     }
-    free(page);
+    fileHandle.unpinPage(pageNum, false);
     return 0;
 }
 
 RC RecordBasedFileManager::scan(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
                                 const string &conditionAttribute, const CompOp compOp, const void *value,
                                 const vector<string> &attrNames, RBFM_ScanIterator &rbfm_ScanIterator) {
-    rbfm_ScanIterator.init(fileHandle, recordDescriptor, compOp, value, attrNames);
+    // A condition attribute that does not exist is only allowed without a comparison
+    vector<ScanCondition> conditions;
+    for (const Attribute &attr : recordDescriptor) {
+        if (attr.name == conditionAttribute) {
+            conditions.push_back({conditionAttribute, compOp, value});
+            break;
+        }
+    }
+    if (conditions.empty() && compOp != NO_OP) {
+        rbfm_ScanIterator.init(fileHandle, recordDescriptor, attrNames);
+        return -7; // AttributeNotFoundException
+    }
+    return this->scan(fileHandle, recordDescriptor, conditions, attrNames, rbfm_ScanIterator);
+}
+
+RC RecordBasedFileManager::scan(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                                const vector<ScanCondition> &conditions, const vector<string> &attrNames,
+                                RBFM_ScanIterator &rbfm_ScanIterator) {
+    rbfm_ScanIterator.init(fileHandle, recordDescriptor, attrNames);
 
     int fieldCount = recordDescriptor.size();
     int i, j;
@@ -533,18 +913,21 @@ RC RecordBasedFileManager::scan(FileHandle &fileHandle, const std::vector<Attrib
         }
     }
 
-    for (i = 0; i < fieldCount; i++) {
-        if (recordDescriptor[i].name == conditionAttribute) {
-            rbfm_ScanIterator.condAttrIdx = i;
-            break;
+    // Constants are parsed here once instead of for every record
+    for (const ScanCondition &condition : conditions) {
+        for (j = 0; j < fieldCount; j++) {
+            if (recordDescriptor[j].name == condition.attrName) {
+                break;
+            }
         }
-    }
-    if (i == fieldCount) {
-        if (compOp == NO_OP) {
-            rbfm_ScanIterator.condAttrIdx = -1;
-        } else {
+        if (j == fieldCount) {
             return -7; // AttributeNotFoundException
         }
+        RBFM_ScanIterator::Predicate predicate;
+        predicate.attrIdx = j;
+        predicate.compOp = condition.compOp;
+        predicate.value.readAttr(recordDescriptor[j].type, condition.value);
+        rbfm_ScanIterator.predicates.push_back(predicate);
     }
     return 0;
 }
@@ -614,7 +997,7 @@ void AttrValue::printSelf() {
     }
 }
 
-bool AttrValue::compAttr(AttrValue left, AttrValue right, CompOp op) {
+bool AttrValue::compAttr(const AttrValue &left, const AttrValue &right, CompOp op) {
     assert(left.type == right.type);
     switch (op) {
         case EQ_OP:
@@ -635,126 +1018,201 @@ bool AttrValue::compAttr(AttrValue left, AttrValue right, CompOp op) {
 }
 
 void RBFM_ScanIterator::init(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
-                             const CompOp compOp, const void *value, const vector<string> &attrNames) {
+                             const vector<string> &attrNames) {
+    // A reused iterator gives back the page it still has pinned
+    this->close();
     this->fileHandle = &fileHandle;
     this->recordDescriptor = recordDescriptor;
-    this->compOp = compOp;
-    this->value = value;
     this->attrNames = attrNames;
+    this->attrIdx.clear();
+    this->predicates.clear();
 
     this->pageNum = 0;
     this->slotNum = -1;
+    this->page = nullptr;
 }
 
 RC RBFM_ScanIterator::getNextRecord(RID &rid, void *data) {
     RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
-    void *page = malloc(PAGE_SIZE);
-    memset(page, 0, PAGE_SIZE);
-    this->fileHandle->readPage(this->pageNum, page);
-    short slotTotal = rbfm.getPageSlotTotal(page);
-    RID *id = (RID *) malloc(sizeof(RID));
+    void *recordPage;
+    short pagePtr;
+    PageNum recordPageNum;
+    bool forwarded;
+    RC rc = this->locateNextRecord(rid, recordPage, pagePtr, recordPageNum, forwarded);
+    if (rc != 0) {
+        return rc;
+    }
+    rbfm.projectRecord(recordPage, pagePtr, this->recordDescriptor.size(), this->attrIdx, data);
+    if (forwarded) {
+        this->fileHandle->unpinPage(recordPageNum, false);
+    }
+    return 0;
+}
+
+RC RBFM_ScanIterator::getNextRecords(int maxCount, const vector<RecordColumn *> &columns, int &count) {
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+    int fieldCount = this->recordDescriptor.size();
+    short nullFlagSize = rbfm.getNullFlagSize(fieldCount);
+    RID rid;
+    void *recordPage;
+    short pagePtr;
+    PageNum recordPageNum;
+    bool forwarded;
+    RC rc = 0;
+    count = 0;
+    while (count < maxCount &&
+           (rc = this->locateNextRecord(rid, recordPage, pagePtr, recordPageNum, forwarded)) == 0) {
+        // The fields go from the page into their columns as they are, a VarChar with its length
+        for (int i = 0; i < this->attrIdx.size(); i++) {
+            short offset, prevOffset;
+            rbfm.getAttributeOffset(recordPage, pagePtr, fieldCount, nullFlagSize, this->attrIdx[i], offset,
+                                    prevOffset);
+            RecordColumn &column = *columns[i];
+            if (offset - prevOffset <= 0) {
+                column.offsets.push_back(-1);
+                continue;
+            }
+            const char *value = (char *) recordPage + pagePtr + prevOffset;
+            column.offsets.push_back(column.values.size());
+            column.values.insert(column.values.end(), value, value + offset - prevOffset);
+        }
+        if (forwarded) {
+            this->fileHandle->unpinPage(recordPageNum, false);
+        }
+        count++;
+    }
+    // An error after some records is left for the next call, which runs into it again
+    return count == 0 ? rc : 0;
+}
+
+RC RBFM_ScanIterator::locateNextRecord(RID &rid, void *&recordPage, short &pagePtr, PageNum &recordPageNum,
+                                       bool &forwarded) {
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
     bool satisfied = false;
     while (true) {
-        this->slotNum++;
-        if (this->slotNum > slotTotal - 1) {
-            this->pageNum++;
-            if (this->pageNum > this->fileHandle->getNumberOfPages()-1) {
-                free(id);
-                free(page);
+        // The current page stays pinned across calls and is only released when the scan moves on,
+        // pages are consumed in place, which is zero-copy on a mapped file
+        if (this->page == nullptr) {
+            if (this->pageNum > (int) this->fileHandle->getNumberOfPages() - 1) {
                 return RBFM_EOF;
-            } else {
-                this->fileHandle->readPage(this->pageNum, page);
-                slotTotal = rbfm.getPageSlotTotal(page);
-                this->slotNum = 0;
             }
+            RC rc = this->fileHandle->pinPage(this->pageNum, this->page);
+            if (rc != 0) {
+                this->page = nullptr;
+                return rc;
+            }
+            this->slotNum = -1;
+        }
+        this->slotNum++;
+        if (this->slotNum > rbfm.getPageSlotTotal(this->page) - 1) {
+            this->fileHandle->unpinPage(this->pageNum, false);
+            this->page = nullptr;
+            this->pageNum++;
+            continue;
         }
         rid.pageNum = this->pageNum;
         rid.slotNum = this->slotNum;
 
-        memcpy(id, &rid, sizeof(RID));
-        short recordOffset, recordSize;
-        this->fileHandle->readPage(this->pageNum, page);
-        rbfm.locateRecord(*this->fileHandle, page, recordOffset, recordSize, id);
-        if (id == nullptr) {
-            id = (RID *) malloc(sizeof(RID));
+        recordPage = this->page;
+        recordPageNum = this->pageNum;
+        short recordOffset = rbfm.getRecordOffset(this->page, this->slotNum);
+        if (recordOffset == -1) {
             continue; // Deleted slot, skip.
         }
+        short recordSize = rbfm.getRecordSize(this->page, this->slotNum);
+        // Only a forwarded record, which lives on another page, needs a pin of its own
+        forwarded = recordSize == -1;
+        if (forwarded) {
+            // A failed pin leaves the scan on this slot, the scan's own pin is not the one to give back
+            RC rc = this->fileHandle->pinPage(recordPageNum, recordPage);
+            if (rc != 0) {
+                this->slotNum--;
+                return rc;
+            }
+            rc = rbfm.locatePinnedRecord(*this->fileHandle, recordPage, recordPageNum, this->slotNum,
+                                         recordOffset, recordSize);
+            if (rc == -5) {
+                continue; // Dangling forward, skip.
+            }
+            if (rc != 0) {
+                this->slotNum--;
+                return rc;
+            }
+        }
 
-        short pagePtr = recordOffset - recordSize;
+        pagePtr = recordOffset - recordSize;
         int fieldCount = this->recordDescriptor.size();
         int nullFlagSize = rbfm.getNullFlagSize(fieldCount);
 
-        if (this->condAttrIdx == -1) {
-            satisfied = true;
-        } else {
+        // Rejected records are never copied out of the page
+        satisfied = true;
+        for (const Predicate &predicate : this->predicates) {
             short offset, prevOffset;
-            rbfm.getAttributeOffset(page, pagePtr, fieldCount, nullFlagSize,
-                                    this->condAttrIdx, offset, prevOffset);
+            rbfm.getAttributeOffset(recordPage, pagePtr, fieldCount, nullFlagSize,
+                                    predicate.attrIdx, offset, prevOffset);
             short sz = offset - prevOffset;
-            if (sz > 0) {
-                void *checkValue = malloc(sz);
-                memcpy((char *) checkValue, (char *) page + pagePtr + prevOffset, sz);
-                satisfied = this->checkSatisfied(checkValue);
-                free(checkValue);
-            } else {
-                continue;
+            if (sz <= 0 || !this->checkSatisfied(predicate, (char *) recordPage + pagePtr + prevOffset)) {
+                satisfied = false;
+                break;
             }
         }
 
         if (satisfied) {
-            int reNullFlagsSize = rbfm.getNullFlagSize(this->attrNames.size());
-            unsigned char *reNullFlags = (unsigned char *) malloc(reNullFlagsSize);
-            memset(reNullFlags, 0, reNullFlagsSize);
-            short offset, prevOffset, sz;
-            short dataPtr = reNullFlagsSize;
-            for (int i = 0; i < this->attrNames.size(); i++) {
-                rbfm.getAttributeOffset(page, pagePtr, fieldCount, nullFlagSize,
-                                        this->attrIdx[i], offset, prevOffset);
-                sz = offset - prevOffset;
-
-                if (sz > 0) {
-                    memcpy((char *) data + dataPtr, (char *) page + pagePtr + prevOffset, sz);
-                    dataPtr += sz;
-                } else {
-                    int nullByte = i / 8;
-                    int nullBit = i % 8;
-                    reNullFlags[nullByte] |= (1 << (7 - nullBit));
-                }
-            }
-            memcpy((char *) data, reNullFlags, reNullFlagsSize);
-            free(reNullFlags);
-            free(id);
-            free(page);
             return 0;
         }
+        if (forwarded) {
+            this->fileHandle->unpinPage(recordPageNum, false);
+        }
     }
 }
 
-bool RBFM_ScanIterator::checkSatisfied(void *checkValue) {
-    Attribute attr = this->recordDescriptor[this->condAttrIdx];
-    AttrValue v;
-    v.readAttr(attr.type, checkValue);
-    AttrValue s;
-    s.readAttr(attr.type, this->value);
+bool RBFM_ScanIterator::checkSatisfied(const Predicate &predicate, void *checkValue) {
+    // The field is compared where it lies on the page, without building an AttrValue of it
+    const AttrValue &s = predicate.value;
+    int comp;
+    switch (this->recordDescriptor[predicate.attrIdx].type) {
+        case TypeInt: {
+            int itg;
+            memcpy(&itg, checkValue, sizeof(int));
+            comp = itg < s.itg ? -1 : (itg > s.itg ? 1 : 0);
+            break;
+        }
+        case TypeReal: {
+            float flt;
+            memcpy(&flt, checkValue, sizeof(float));
+            comp = flt < s.flt ? -1 : (flt > s.flt ? 1 : 0);
+            break;
+        }
+        default: {
+            int len;
+            memcpy(&len, checkValue, sizeof(int));
+            int valueLen = s.vchar.size();
+            comp = memcmp((char *) checkValue + sizeof(int), s.vchar.data(), len < valueLen ? len : valueLen);
+            if (comp == 0) {
+                comp = len < valueLen ? -1 : (len > valueLen ? 1 : 0);
+            }
+            break;
+        }
+    }
     bool satisfied = false;
-    switch (compOp) {
+    switch (predicate.compOp) {
         case EQ_OP:
-            satisfied = v == s;
+            satisfied = comp == 0;
             break;
         case LT_OP:
-            satisfied = v < s;
+            satisfied = comp < 0;
             break;
         case LE_OP:
-            satisfied = v <= s;
+            satisfied = comp <= 0;
             break;
         case GT_OP:
-            satisfied = v > s;
+            satisfied = comp > 0;
             break;
         case GE_OP:
-            satisfied = v >= s;
+            satisfied = comp >= 0;
             break;
         case NE_OP:
-            satisfied = v != s;
+            satisfied = comp != 0;
             break;
         case NO_OP:
             satisfied = true;
@@ -766,12 +1224,23 @@ bool RBFM_ScanIterator::checkSatisfied(void *checkValue) {
 RBFM_ScanIterator::RBFM_ScanIterator() {
     this->pageNum = 0;
     this->slotNum = -1;
+    this->page = nullptr;
+    this->fileHandle = nullptr;
+}
+
+RBFM_ScanIterator::~RBFM_ScanIterator() {
+    this->close();
 }
 
 RC RBFM_ScanIterator::close() {
+    if (this->page != nullptr) {
+        this->fileHandle->unpinPage(this->pageNum, false);
+        this->page = nullptr;
+    }
     this->pageNum = 0;
     this->slotNum = -1;
     this->attrIdx.clear();
+    this->predicates.clear();
     return 0;
 }
 
@@ -8,6 +8,7 @@
 #include <cmath>
 #include <cstring>
 #include <cassert>
+#include <algorithm>
 
 #include "pfm.h"
 
@@ -50,6 +51,17 @@ typedef enum {
 
 # define RBFM_EOF (-1)  // end of a scan operator
 
+// Free space map: page 0 and every FSM_INTERVAL-th page after it hold one byte per following page,
+// the free space of that page in FSM_BUCKET_SIZE units. Their slot total is -1 so they never look
+// like a data page. Files without a map page at 0 are still read and searched the old way.
+#define FSM_VERSION 1
+// Data pages created since the slot free list exist end with this marker where the slot total used to be,
+// followed (downwards) by the free space, the slot total, the free slot head and then the slot directory.
+// Pages without the marker keep the old two-field trailer and are searched linearly for free slots.
+#define PAGE_FORMAT_SLOT_LIST (-2)
+#define FSM_INTERVAL ((int) (PAGE_SIZE - 2 * sizeof(short)))
+#define FSM_BUCKET_SIZE 16
+
 class AttrValue {
 public:
     AttrType type;
@@ -73,7 +85,7 @@ public:
 
     void writeAttr(void *data);
 
-    static bool compAttr(AttrValue left, AttrValue right, CompOp op);
+    static bool compAttr(const AttrValue &left, const AttrValue &right, CompOp op);
 
     void printSelf();
 };
@@ -94,11 +106,25 @@ inline bool operator<=(const AttrValue &left, const AttrValue &right) { return !
 
 inline bool operator>=(const AttrValue &left, const AttrValue &right) { return !operator<(left, right); }
 
+// One attribute compared with a constant, a scan returns the records that satisfy all of its conditions.
+// A record whose attribute is null satisfies none.
+struct ScanCondition {
+    string attrName;
+    CompOp compOp;                                                      // NO_OP only rejects nulls
+    const void *value;                                                  // Read once when the scan starts
+};
+
+// Values of one attribute over many records, back to back, a VarChar with its length in front
+struct RecordColumn {
+    vector<char> values;
+    vector<int> offsets;                                                // Where each record's value starts, -1 if null
+};
+
 // RBFM_ScanIterator is an iterator to go through records
 // The way to use it is like the following:
 //  RBFM_ScanIterator rbfmScanIterator;
 //  rbfm.open(..., rbfmScanIterator);
-//  while (rbfmScanIterator(rid, data) != RBFM_EOF) {
+//  while (rbfmScanIterator(rid, data) == 0) {
 //    process the data;
 //  }
 //  rbfmScanIterator.close();
@@ -107,29 +133,43 @@ class RBFM_ScanIterator {
 public:
     RBFM_ScanIterator();
 
-    ~RBFM_ScanIterator() = default;
+    ~RBFM_ScanIterator();                                               // Releases the pinned page, as close() does
+
+    struct Predicate {
+        short attrIdx;                                                  // Position in recordDescriptor
+        CompOp compOp;
+        AttrValue value;
+    };
 
     void init(FileHandle &fileHandle, const std::vector<Attribute> &recordDescriptor,
-              const CompOp compOp, const void *value, const vector<string> &attrNames);
+              const vector<string> &attrNames);
 
     // Never keep the results in the memory. When getNextRecord() is called,
     // a satisfying record needs to be fetched from the file.
     // "data" follows the same format as RecordBasedFileManager::insertRecord().
+    // RBFM_EOF at the end, the error of a page that cannot be pinned otherwise.
     RC getNextRecord(RID &rid, void *data);
 
-    bool checkSatisfied(void *checkValue);
+    // Up to maxCount satisfying records at once, their attributes appended to columns in the order of
+    // attrNames straight from the page. RBFM_EOF when no record is left.
+    RC getNextRecords(int maxCount, const vector<RecordColumn *> &columns, int &count);
+
+    // Move to the next satisfying record and leave it on its page, which a forwarded record has pinned
+    // for the caller to release
+    RC locateNextRecord(RID &rid, void *&recordPage, short &pagePtr, PageNum &recordPageNum, bool &forwarded);
+
+    bool checkSatisfied(const Predicate &predicate, void *checkValue);
 
     RC close();
 
     int pageNum;
     short slotNum;
+    void *page;                                                         // Pinned frame of pageNum, or nullptr
     FileHandle *fileHandle;
     vector<Attribute> recordDescriptor;
-    CompOp compOp;
-    const void *value;
     vector<short> attrIdx;
     vector<string> attrNames;
-    short condAttrIdx;
+    vector<Predicate> predicates;                                       // Checked on the page before copying out
 };
 
 class RecordBasedFileManager {
@@ -140,7 +180,8 @@ public:
 
     RC destroyFile(const string &fileName);                        // Destroy a record-based file
 
-    RC openFile(const string &fileName, FileHandle &fileHandle);   // Open a record-based file
+    RC openFile(const string &fileName, FileHandle &fileHandle,
+                FileMode fileMode = READ_WRITE);                        // Open a record-based file
 
     RC closeFile(FileHandle &fileHandle);                               // Close a record-based file
 
@@ -161,6 +202,10 @@ public:
 
     short getNullFlagSize(int fieldCount);
 
+    static bool hasSlotList(const void *page);
+
+    static short getPageHeaderSize(const void *page);
+
     static short getPageSlotTotal(const void *page);
 
     static void setPageSlotTotal(const void *page, short slotTotal);
@@ -169,6 +214,12 @@ public:
 
     static void setPageFreeSpace(const void *page, short space);
 
+    static short getFreeSlotHead(const void *page);                     // -1 if no slot is free
+
+    static void setFreeSlotHead(const void *page, short slotNum);
+
+    static void initDataPage(const void *page);
+
     static short getRecordOffset(const void *page, short slotNum);
 
     static void setRecordOffset(const void *page, short offset, short slotNum);
@@ -180,25 +231,75 @@ public:
     void getAttributeOffset(const void *page, short pagePtr, int fieldCount, short nullFlagSize,
                             short attrIdx, short &offset, short &prevOffset);
 
+    // Copy the fields attrIdx of the record at pagePtr into data, in the record format of those fields alone
+    void projectRecord(const void *page, short pagePtr, int fieldCount, const vector<short> &attrIdx, void *data);
+
     short getInsertPtr(const void *page);
 
     short countRemainSpace(const void *page, short freeSpace, short recordSize, bool newFlag);
 
     short findFreeSlot(const void *page);
 
+    void takeSlot(const void *page, short slotNum);                     // Claim the slot findFreeSlot returned
+
+    void releaseSlot(const void *page, short slotNum);
+
+    static bool isFreeSpaceMapPage(const void *page);
+
+    static unsigned char getFreeSpaceBucket(const void *page);
+
+    // Number of the page the next append creates, adding a map page first when one is due
+    RC getNewPageNum(FileHandle &fileHandle, unsigned &pageNum);
+
+    // Load into page an existing page able to take the record, -1 if there is none
+    RC findPageWithSpace(FileHandle &fileHandle, short recordSize, int excludedPage, void *page, unsigned &pageNum);
+
+    RC findPageWithSpaceLegacy(FileHandle &fileHandle, short recordSize, int excludedPage, void *page,
+                               unsigned &pageNum);
+
+    RC updateFreeSpaceMap(FileHandle &fileHandle, unsigned pageNum, const void *page);
+
+    // Append or overwrite a data page and record its free space in the map
+    RC writeDataPage(FileHandle &fileHandle, unsigned pageNum, const void *page, bool append);
+
     short parseRecord(const vector<Attribute> &recordDescriptor, const void *data, const void *offsetTable);
 
     RC copyRecord(const void *page, short insertPtr, int fieldCount, const void *data, const void *offsetTable,
                   short recordSize);
 
+    // Put a parsed record on an in-memory page that has room for it, returns the slot used
+    short placeRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data,
+                      const char *offsetTable, short recordSize, short remainSpace);
+
     // Insert a record into a file
     RC insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
 
+    // Insert many records, each page is filled in memory and written once. rids[i] is the rid of data[i].
+    RC insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                     const vector<const void *> &data, vector<RID> &rids);
+
     // Read a record identified by the given rid.
     RC readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
 
+    // Read many records, visiting the rids in page order so that each page is pinned once however they are
+    // ordered. data[i] receives the record of rids[i] and must have room for it. Rids whose record is gone
+    // are passed over and have found[i] false.
+    RC readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids,
+                   const vector<void *> &data, vector<bool> &found);
+
+    // Read many records as above, each with only the attributes attrNames in that order
+    RC readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids,
+                   const vector<string> &attrNames, const vector<void *> &data, vector<bool> &found);
+
+    // Shared by both, attrIdx is nullptr to copy whole records
+    RC readRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<RID> &rids,
+                   const vector<short> *attrIdx, const vector<void *> &data, vector<bool> &found);
+
     void locateRecord(FileHandle &fileHandle, void *page, short &recordOffset, short &recordSize, RID *&id);
 
+    RC locatePinnedRecord(FileHandle &fileHandle, void *&page, PageNum &pageNum, short slotNum,
+                          short &recordOffset, short &recordSize);
+
     void shiftRecord(const void *page, short recordOffset, short distance);
 
     // Print the record that is passed to this utility method.
@@ -233,6 +334,13 @@ public:
             const vector<string> &attrNames, // a list of projected attributes
             RBFM_ScanIterator &rbfm_ScanIterator);
 
+    // Scan for the records that satisfy every condition, none returns all records
+    RC scan(FileHandle &fileHandle,
+            const vector<Attribute> &recordDescriptor,
+            const vector<ScanCondition> &conditions,
+            const vector<string> &attrNames,
+            RBFM_ScanIterator &rbfm_ScanIterator);
+
 protected:
     RecordBasedFileManager();                                                   // Prevent construction
     ~RecordBasedFileManager();                                                  // Prevent unwanted destruction
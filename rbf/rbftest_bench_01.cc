@@ -0,0 +1,233 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <chrono>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Read and write syscalls issued by this process so far, taken from /proc/self/io (Linux only)
+bool getSyscallCount(unsigned long long &reads, unsigned long long &writes) {
+    ifstream io("/proc/self/io");
+    if (!io.is_open()) {
+        return false;
+    }
+    string key;
+    unsigned long long value;
+    reads = 0;
+    writes = 0;
+    while (io >> key >> value) {
+        if (key == "syscr:") {
+            reads = value;
+        } else if (key == "syscw:") {
+            writes = value;
+        }
+    }
+    return true;
+}
+
+int scanWithInterval(RecordBasedFileManager &rbfm, const string &fileName, const vector<Attribute> &recordDescriptor,
+                     unsigned interval, int numRecords, unsigned long long &writes) {
+    FileHandle fileHandle;
+    RC rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    fileHandle.setCounterSyncInterval(interval);
+
+    unsigned readBefore, writeBefore, appendBefore;
+    fileHandle.collectCounterValues(readBefore, writeBefore, appendBefore);
+
+    vector<string> attrNames;
+    for (const Attribute &attr : recordDescriptor) {
+        attrNames.push_back(attr.name);
+    }
+
+    unsigned long long readsBefore = 0, writesBefore = 0, readsAfter = 0, writesAfter = 0;
+    bool supported = getSyscallCount(readsBefore, writesBefore);
+    auto start = chrono::steady_clock::now();
+
+    RBFM_ScanIterator rbfmScanIterator;
+    rc = rbfm.scan(fileHandle, recordDescriptor, "", NO_OP, nullptr, attrNames, rbfmScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+    RID rid;
+    void *returnedData = malloc(PAGE_SIZE);
+    int count = 0;
+    while ((rc = rbfmScanIterator.getNextRecord(rid, returnedData)) == 0) {
+        count++;
+    }
+    assert(rc == RBFM_EOF && "Scanning the file should end at RBFM_EOF.");
+    rbfmScanIterator.close();
+    free(returnedData);
+
+    auto end = chrono::steady_clock::now();
+    getSyscallCount(readsAfter, writesAfter);
+    writes = writesAfter - writesBefore;
+
+    unsigned readAfter, writeAfter, appendAfter;
+    fileHandle.collectCounterValues(readAfter, writeAfter, appendAfter);
+    unsigned numberOfPages = fileHandle.getNumberOfPages();
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    cout << "sync interval " << interval << ": " << count << " records, "
+         << readAfter - readBefore << " page reads, "
+         << chrono::duration_cast<chrono::milliseconds>(end - start).count() << " ms";
+    if (supported) {
+        cout << ", " << readsAfter - readsBefore << " read syscalls, " << writes << " write syscalls";
+    }
+    cout << endl;
+
+    if (count != numRecords) {
+        cout << "[FAIL] Scan returned " << count << " records instead of " << numRecords << "." << endl;
+        return -1;
+    }
+    if (readAfter - readBefore > numberOfPages) {
+        cout << "[FAIL] A full scan should read every page once." << endl;
+        return -1;
+    }
+
+    // Whatever the interval, the counters must be on disk once the file is closed
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    unsigned readStored, writeStored, appendStored;
+    fileHandle.collectCounterValues(readStored, writeStored, appendStored);
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    if (readStored != readAfter || writeStored != writeAfter || appendStored != appendAfter) {
+        cout << "[FAIL] The counters have not been persisted on close." << endl;
+        return -1;
+    }
+    return supported ? 0 : 1;
+}
+
+int scanUnderPressure(RecordBasedFileManager &rbfm, const string &fileName,
+                      const vector<Attribute> &recordDescriptor, int numRecords) {
+    BufferManager &bm = BufferManager::instance();
+    unsigned frameCount = 4;
+    RC rc = bm.resize(frameCount);
+    assert(rc == success && "Resizing an idle buffer pool should not fail.");
+
+    // Every frame is pinned by another handle, the scan cannot bring in its first page
+    FileHandle pinHandle;
+    rc = rbfm.openFile(fileName, pinHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    void *frame;
+    for (unsigned i = 0; i < frameCount; i++) {
+        rc = pinHandle.pinPage(10 + i, frame);
+        assert(rc == success && "Pinning a page should not fail.");
+    }
+
+    FileHandle fileHandle;
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    vector<string> attrNames;
+    for (const Attribute &attr : recordDescriptor) {
+        attrNames.push_back(attr.name);
+    }
+    RBFM_ScanIterator rbfmScanIterator;
+    rc = rbfm.scan(fileHandle, recordDescriptor, "", NO_OP, nullptr, attrNames, rbfmScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+    RID rid;
+    void *returnedData = malloc(PAGE_SIZE);
+    rc = rbfmScanIterator.getNextRecord(rid, returnedData);
+    int result = 0;
+    if (rc == success || rc == RBFM_EOF) {
+        cout << "[FAIL] A scan that cannot pin its page should fail instead of returning " << rc << "." << endl;
+        result = -1;
+    }
+
+    // Once a frame is free again the same scan goes on from the start
+    rc = pinHandle.unpinPage(10, false);
+    assert(rc == success && "Unpinning a page should not fail.");
+    int count = 0;
+    while ((rc = rbfmScanIterator.getNextRecord(rid, returnedData)) == 0) {
+        count++;
+    }
+    if (rc != RBFM_EOF || count != numRecords) {
+        cout << "[FAIL] The scan returned " << count << " records and " << rc << " after the pool freed up."
+             << endl;
+        result = -1;
+    }
+    rbfmScanIterator.close();
+    free(returnedData);
+
+    for (unsigned i = 1; i < frameCount; i++) {
+        pinHandle.unpinPage(10 + i, false);
+    }
+    rbfm.closeFile(fileHandle);
+    rbfm.closeFile(pinHandle);
+    rc = bm.resize(BUFFER_POOL_SIZE);
+    assert(rc == success && "Resizing an idle buffer pool should not fail.");
+    return result;
+}
+
+int RBFTest_Bench_01(RecordBasedFileManager &rbfm) {
+    // Functions Tested:
+    // 1. Full scan of 100k records with the counters synced on every page operation
+    // 2. The same scan with the counters kept in memory until close
+    // 3. Each scan reads every page once
+    // 4. A scan that cannot pin its page reports the error instead of ending
+    cout << endl << "***** In RBF Test Case Bench 01 *****" << endl;
+
+    RC rc;
+    string fileName = "test_bench_01";
+    int numRecords = 100000;
+
+    rc = rbfm.createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(100);
+    int recordSize = 0;
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i % 100, 177.8 + i, i,
+                      record, &recordSize);
+        rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    free(record);
+    free(nullsIndicator);
+
+    unsigned long long eagerWrites, deferredWrites;
+    RC eager = scanWithInterval(rbfm, fileName, recordDescriptor, 1, numRecords, eagerWrites);
+    RC deferred = scanWithInterval(rbfm, fileName, recordDescriptor, 0, numRecords, deferredWrites);
+    RC pressured = scanUnderPressure(rbfm, fileName, recordDescriptor, numRecords);
+
+    rc = rbfm.destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    if (eager < 0 || deferred < 0 || pressured != 0) {
+        return -1;
+    }
+    if (eager == 0 && deferred == 0 && deferredWrites >= eagerWrites) {
+        cout << "[FAIL] Deferring the counters should save write syscalls." << endl;
+        return -1;
+    }
+
+    cout << "RBF Test Case Bench 01 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+    // To measure the cost of keeping the hidden page up to date
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+
+    remove("test_bench_01");
+
+    return RBFTest_Bench_01(rbfm);
+}
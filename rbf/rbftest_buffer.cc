@@ -0,0 +1,161 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <cstdio>
+
+#include "pfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int checkPolicy(PagedFileManager &pfm, BufferManager &bm, const string &fileName, ReplacementPolicyType policy) {
+    RC rc;
+    unsigned numPages = 32;
+    unsigned hits, misses, evicts, hitsAfter, missesAfter, evictsAfter;
+
+    rc = bm.setReplacementPolicy(policy);
+    assert(rc == success && "Switching the replacement policy should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    void *buffer = malloc(PAGE_SIZE);
+
+    // Touch every page twice, the pool only holds a quarter of them
+    bm.collectCounterValues(hits, misses, evicts);
+    for (unsigned round = 0; round < 2; round++) {
+        for (unsigned i = 0; i < numPages; i++) {
+            rc = fileHandle.readPage(i, buffer);
+            assert(rc == success && "Reading a page should not fail.");
+            for (unsigned j = 0; j < PAGE_SIZE; j++) {
+                *((char *) data + j) = (i + j) % 94 + 32;
+            }
+            if (memcmp(data, buffer, PAGE_SIZE) != 0) {
+                cout << "[FAIL] Page " << i << " came back corrupted." << endl;
+                free(data);
+                free(buffer);
+                return -1;
+            }
+        }
+    }
+    bm.collectCounterValues(hitsAfter, missesAfter, evictsAfter);
+    assert(evictsAfter > evicts && "Scanning more pages than frames should evict.");
+
+    // A hot page read over and over must stay resident
+    fileHandle.readPage(0, buffer);
+    bm.collectCounterValues(hits, misses, evicts);
+    for (unsigned i = 0; i < 100; i++) {
+        fileHandle.readPage(0, buffer);
+    }
+    bm.collectCounterValues(hitsAfter, missesAfter, evictsAfter);
+    cout << "policy " << policy << " hits: " << hitsAfter - hits << " misses: " << missesAfter - misses << endl;
+    assert(hitsAfter - hits == 100 && missesAfter == misses && "A hot page should always hit.");
+
+    rc = pfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    free(data);
+    free(buffer);
+    return 0;
+}
+
+int RBFTest_Buffer(PagedFileManager &pfm, BufferManager &bm) {
+    // Functions Tested:
+    // 1. Pages larger than the pool survive eviction under LRU, CLOCK and 2Q
+    // 2. Pinned pages are written back on close
+    // 3. A file cannot be destroyed while one of its pages is pinned
+    cout << endl << "***** In RBF Test Case Buffer *****" << endl;
+
+    RC rc;
+    string fileName = "test_buffer";
+    unsigned numPages = 32;
+
+    rc = bm.resize(8);
+    assert(rc == success && "Resizing an idle buffer pool should not fail.");
+
+    rc = pfm.createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    rc = pfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    void *data = malloc(PAGE_SIZE);
+    for (unsigned i = 0; i < numPages; i++) {
+        for (unsigned j = 0; j < PAGE_SIZE; j++) {
+            *((char *) data + j) = (i + j) % 94 + 32;
+        }
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    rc = pfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    if (checkPolicy(pfm, bm, fileName, LRU) != 0 || checkPolicy(pfm, bm, fileName, CLOCK) != 0 ||
+        checkPolicy(pfm, bm, fileName, TWO_Q) != 0) {
+        free(data);
+        return -1;
+    }
+
+    // Modify a page in place through pin/unpin
+    rc = pfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    void *frame;
+    rc = fileHandle.pinPage(3, frame);
+    assert(rc == success && "Pinning a page should not fail.");
+    memset(frame, 'x', PAGE_SIZE);
+    rc = fileHandle.unpinPage(3, true);
+    assert(rc == success && "Unpinning a page should not fail.");
+    rc = fileHandle.unpinPage(3, false);
+    assert(rc != success && "Unpinning a page twice should fail.");
+    rc = pfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Read it back, bypassing the pool via a plain stream
+    ifstream file(fileName, ios::in | ios::binary);
+    file.seekg(4 * PAGE_SIZE);
+    file.read((char *) data, PAGE_SIZE);
+    file.close();
+    for (unsigned j = 0; j < PAGE_SIZE; j++) {
+        if (*((char *) data + j) != 'x') {
+            cout << "[FAIL] The dirty page has not been written back." << endl;
+            free(data);
+            return -1;
+        }
+    }
+
+    // A file with a pinned page stays, and so does the frame its reader holds
+    rc = pfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = fileHandle.pinPage(5, frame);
+    assert(rc == success && "Pinning a page should not fail.");
+    rc = pfm.destroyFile(fileName);
+    if (rc != -15) {
+        cout << "[FAIL] Destroying a file with a pinned page returned " << rc << " instead of -15." << endl;
+        free(data);
+        return -1;
+    }
+    rc = fileHandle.unpinPage(5, false);
+    assert(rc == success && "Unpinning a page of a file that could not be destroyed should not fail.");
+    rc = pfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = pfm.destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(data);
+    cout << "RBF Test Case Buffer Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+    // To test the functionality of the buffer pool
+    PagedFileManager &pfm = PagedFileManager::instance();
+    BufferManager &bm = BufferManager::instance();
+
+    remove("test_buffer");
+
+    return RBFTest_Buffer(pfm, bm);
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_Fsm(RecordBasedFileManager &rbfm) {
+    // Functions Tested:
+    // 1. Inserts into a full file append without reading every page
+    // 2. Space freed by deletes is found again through the free space map, after reopening the file
+    cout << endl << "***** In RBF Test Case Fsm *****" << endl;
+
+    RC rc;
+    string fileName = "test_fsm";
+    int numRecords = 5000;
+
+    rc = rbfm.createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+    vector<RID> rids;
+    RID rid;
+    unsigned readBefore, writeBefore, appendBefore, readAfter, writeAfter, appendAfter;
+
+    fileHandle.collectCounterValues(readBefore, writeBefore, appendBefore);
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i, 177.8 + i, i * 10,
+                      record, &recordSize);
+        rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+    fileHandle.collectCounterValues(readAfter, writeAfter, appendAfter);
+    unsigned numberOfPages = fileHandle.getNumberOfPages();
+    cout << numRecords << " inserts on " << numberOfPages << " pages: " << readAfter - readBefore << " page reads"
+         << endl;
+    if (readAfter - readBefore > 4 * (unsigned) numRecords) {
+        cout << "[FAIL] Inserts should not search the whole file." << endl;
+        return -1;
+    }
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Free a page in the middle of the file
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    unsigned freedPage = rids[numRecords / 2].pageNum;
+    int freed = 0;
+    for (int i = 0; i < numRecords; i++) {
+        if (rids[i].pageNum == freedPage) {
+            rc = rbfm.deleteRecord(fileHandle, recordDescriptor, rids[i]);
+            assert(rc == success && "Deleting a record should not fail.");
+            freed++;
+        }
+    }
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    fileHandle.collectCounterValues(readBefore, writeBefore, appendBefore);
+    int reused = 0;
+    for (int i = 0; i < freed; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i, 177.8 + i, i * 10,
+                      record, &recordSize);
+        rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        reused += rid.pageNum == freedPage;
+        rc = rbfm.readRecord(fileHandle, recordDescriptor, rid, returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        if (memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] Record read back differs from the one inserted." << endl;
+            return -1;
+        }
+    }
+    fileHandle.collectCounterValues(readAfter, writeAfter, appendAfter);
+    cout << freed << " inserts into freed space: " << reused << " on page " << freedPage << ", "
+         << readAfter - readBefore << " page reads, " << appendAfter - appendBefore << " appends" << endl;
+    assert(reused > 0 && "The freed page should have been found.");
+    assert(appendAfter == appendBefore && "Freed space should be reused before appending.");
+    assert(fileHandle.getNumberOfPages() == numberOfPages && "The file should not grow.");
+
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm.destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(record);
+    free(returnedData);
+    free(nullsIndicator);
+    cout << "RBF Test Case Fsm Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+    // To test the free space map of record-based files
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+
+    remove("test_fsm");
+
+    return RBFTest_Fsm(rbfm);
+}
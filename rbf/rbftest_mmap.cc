@@ -0,0 +1,115 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_Mmap(RecordBasedFileManager &rbfm) {
+    // Functions Tested:
+    // 1. Scan a read-only mapped file and compare with the records inserted
+    // 2. Pinned pages point into the mapping and match readPage
+    // 3. Writes on a mapped file are refused
+    cout << endl << "***** In RBF Test Case Mmap *****" << endl;
+
+    RC rc;
+    string fileName = "test_mmap";
+    int numRecords = 2000;
+
+    rc = rbfm.createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+    RID rid;
+    for (int i = 0; i < numRecords; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i, 177.8 + i, i * 10,
+                      record, &recordSize);
+        rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+
+    // Map the file while the writer still has it open, its dirty pages must show up
+    FileHandle mappedHandle;
+    rc = rbfm.openFile(fileName, mappedHandle, READ_ONLY_MMAP);
+    assert(rc == success && "Mapping the file should not fail.");
+    assert(mappedHandle.isReadOnly() && "The handle should be read-only.");
+    assert(mappedHandle.getNumberOfPages() == fileHandle.getNumberOfPages() && "Both handles should agree.");
+
+    vector<string> attrNames;
+    for (const Attribute &attr : recordDescriptor) {
+        attrNames.push_back(attr.name);
+    }
+    RBFM_ScanIterator rbfmScanIterator;
+    rc = rbfm.scan(mappedHandle, recordDescriptor, "", NO_OP, nullptr, attrNames, rbfmScanIterator);
+    assert(rc == success && "Scanning the file should not fail.");
+    int count = 0;
+    while (rbfmScanIterator.getNextRecord(rid, returnedData) != RBFM_EOF) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", count, 177.8 + count, count * 10,
+                      record, &recordSize);
+        if (memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] Record " << count << " differs in the mapped scan." << endl;
+            return -1;
+        }
+        count++;
+    }
+    rbfmScanIterator.close();
+    if (count != numRecords) {
+        cout << "[FAIL] Mapped scan returned " << count << " records instead of " << numRecords << "." << endl;
+        return -1;
+    }
+
+    void *page = malloc(PAGE_SIZE);
+    void *mapped;
+    rc = mappedHandle.readPage(0, page);
+    assert(rc == success && "Reading a mapped page should not fail.");
+    rc = mappedHandle.pinPage(0, mapped);
+    assert(rc == success && "Pinning a mapped page should not fail.");
+    assert(memcmp(page, mapped, PAGE_SIZE) == 0 && "Pinned and copied page should be the same.");
+    rc = mappedHandle.unpinPage(0, true);
+    assert(rc != success && "Dirtying a mapped page should fail.");
+    rc = mappedHandle.writePage(0, page);
+    assert(rc != success && "Writing a mapped page should fail.");
+    rc = mappedHandle.appendPage(page);
+    assert(rc != success && "Appending to a mapped file should fail.");
+    rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "The writer should not be affected by the mapping.");
+
+    rc = rbfm.closeFile(mappedHandle);
+    assert(rc == success && "Closing the mapped file should not fail.");
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm.destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(page);
+    free(record);
+    free(returnedData);
+    free(nullsIndicator);
+    cout << "RBF Test Case Mmap Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+    // To test the read-only memory-mapped file mode
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+
+    remove("test_mmap");
+
+    return RBFTest_Mmap(rbfm);
+}
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int fillAndReuse(RecordBasedFileManager &rbfm, FileHandle &fileHandle, const vector<Attribute> &recordDescriptor,
+                 unsigned char *nullsIndicator, const string &label) {
+    void *record = malloc(100);
+    void *returnedData = malloc(100);
+    int recordSize = 0;
+    RID rid;
+    vector<RID> rids;
+    for (int i = 0; i < 20; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i, 177.8 + i, i * 10,
+                      record, &recordSize);
+        RC rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        rids.push_back(rid);
+    }
+
+    // Free slots 3, 11 and 17; they have to be handed out again before the directory grows
+    unsigned pageNum = rids[0].pageNum;
+    unsigned freedSlots[] = {rids[3].slotNum, rids[11].slotNum, rids[17].slotNum};
+    for (unsigned slot : freedSlots) {
+        rid.pageNum = pageNum;
+        rid.slotNum = slot;
+        RC rc = rbfm.deleteRecord(fileHandle, recordDescriptor, rid);
+        assert(rc == success && "Deleting a record should not fail.");
+    }
+    for (int i = 0; i < 4; i++) {
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 7, "Reused!", 100 + i, 1.5, i,
+                      record, &recordSize);
+        RC rc = rbfm.insertRecord(fileHandle, recordDescriptor, record, rid);
+        assert(rc == success && "Inserting a record should not fail.");
+        bool reused = false;
+        for (unsigned slot : freedSlots) {
+            reused = reused || (rid.pageNum == pageNum && rid.slotNum == slot);
+        }
+        if (i < 3 && !reused) {
+            cout << "[FAIL] " << label << ": insert " << i << " got slot " << rid.slotNum << " instead of a freed one."
+                 << endl;
+            return -1;
+        }
+        if (i == 3 && (reused || rid.slotNum != 20)) {
+            cout << "[FAIL] " << label << ": the directory should grow once the free slots are used." << endl;
+            return -1;
+        }
+        rc = rbfm.readRecord(fileHandle, recordDescriptor, rid, returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        assert(memcmp(record, returnedData, recordSize) == 0 && "Record read back should match.");
+    }
+
+    // Records that were not deleted are untouched
+    for (int i = 0; i < 20; i++) {
+        if (i == 3 || i == 11 || i == 17) {
+            continue;
+        }
+        prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", i, 177.8 + i, i * 10,
+                      record, &recordSize);
+        RC rc = rbfm.readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        if (memcmp(record, returnedData, recordSize) != 0) {
+            cout << "[FAIL] " << label << ": record " << i << " has been damaged." << endl;
+            return -1;
+        }
+    }
+    cout << label << ": freed slots reused" << endl;
+    free(record);
+    free(returnedData);
+    return 0;
+}
+
+int RBFTest_Slots(RecordBasedFileManager &rbfm, PagedFileManager &pfm) {
+    // Functions Tested:
+    // 1. Deleted slots are reused through the free slot list
+    // 2. Pages in the format without the list still reuse their slots
+    cout << endl << "***** In RBF Test Case Slots *****" << endl;
+
+    RC rc;
+    string fileName = "test_slots";
+    string legacyFileName = "test_slots_legacy";
+
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    rc = rbfm.createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm.openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fillAndReuse(rbfm, fileHandle, recordDescriptor, nullsIndicator, "current format") != 0) {
+        return -1;
+    }
+    rc = rbfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm.destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // An empty page with the two-field trailer and no free space map in front of it
+    rc = pfm.createFile(legacyFileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = pfm.openFile(legacyFileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    void *page = malloc(PAGE_SIZE);
+    memset(page, 0, PAGE_SIZE);
+    short freeSpace = PAGE_SIZE - 2 * sizeof(short);
+    short slotTotal = 0;
+    memcpy((char *) page + PAGE_SIZE - 2 * sizeof(short), &freeSpace, sizeof(short));
+    memcpy((char *) page + PAGE_SIZE - sizeof(short), &slotTotal, sizeof(short));
+    rc = fileHandle.appendPage(page);
+    assert(rc == success && "Appending a page should not fail.");
+    if (fillAndReuse(rbfm, fileHandle, recordDescriptor, nullsIndicator, "old format") != 0) {
+        return -1;
+    }
+    fileHandle.readPage(0, page);
+    assert(!RecordBasedFileManager::hasSlotList(page) && "An old page should keep its format.");
+    rc = pfm.closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm.destroyFile(legacyFileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(page);
+    free(nullsIndicator);
+    cout << "RBF Test Case Slots Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+    // To test slot reuse in record-based pages
+    RecordBasedFileManager &rbfm = RecordBasedFileManager::instance();
+    PagedFileManager &pfm = PagedFileManager::instance();
+
+    remove("test_slots");
+    remove("test_slots_legacy");
+
+    return RBFTest_Slots(rbfm, pfm);
+}
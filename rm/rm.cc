@@ -12,9 +12,17 @@ RelationManager::RelationManager() {
     IndexManager &ixm = IndexManager::instance();
     _rbf_manager = &rbfm;
     _ix_manager = &ixm;
+    // Cached handles are closed on destruction, so the buffer pool has to outlive this instance
+    BufferManager::instance();
+    handleHitCounter = 0;
+    handleMissCounter = 0;
+    handleEvictCounter = 0;
 }
 
-RelationManager::~RelationManager() { delete _relation_manager; }
+RelationManager::~RelationManager() {
+    this->closeCachedFiles();
+    delete _relation_manager;
+}
 
 RelationManager::RelationManager(const RelationManager &) = default;
 
@@ -23,6 +31,8 @@ RelationManager &RelationManager::operator=(const RelationManager &) = default;
 RC RelationManager::createCatalog() {
     const string tables = TABLES;
     const string columns = COLUMNS;
+    this->tableInfos.clear();
+    this->closeCachedFiles();
 
     // If creating tables file succeeds, open the file and write records to it
     RC rc = this->_rbf_manager->createFile(tables);
@@ -239,6 +249,8 @@ void RelationManager::prepareColumnsAttributeNames(vector<string> &attributeName
 }
 
 RC RelationManager::deleteCatalog() {
+    this->tableInfos.clear();
+    this->closeCachedFiles();
     RC rc = _rbf_manager->destroyFile(TABLES);
     if (rc != 0) {
         return rc;
@@ -255,6 +267,7 @@ RC RelationManager::deleteCatalog() {
 }
 
 RC RelationManager::createTable(const std::string &tableName, const std::vector<Attribute> &attrs) {
+    this->invalidateTableInfo(tableName);
     RC rc = this->_rbf_manager->createFile(tableName);
     if (rc != 0) {
         return rc;
@@ -265,7 +278,8 @@ RC RelationManager::createTable(const std::string &tableName, const std::vector<
     vector<Attribute> columnsDescriptor;
     prepareColumnsDescriptor(columnsDescriptor);
 
-    int newTableId = this->getTableTotal() + 1;
+    // Counting the tables would hand out the id of a live table once an earlier one is deleted
+    int newTableId = this->getMaxTableId() + 1;
     this->insertTablesRecord(tablesDescriptor, newTableId, tableName, tableName);
     this->insertColumnsRecord(columnsDescriptor, newTableId, attrs);
     return 0;
@@ -275,6 +289,26 @@ RC RelationManager::deleteTable(const std::string &tableName) {
     if (this->isSystemTable(tableName)) {
         return -8;
     }
+    // The indexes go with the table, their catalog rows would otherwise outlive it
+    TableInfo *tableInfo;
+    if (this->getTableInfo(tableName, tableInfo) == 0) {
+        vector<string> indexes = this->getIndexFileNames(tableInfo);
+        // A file an open scan still reads cannot be destroyed, refuse before the catalog changes
+        BufferManager &bm = BufferManager::instance();
+        bool busy = bm.pinned(tableName);
+        for (const string &indexFileName : indexes) {
+            busy = busy || bm.pinned(indexFileName);
+        }
+        if (busy) {
+            return -15; // BufferPoolBusyException
+        }
+        for (const string &indexFileName : indexes) {
+            this->deleteIndexRecord(tableName, indexFileName);
+            this->closeCachedFile(indexFileName);
+            _ix_manager->destroyFile(indexFileName);
+        }
+    }
+    this->invalidateTableInfo(tableName);
 
     RID rid;
     char *data = (char *) malloc(PAGE_SIZE);
@@ -289,7 +323,7 @@ RC RelationManager::deleteTable(const std::string &tableName) {
     memcpy(value, &delTableId, sizeof(int));
     RM_ScanIterator tablesIterator;
     this->scan(TABLES, condAttr, compOp, value, attrNames, tablesIterator);
-    while (tablesIterator.getNextTuple(rid, data) != RBFM_EOF) {
+    while (tablesIterator.getNextTuple(rid, data) == 0) {
         FileHandle tablesFileHandle;
         RC rc = this->_rbf_manager->openFile(TABLES, tablesFileHandle);
         if (rc != 0) {
@@ -297,6 +331,7 @@ RC RelationManager::deleteTable(const std::string &tableName) {
         }
         this->_rbf_manager->deleteRecord(tablesFileHandle, tablesDescriptor, rid);
         this->_rbf_manager->closeFile(tablesFileHandle);
+        this->closeCachedFile(tableName);
         this->_rbf_manager->destroyFile(tableName);
     }
     tablesIterator.close();
@@ -307,7 +342,7 @@ RC RelationManager::deleteTable(const std::string &tableName) {
     RM_ScanIterator columnsIterator;
     this->scan(COLUMNS, condAttr, compOp, value, attrNames, columnsIterator);
     vector<RID> targets;
-    while (columnsIterator.getNextTuple(rid, data) != RBFM_EOF) {
+    while (columnsIterator.getNextTuple(rid, data) == 0) {
         targets.emplace_back(rid);
     }
     free(data);
@@ -327,14 +362,77 @@ RC RelationManager::deleteTable(const std::string &tableName) {
 }
 
 RC RelationManager::getAttributes(const string &tableName, std::vector<Attribute> &attrs) {
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    attrs.insert(attrs.end(), tableInfo->attrs.begin(), tableInfo->attrs.end());
+    return 0;
+}
+
+RC RelationManager::getTableInfo(const string &tableName, TableInfo *&tableInfo) {
+    auto it = this->tableInfos.find(tableName);
+    if (it != this->tableInfos.end()) {
+        tableInfo = &it->second;
+        return 0;
+    }
+
+    vector<string> attrNames;
+    attrNames.emplace_back("table-id");
+    attrNames.emplace_back("file-name");
+    int length = tableName.size();
+    char *value = (char *) malloc(sizeof(int) + length);
+    memcpy(value, &length, sizeof(int));
+    memcpy(value + sizeof(int), tableName.c_str(), length);
+    RM_ScanIterator rmScanIterator;
+    this->scan(TABLES, "table-name", EQ_OP, value, attrNames, rmScanIterator);
+    char *data = (char *) malloc(PAGE_SIZE);
     RID rid;
-    int tableId = getTableId(tableName, rid);
+    TableInfo info;
+    info.tableId = -1;
+    if (rmScanIterator.getNextTuple(rid, data) == 0) {
+        int dataPtr = sizeof(char);
+        memcpy(&info.tableId, data + dataPtr, sizeof(int));
+        dataPtr += sizeof(int);
+        memcpy(&length, data + dataPtr, sizeof(int));
+        dataPtr += sizeof(int);
+        info.fileName = string(data + dataPtr, length);
+    }
+    rmScanIterator.close();
+    free(data);
+    free(value);
+    if (info.tableId == -1) {
+        return -9; // TableNotFoundException
+    }
+    this->loadAttributes(info.tableId, info.attrs);
+    info.indexesLoaded = false;
+    tableInfo = &(this->tableInfos[tableName] = info);
+    return 0;
+}
 
+vector<string> &RelationManager::getIndexFileNames(TableInfo *tableInfo) {
+    // Loaded on first use, reading the Index table needs the cached schema of Index itself
+    if (!tableInfo->indexesLoaded) {
+        tableInfo->indexes.clear();
+        this->getIndexAttributeNames(tableInfo->tableId, tableInfo->indexes);
+        tableInfo->indexesLoaded = true;
+    }
+    return tableInfo->indexes;
+}
+
+void RelationManager::invalidateTableInfo(const string &tableName) {
+    this->tableInfos.erase(tableName);
+}
+
+RC RelationManager::loadAttributes(int tableId, vector<Attribute> &attrs) {
+    RID rid;
     vector<Attribute> columnsDescriptor;
     vector<string> attrNames;
     attrNames.emplace_back("column-name");
     attrNames.emplace_back("column-type");
     attrNames.emplace_back("column-length");
+    attrNames.emplace_back("column-position");
     prepareColumnsDescriptor(columnsDescriptor);
     string condAttr = "table-id";
     CompOp compOp = EQ_OP;
@@ -345,7 +443,9 @@ RC RelationManager::getAttributes(const string &tableName, std::vector<Attribute
 
     char *data = (char *) malloc(PAGE_SIZE);
     int dataPtr;
-    while (rmScanIterator.getNextTuple(rid, data) != RBFM_EOF) {
+    // Freed catalog slots are reused last freed first, so the columns may come back in any order
+    vector<pair<int, Attribute>> columns;
+    while (rmScanIterator.getNextTuple(rid, data) == 0) {
         dataPtr = this->_rbf_manager->getNullFlagSize(attrNames.size());
         Attribute returnedAttr;
         int length;
@@ -358,9 +458,18 @@ RC RelationManager::getAttributes(const string &tableName, std::vector<Attribute
         memcpy(&returnedAttr.type, (char *) data + dataPtr, sizeof(int));
         dataPtr += sizeof(int);
         memcpy(&returnedAttr.length, (char *) data + dataPtr, sizeof(int));
-        attrs.emplace_back(returnedAttr);
+        dataPtr += sizeof(int);
+        int position;
+        memcpy(&position, (char *) data + dataPtr, sizeof(int));
+        columns.emplace_back(position, returnedAttr);
         free(name);
     }
+    stable_sort(columns.begin(), columns.end(), [](const pair<int, Attribute> &a, const pair<int, Attribute> &b) {
+        return a.first < b.first;
+    });
+    for (const pair<int, Attribute> &column : columns) {
+        attrs.emplace_back(column.second);
+    }
 
     free(data);
     free(value);
@@ -372,87 +481,148 @@ RC RelationManager::getAttributesName(vector<Attribute> &attributes, vector<stri
     for(int i = 0; i < attributes.size(); i ++) {
         attributesName.push_back(attributes[i].name);
     }
+    return 0;
 }
 
 RC RelationManager::insertTuple(const string &tableName, const void *data, RID &rid) {
-    FileHandle fileHandle;
-    RC rc = this->_rbf_manager->openFile(tableName, fileHandle);
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
+    if (rc != 0) {
+        return rc;
+    }
 
-    // Check if openFile succeeds
+    rc = this->_rbf_manager->insertRecord(*fileHandle, tableInfo->attrs, data, rid);
     if (rc != 0) {
         return rc;
     }
+    this->updateIndexes(tableName, data, rid);
+    return 0;
+}
 
-    vector<Attribute> recordDescriptor;
-    this->getAttributes(tableName, recordDescriptor);
-    rc = this->_rbf_manager->insertRecord(fileHandle, recordDescriptor, data, rid);
+RC RelationManager::insertTuples(const string &tableName, const vector<const void *> &data, vector<RID> &rids) {
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = this->_rbf_manager->insertRecords(*fileHandle, tableInfo->attrs, data, rids);
     if (rc != 0) {
         return rc;
     }
-    updateIndexes(tableName, data, rid);
-    this->_rbf_manager->closeFile(fileHandle);
+
+    const vector<string> &indexes = this->getIndexFileNames(tableInfo);
+    for (int i = 0; i < indexes.size(); i++) {
+        rc = this->insertIndexEntries(tableInfo->attrs, tableName, indexes[i], data, rids);
+        if (rc != 0) {
+            return rc;
+        }
+    }
     return 0;
 }
 
 RC RelationManager::deleteTuple(const std::string &tableName, const RID &rid) {
-    FileHandle fileHandle;
-    RC rc = this->_rbf_manager->openFile(tableName, fileHandle);
-
-    // Check if openFile succeeds
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
     if (rc != 0) {
         return rc;
     }
 
-    vector<Attribute> recordDescriptor;
-    this->getAttributes(tableName, recordDescriptor);
-    rc = this->_rbf_manager->deleteRecord(fileHandle, recordDescriptor, rid);
+    rc = this->_rbf_manager->deleteRecord(*fileHandle, tableInfo->attrs, rid);
     if (rc != 0) {
         return rc;
     }
-    this->_rbf_manager->closeFile(fileHandle);
     return 0;
 }
 
 RC RelationManager::updateTuple(const std::string &tableName, const void *data, const RID &rid) {
-    FileHandle fileHandle;
-    RC rc = this->_rbf_manager->openFile(tableName, fileHandle);
-
-    // Check if openFile succeeds
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
     if (rc != 0) {
         return rc;
     }
 
-    vector<Attribute> recordDescriptor;
-    this->getAttributes(tableName, recordDescriptor);
-    rc = this->_rbf_manager->updateRecord(fileHandle, recordDescriptor, data, rid);
+    rc = this->_rbf_manager->updateRecord(*fileHandle, tableInfo->attrs, data, rid);
     if (rc != 0) {
         return rc;
     }
 
     // TODO: update index
-    this->_rbf_manager->closeFile(fileHandle);
     return 0;
 }
 
 RC RelationManager::readTuple(const std::string &tableName, const RID &rid, void *data) {
-    FileHandle fileHandle;
-    RC rc = this->_rbf_manager->openFile(tableName, fileHandle);
-
-    // Check if openFile succeeds
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
     if (rc != 0) {
         return rc;
     }
 
-    vector<Attribute> recordDescriptor;
-    this->getAttributes(tableName, recordDescriptor);
-    rc = this->_rbf_manager->readRecord(fileHandle, recordDescriptor, rid, data);
+    rc = this->_rbf_manager->readRecord(*fileHandle, tableInfo->attrs, rid, data);
     if (rc != 0) {
         return rc;
     }
-    this->_rbf_manager->closeFile(fileHandle);
     return 0;
 }
 
+RC RelationManager::readTuples(const std::string &tableName, const vector<RID> &rids, const vector<void *> &data,
+                               vector<bool> &found) {
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return this->_rbf_manager->readRecords(*fileHandle, tableInfo->attrs, rids, data, found);
+}
+
+RC RelationManager::readTuples(const std::string &tableName, const vector<RID> &rids,
+                               const vector<string> &attributeNames, const vector<void *> &data,
+                               vector<bool> &found) {
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return this->_rbf_manager->readRecords(*fileHandle, tableInfo->attrs, rids, attributeNames, data, found);
+}
+
 RC RelationManager::printTuple(const std::vector<Attribute> &attrs, const void *data) {
     this->_rbf_manager->printRecord(attrs, data);
     return 0;
@@ -460,21 +630,21 @@ RC RelationManager::printTuple(const std::vector<Attribute> &attrs, const void *
 
 RC RelationManager::readAttribute(const std::string &tableName, const RID &rid, const std::string &attributeName,
                                   void *data) {
-    FileHandle fileHandle;
-    RC rc = this->_rbf_manager->openFile(tableName, fileHandle);
-
-    // Check if openFile succeeds
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    FileHandle *fileHandle;
+    rc = this->getFileHandle(tableInfo->fileName, fileHandle);
     if (rc != 0) {
         return rc;
     }
 
-    vector<Attribute> recordDescriptor;
-    this->getAttributes(tableName, recordDescriptor);
-    rc = this->_rbf_manager->readAttribute(fileHandle, recordDescriptor, rid, attributeName, data);
+    rc = this->_rbf_manager->readAttribute(*fileHandle, tableInfo->attrs, rid, attributeName, data);
     if (rc != 0) {
         return rc;
     }
-    this->_rbf_manager->closeFile(fileHandle);
     return 0;
 }
 
@@ -483,22 +653,40 @@ RC RelationManager::scan(const std::string &tableName,
                          const CompOp compOp,
                          const void *value,
                          const std::vector<std::string> &attributeNames,
-                         RM_ScanIterator &rm_ScanIterator) {
+                         RM_ScanIterator &rm_ScanIterator, FileMode fileMode) {
     vector<Attribute> recordDescriptor;
+    if (this->openScanFile(tableName, recordDescriptor, rm_ScanIterator, fileMode) != 0) {
+        return -1;
+    }
+    return this->_rbf_manager->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditionAttribute, compOp, value,
+                                    attributeNames, rm_ScanIterator.scanIterator);
+}
+
+RC RelationManager::scan(const std::string &tableName, const std::vector<ScanCondition> &conditions,
+                         const std::vector<std::string> &attributeNames, RM_ScanIterator &rm_ScanIterator,
+                         FileMode fileMode) {
+    vector<Attribute> recordDescriptor;
+    if (this->openScanFile(tableName, recordDescriptor, rm_ScanIterator, fileMode) != 0) {
+        return -1;
+    }
+    return this->_rbf_manager->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditions, attributeNames,
+                                    rm_ScanIterator.scanIterator);
+}
+
+RC RelationManager::openScanFile(const string &tableName, vector<Attribute> &recordDescriptor,
+                                 RM_ScanIterator &rm_ScanIterator, FileMode fileMode) {
     if (tableName == TABLES) {
         this->prepareTablesDescriptor(recordDescriptor);
     } else if (tableName == COLUMNS) {
         this->prepareColumnsDescriptor(recordDescriptor);
     } else {
-        this->getAttributes(tableName, recordDescriptor);
-    }
-    RC rc = this->_rbf_manager->openFile(tableName, rm_ScanIterator.fileHandle);
-    if (rc != 0) {
-        return -1;
+        TableInfo *tableInfo;
+        if (this->getTableInfo(tableName, tableInfo) != 0) {
+            return -1;
+        }
+        recordDescriptor = tableInfo->attrs;
     }
-
-    return this->_rbf_manager->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditionAttribute, compOp, value,
-                                    attributeNames, rm_ScanIterator.scanIterator);
+    return this->_rbf_manager->openFile(tableName, rm_ScanIterator.fileHandle, fileMode);
 }
 
 // Extra credit work
@@ -535,7 +723,7 @@ int RelationManager::getTableId(const string &tableName, RID &rid) {
 
     char *data = (char *) malloc(PAGE_SIZE);
     int tableId = -1;
-    if (rmScanIterator.getNextTuple(rid, data) != RBFM_EOF) {
+    if (rmScanIterator.getNextTuple(rid, data) == 0) {
         memcpy(&tableId, (char *) data + sizeof(char), sizeof(int));
     }
 
@@ -545,20 +733,22 @@ int RelationManager::getTableId(const string &tableName, RID &rid) {
     return tableId;
 }
 
-int RelationManager::getTableTotal() {
+int RelationManager::getMaxTableId() {
     vector<string> attributeNames;
-    prepareTablesAttributeNames(attributeNames);
+    attributeNames.emplace_back("table-id");
     RM_ScanIterator rmScanIterator;
     this->scan(TABLES, "", NO_OP, nullptr, attributeNames, rmScanIterator);
     RID rid;
-    int tableNum = 0;
+    int maxTableId = 0;
     char *data = (char *) malloc(PAGE_SIZE);
-    while (rmScanIterator.getNextTuple(rid, data) != RBFM_EOF) {
-        tableNum++;
+    while (rmScanIterator.getNextTuple(rid, data) == 0) {
+        int tableId;
+        memcpy(&tableId, data + sizeof(char), sizeof(int));
+        maxTableId = max(maxTableId, tableId);
     }
     free(data);
     rmScanIterator.close();
-    return tableNum;
+    return maxTableId;
 }
 
 RC RM_ScanIterator::getNextTuple(RID &rid, void *data) {
@@ -566,7 +756,15 @@ RC RM_ScanIterator::getNextTuple(RID &rid, void *data) {
     if (rc == RBFM_EOF) {
         return RM_EOF;
     }
-    return 0;
+    return rc;
+}
+
+RC RM_ScanIterator::getNextTuples(int maxCount, const vector<RecordColumn *> &columns, int &count) {
+    RC rc = this->scanIterator.getNextRecords(maxCount, columns, count);
+    if (rc == RBFM_EOF) {
+        return RM_EOF;
+    }
+    return rc;
 }
 
 RC RM_ScanIterator::close() {
@@ -586,16 +784,15 @@ RC RelationManager::createIndex(const std::string &tableName, const std::string
             break;
         }
     }
-    attributes.clear();
-    attributes.push_back(attr);
 
     RID rid;
     int tableId = this->getTableId(tableName, rid);
     string indexFileName = "_" + attributeName + "_" + tableName;
     void *data = malloc(1+2* sizeof(int)+indexFileName.size());
     prepareIndexRecord(tableId, data, indexFileName);
-    this->insertTuple("Index", data, rid);
+    this->insertTuple(INDEX, data, rid);
     free(data);
+    this->invalidateTableInfo(tableName);
     _ix_manager->createFile(indexFileName);
 
     vector<string> attr_names;
@@ -603,19 +800,49 @@ RC RelationManager::createIndex(const std::string &tableName, const std::string
     data = malloc(PAGE_SIZE);
     RM_ScanIterator rmScanIterator;
     this->scan(tableName, "", NO_OP, nullptr, attr_names, rmScanIterator);
-    while(rmScanIterator.getNextTuple(rid, data) != RM_EOF) {
-        this->insertIndex(attributes, tableName, indexFileName, data, rid);
+    vector<IndexEntry> entries;
+    IndexEntry entry;
+    while (rmScanIterator.getNextTuple(rid, data) == 0) {
+        if (((char *) data)[0] & (1 << 7)) {
+            continue;
+        }
+        entry.key.readAttr(attr.type, (char *) data + 1);
+        entry.rid = rid;
+        entries.emplace_back(entry);
     }
-    return 0;
+    rmScanIterator.close();
+    free(data);
+
+    // Existing tuples are sorted and loaded in one pass instead of an insertEntry each
+    if (entries.empty()) {
+        return 0;
+    }
+    stable_sort(entries.begin(), entries.end(), [](const IndexEntry &left, const IndexEntry &right) {
+        return left.key < right.key;
+    });
+    IXFileHandle *ixFileHandle;
+    RC rc = this->getIXFileHandle(indexFileName, ixFileHandle);
+    if (rc != 0) {
+        return rc;
+    }
+    return _ix_manager->bulkLoad(*ixFileHandle, attr, entries);
 }
 
 RC RelationManager::destroyIndex(const std::string &tableName, const std::string &attributeName) {
     string indexName = "_" + attributeName + "_" + tableName;
+    if (BufferManager::instance().pinned(indexName)) {
+        return -15; // BufferPoolBusyException
+    }
     RC rc;
     rc = this->deleteTable(indexName);
     if(rc != 0) {
         return -1;
     }
+    rc = this->deleteIndexRecord(tableName, indexName);
+    if(rc != 0) {
+        return -1;
+    }
+    this->closeCachedFile(indexName);
     rc = _ix_manager->destroyFile(indexName);
     if(rc != 0) {
         return -1;
@@ -623,16 +850,48 @@ RC RelationManager::destroyIndex(const std::string &tableName, const std::string
     return 0;
 }
 
+RC RelationManager::deleteIndexRecord(const string &tableName, const string &indexFileName) {
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    int tableId = tableInfo->tableId;
+    this->invalidateTableInfo(tableName);
+
+    vector<string> attributeNames;
+    attributeNames.emplace_back("index-file-name");
+    RM_ScanIterator rmScanIterator;
+    this->scan(INDEX, "table-id", EQ_OP, &tableId, attributeNames, rmScanIterator);
+    void *data = malloc(PAGE_SIZE);
+    RID rid;
+    vector<RID> targets;
+    AttrValue attrValue;
+    while (rmScanIterator.getNextTuple(rid, data) == 0) {
+        attrValue.readAttr(TypeVarChar, (char *) data + sizeof(char));
+        if (attrValue.vchar == indexFileName) {
+            targets.emplace_back(rid);
+        }
+    }
+    rmScanIterator.close();
+    free(data);
+    for (int i = 0; i < targets.size(); i++) {
+        this->deleteTuple(INDEX, targets[i]);
+    }
+    return 0;
+}
+
 RC RelationManager::updateIndexes(const string &tableName, const void *data, const RID &rid) {
-    RID ridforTableId;
-    vector<Attribute> attributes;
-    this->getAttributes(tableName, attributes);
-    int tableId = this->getTableId(tableName, ridforTableId);
-    vector<string> indexes;
-    this->getIndexAttributeNames(tableId, indexes);
+    TableInfo *tableInfo;
+    RC rc = this->getTableInfo(tableName, tableInfo);
+    if (rc != 0) {
+        return rc;
+    }
+    vector<string> &indexes = this->getIndexFileNames(tableInfo);
     for(int i = 0; i < indexes.size(); i ++) {
-        this->insertIndex(attributes, tableName, indexes[i], data, rid);
+        this->insertIndex(tableInfo->attrs, tableName, indexes[i], data, rid);
     }
+    return 0;
 }
 
 RC RelationManager::indexScan(const std::string &tableName,
@@ -641,9 +900,9 @@ RC RelationManager::indexScan(const std::string &tableName,
                               const void *highKey,
                               bool lowKeyInclusive,
                               bool highKeyInclusive,
-                              RM_IndexScanIterator &rm_IndexScanIterator) {
+                              RM_IndexScanIterator &rm_IndexScanIterator, FileMode fileMode) {
     string indexName = "_" + attributeName + "_" + tableName;
-    RC rc = _ix_manager->openFile(indexName, rm_IndexScanIterator.ixFileHandle);
+    RC rc = _ix_manager->openFile(indexName, rm_IndexScanIterator.ixFileHandle, fileMode);
     if(rc != 0) {
         return rc;
     }
@@ -669,6 +928,12 @@ RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key) {
     return 0;
 }
 
+RC RM_IndexScanIterator::close() {
+    // The scan holds a pin on its leaf, it has to be released before the index file goes away
+    this->ixScanIterator.close();
+    return IndexManager::instance().closeFile(this->ixFileHandle);
+}
+
 RC RelationManager::getIndexAttributeNames(int tableId, vector<string> &indexAttributeNames) {
     RID rid;
     void *data = malloc(PAGE_SIZE);
@@ -679,9 +944,9 @@ RC RelationManager::getIndexAttributeNames(int tableId, vector<string> &indexAtt
     void *value = malloc(sizeof(int));
     memcpy(value, &tableId, sizeof(int));
     RM_ScanIterator rmScanIterator;
-    this->scan("Index", "table-id", compOp, value, attributeNames, rmScanIterator);
+    this->scan(INDEX, "table-id", compOp, value, attributeNames, rmScanIterator);
     AttrValue attrValue;
-    while(rmScanIterator.getNextTuple(rid, data) != RM_EOF) {
+    while (rmScanIterator.getNextTuple(rid, data) == 0) {
         attrValue.readAttr(TypeVarChar, (char *) data + sizeof(char));
         indexAttributeNames.emplace_back(attrValue.vchar);
     }
@@ -733,9 +998,131 @@ RC RelationManager::insertIndex(vector<Attribute> &attributes, const string &tab
     void *key = malloc(keyLength);
     memcpy(key, keyData, keyLength);
     free(keyData);
-    IXFileHandle ixFileHandle;
-    ixFileHandle.fileHandle.openFile(indexFileName);
-    _ix_manager->insertEntry(ixFileHandle, attributes[attrPos], key, rid);
-    ixFileHandle.fileHandle.closeFile();
+    IXFileHandle *ixFileHandle;
+    RC rc = this->getIXFileHandle(indexFileName, ixFileHandle);
+    if (rc == 0) {
+        rc = _ix_manager->insertEntry(*ixFileHandle, attributes[attrPos], key, rid);
+    }
+    free(key);
+    return rc;
+}
+
+RC RelationManager::insertIndexEntries(vector<Attribute> &attributes, const string &tableName,
+                                       const string &indexFileName, const vector<const void *> &data,
+                                       const vector<RID> &rids) {
+    IXFileHandle *ixFileHandle;
+    RC rc = this->getIXFileHandle(indexFileName, ixFileHandle);
+    if (rc != 0) {
+        return rc;
+    }
+    int attrPos = -1;
+    void *key = malloc(PAGE_SIZE);
+    vector<IndexEntry> entries;
+    IndexEntry entry;
+    for (int i = 0; i < data.size(); i++) {
+        if (this->getKey(attributes, attrPos, tableName, indexFileName, key, data[i]) == -1) {
+            rc = -1;
+            break;
+        }
+        entry.key.readAttr(attributes[attrPos].type, key);
+        entry.rid = rids[i];
+        entries.emplace_back(entry);
+    }
+    free(key);
+    if (rc != 0 || entries.empty()) {
+        return rc;
+    }
+    // In key order, the entries of the batch that share a leaf go in with one descent
+    stable_sort(entries.begin(), entries.end(), [](const IndexEntry &left, const IndexEntry &right) {
+        return left.key < right.key;
+    });
+    return _ix_manager->insertEntries(*ixFileHandle, attributes[attrPos], entries);
+}
+
+RC RelationManager::getFileHandle(const string &fileName, FileHandle *&fileHandle) {
+    CachedFile *cachedFile;
+    RC rc = this->getCachedFile(fileName, false, cachedFile);
+    if (rc == 0) {
+        fileHandle = cachedFile->fileHandle;
+    }
+    return rc;
+}
+
+RC RelationManager::getIXFileHandle(const string &fileName, IXFileHandle *&ixFileHandle) {
+    CachedFile *cachedFile;
+    RC rc = this->getCachedFile(fileName, true, cachedFile);
+    if (rc == 0) {
+        ixFileHandle = cachedFile->ixFileHandle;
+    }
+    return rc;
+}
+
+RC RelationManager::getCachedFile(const string &fileName, bool isIndex, CachedFile *&cachedFile) {
+    auto it = this->handleCache.find(fileName);
+    if (it != this->handleCache.end()) {
+        this->handleHitCounter++;
+        this->handleOrder.splice(this->handleOrder.begin(), this->handleOrder, it->second);
+        cachedFile = &*it->second;
+        return 0;
+    }
+    this->handleMissCounter++;
+
+    CachedFile newFile;
+    newFile.fileName = fileName;
+    newFile.fileHandle = nullptr;
+    newFile.ixFileHandle = nullptr;
+    RC rc;
+    if (isIndex) {
+        newFile.ixFileHandle = new IXFileHandle();
+        rc = _ix_manager->openFile(fileName, *newFile.ixFileHandle);
+    } else {
+        newFile.fileHandle = new FileHandle();
+        rc = this->_rbf_manager->openFile(fileName, *newFile.fileHandle);
+    }
+    if (rc != 0) {
+        delete newFile.fileHandle;
+        delete newFile.ixFileHandle;
+        return rc;
+    }
+
+    // The least recently used handle is closed, which can be one the caller still holds: a handle is only
+    // valid until the next getFileHandle or getIXFileHandle call
+    if (this->handleOrder.size() >= RM_HANDLE_CACHE_SIZE) {
+        this->handleEvictCounter++;
+        this->closeCachedFile(this->handleOrder.back().fileName);
+    }
+    this->handleOrder.push_front(newFile);
+    this->handleCache[fileName] = this->handleOrder.begin();
+    cachedFile = &this->handleOrder.front();
+    return 0;
+}
+
+void RelationManager::closeCachedFile(const string &fileName) {
+    auto it = this->handleCache.find(fileName);
+    if (it == this->handleCache.end()) {
+        return;
+    }
+    CachedFile &cachedFile = *it->second;
+    if (cachedFile.ixFileHandle != nullptr) {
+        _ix_manager->closeFile(*cachedFile.ixFileHandle);
+        delete cachedFile.ixFileHandle;
+    } else {
+        this->_rbf_manager->closeFile(*cachedFile.fileHandle);
+        delete cachedFile.fileHandle;
+    }
+    this->handleOrder.erase(it->second);
+    this->handleCache.erase(it);
+}
+
+void RelationManager::closeCachedFiles() {
+    while (!this->handleOrder.empty()) {
+        this->closeCachedFile(this->handleOrder.front().fileName);
+    }
+}
+
+RC RelationManager::collectHandleCounterValues(unsigned &hitCount, unsigned &missCount, unsigned &evictCount) {
+    hitCount = this->handleHitCounter;
+    missCount = this->handleMissCounter;
+    evictCount = this->handleEvictCounter;
     return 0;
 }
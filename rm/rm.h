@@ -5,6 +5,9 @@
 #include <vector>
 #include <cstring>
 #include <iostream>
+#include <unordered_map>
+#include <list>
+#include <algorithm>
 
 #include "../rbf/rbfm.h"
 #include "../ix/ix.h"
@@ -12,6 +15,7 @@
 # define RM_EOF (-1)  // end of a scan operator
 #define TABLES "Tables"
 #define COLUMNS "Columns"
+#define RM_HANDLE_CACHE_SIZE 16     // Table and index files kept open between tuple operations
 #define INDEX "Index"
 
 using namespace std;
@@ -26,6 +30,9 @@ public:
     // "data" follows the same format as RelationManager::insertTuple()
     RC getNextTuple(RID &rid, void *data);
 
+    // Up to maxCount tuples at once, split into columns, one per returned attribute
+    RC getNextTuples(int maxCount, const vector<RecordColumn *> &columns, int &count);
+
     RC close();
 
     FileHandle fileHandle;
@@ -40,9 +47,9 @@ public:
 
     // "key" follows the same format as in IndexManager::insertEntry()
     RC getNextEntry(RID &rid, void *key);    // Get next matching entry
-    RC close() { return -1; };                        // Terminate index scan
+    RC close();                                       // Terminate index scan
+    IXFileHandle ixFileHandle;                        // Declared first, the scan is destroyed before its file
     IX_ScanIterator ixScanIterator;
-    IXFileHandle ixFileHandle;
     Attribute attribute;
 };
 
@@ -65,12 +72,25 @@ public:
 
     RC insertTuple(const std::string &tableName, const void *data, RID &rid);
 
+    // Insert many tuples at once, the table and each of its indexes are opened once for the whole batch
+    RC insertTuples(const std::string &tableName, const std::vector<const void *> &data, std::vector<RID> &rids);
+
     RC deleteTuple(const std::string &tableName, const RID &rid);
 
     RC updateTuple(const std::string &tableName, const void *data, const RID &rid);
 
     RC readTuple(const std::string &tableName, const RID &rid, void *data);
 
+    // Read many tuples at once, each page of the table is read once for the whole batch.
+    // data[i] receives the tuple of rids[i] and must have room for it, found[i] is false if there is none.
+    RC readTuples(const std::string &tableName, const std::vector<RID> &rids, const std::vector<void *> &data,
+                  std::vector<bool> &found);
+
+    // Read many tuples as above, each with only the attributes attributeNames in that order
+    RC readTuples(const std::string &tableName, const std::vector<RID> &rids,
+                  const std::vector<std::string> &attributeNames, const std::vector<void *> &data,
+                  std::vector<bool> &found);
+
     // Print a tuple that is passed to this utility method.
     // The format is the same as printRecord().
     RC printTuple(const std::vector<Attribute> &attrs, const void *data);
@@ -84,7 +104,15 @@ public:
             const CompOp compOp,                  // comparison type such as "<" and "="
             const void *value,                    // used in the comparison
             const std::vector<std::string> &attributeNames, // a list of projected attributes
-            RM_ScanIterator &rm_ScanIterator);
+            RM_ScanIterator &rm_ScanIterator,
+            FileMode fileMode = READ_WRITE);      // READ_ONLY_MMAP for tables that are no longer modified
+
+    // Scan for the tuples that satisfy every condition, checked on the page before a tuple is copied out
+    RC scan(const std::string &tableName,
+            const std::vector<ScanCondition> &conditions,
+            const std::vector<std::string> &attributeNames,
+            RM_ScanIterator &rm_ScanIterator,
+            FileMode fileMode = READ_WRITE);
 
     // Extra credit work (10 points)
     RC addAttribute(const std::string &tableName, const Attribute &attr);
@@ -118,7 +146,7 @@ public:
 
     int getTableId(const string &tableName, RID &rid);
 
-    int getTableTotal();
+    int getMaxTableId();
 
     // QE IX related
     RC createIndex(const std::string &tableName, const std::string &attributeName);
@@ -129,6 +157,8 @@ public:
 
     RC getIndexAttributeNames(int tableId, vector<string> &indexAttributeNames);
 
+    RC deleteIndexRecord(const string &tableName, const string &indexFileName);
+
     // indexScan returns an iterator to allow the caller to go through qualified entries in index
     RC indexScan(const std::string &tableName,
                  const std::string &attributeName,
@@ -136,10 +166,17 @@ public:
                  const void *highKey,
                  bool lowKeyInclusive,
                  bool highKeyInclusive,
-                 RM_IndexScanIterator &rm_IndexScanIterator);
+                 RM_IndexScanIterator &rm_IndexScanIterator,
+                 FileMode fileMode = READ_WRITE);
 
     RC insertIndex(vector<Attribute> &attributes, const string &tableName, string &indexFileName, const void *data, const RID &rid);
 
+    RC insertIndexEntries(vector<Attribute> &attributes, const string &tableName, const string &indexFileName,
+                          const vector<const void *> &data, const vector<RID> &rids);
+
+    // Hits, misses and evictions of the open file handle cache
+    RC collectHandleCounterValues(unsigned &hitCount, unsigned &missCount, unsigned &evictCount);
+
     int getKey(vector<Attribute> &attrs, int &attrPos, const string &tableName, const string &indexFileName, void *keyData, const void *data);
 
 protected:
@@ -149,10 +186,55 @@ protected:
     RelationManager &operator=(const RelationManager &);                // Prevent assignment
 
 private:
+    // Catalog entries of a table, kept until the table or its indexes change
+    struct TableInfo {
+        int tableId;
+        string fileName;
+        vector<Attribute> attrs;
+        vector<string> indexes;                                         // Index file names
+        bool indexesLoaded;
+    };
+
+    RC getTableInfo(const string &tableName, TableInfo *&tableInfo);
+
+    vector<string> &getIndexFileNames(TableInfo *tableInfo);
+
+    void invalidateTableInfo(const string &tableName);
+
+    RC loadAttributes(int tableId, vector<Attribute> &attrs);
+
+    // Open the file of a table for a scan and get its record descriptor
+    RC openScanFile(const string &tableName, vector<Attribute> &recordDescriptor, RM_ScanIterator &rm_ScanIterator,
+                    FileMode fileMode);
+
+    // An open table or index file, owned by the handle cache
+    struct CachedFile {
+        string fileName;
+        FileHandle *fileHandle;                                         // Set for a table
+        IXFileHandle *ixFileHandle;                                     // Set for an index
+    };
+
+    // The handle is only valid until the next getFileHandle or getIXFileHandle call, which may evict it
+    RC getFileHandle(const string &fileName, FileHandle *&fileHandle);
+
+    RC getIXFileHandle(const string &fileName, IXFileHandle *&ixFileHandle);
+
+    RC getCachedFile(const string &fileName, bool isIndex, CachedFile *&cachedFile);
+
+    void closeCachedFile(const string &fileName);                       // Before the file is destroyed
+
+    void closeCachedFiles();
+
     static RelationManager *_relation_manager;
     RecordBasedFileManager *_rbf_manager;
     IndexManager *_ix_manager;
     int numOfTables = 0;
+    unordered_map<string, TableInfo> tableInfos;                        // Table name -> catalog entries
+    list<CachedFile> handleOrder;                                       // Most recently used at the front
+    unordered_map<string, list<CachedFile>::iterator> handleCache;
+    unsigned handleHitCounter;
+    unsigned handleMissCounter;
+    unsigned handleEvictCounter;
 };
 
 #endif
\ No newline at end of file
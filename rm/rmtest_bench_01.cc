@@ -0,0 +1,157 @@
+#include <chrono>
+
+#include "rm_test_util.h"
+
+const int numTuples = 10000;
+const int batchSize = 500;
+
+// Tuples inserted per second, -1 if an insert fails
+double loadTable(const std::string &tableName, bool batched, std::vector<RID> &rids) {
+    std::vector<Attribute> attrs;
+    RC rc = rm.getAttributes(tableName, attrs);
+    assert(rc == success && "RelationManager::getAttributes() should not fail.");
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+
+    std::vector<void *> tuples;
+    unsigned tupleSize = 0;
+    for (int i = 0; i < numTuples; i++) {
+        void *tuple = malloc(100);
+        prepareTuple(attrs.size(), nullsIndicator, 8, "Anteater", i % 80, 160.0f + i % 40, i, tuple, &tupleSize);
+        tuples.push_back(tuple);
+    }
+
+    rids.clear();
+    auto start = std::chrono::steady_clock::now();
+    if (batched) {
+        std::vector<const void *> batch;
+        std::vector<RID> batchRids;
+        for (int i = 0; i < numTuples; i += batchSize) {
+            batch.assign(tuples.begin() + i, tuples.begin() + std::min(i + batchSize, numTuples));
+            rc = rm.insertTuples(tableName, batch, batchRids);
+            if (rc != success) {
+                break;
+            }
+            rids.insert(rids.end(), batchRids.begin(), batchRids.end());
+        }
+    } else {
+        RID rid;
+        for (int i = 0; i < numTuples && rc == success; i++) {
+            rc = rm.insertTuple(tableName, tuples[i], rid);
+            rids.push_back(rid);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    for (void *tuple : tuples) {
+        free(tuple);
+    }
+    free(nullsIndicator);
+    if (rc != success) {
+        return -1;
+    }
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return numTuples / (seconds > 0 ? seconds : 1e-9);
+}
+
+RC checkTable(const std::string &tableName, const std::vector<RID> &rids) {
+    std::vector<Attribute> attrs;
+    rm.getAttributes(tableName, attrs);
+    int nullAttributesIndicatorActualSize = getActualByteForNullsIndicator(attrs.size());
+    auto *nullsIndicator = (unsigned char *) malloc(nullAttributesIndicatorActualSize);
+    memset(nullsIndicator, 0, nullAttributesIndicatorActualSize);
+    void *tuple = malloc(100);
+    void *returnedData = malloc(100);
+    unsigned tupleSize = 0;
+    RC result = success;
+    for (int i = 0; i < numTuples; i += 97) {
+        prepareTuple(attrs.size(), nullsIndicator, 8, "Anteater", i % 80, 160.0f + i % 40, i, tuple, &tupleSize);
+        RC rc = rm.readTuple(tableName, rids[i], returnedData);
+        if (rc != success || memcmp(tuple, returnedData, tupleSize) != 0) {
+            std::cout << "[FAIL] Tuple " << i << " of " << tableName << " does not match." << std::endl;
+            result = -1;
+            break;
+        }
+    }
+
+    // Every tuple reached the index on Age
+    for (int age = 0; age < 80 && result == success; age++) {
+        RM_IndexScanIterator rmisi;
+        rm.indexScan(tableName, "Age", &age, &age, true, true, rmisi);
+        RID rid;
+        int found = 0;
+        while (rmisi.getNextEntry(rid, returnedData) != RM_EOF) {
+            found++;
+        }
+        rmisi.close();
+        if (found != numTuples / 80) {
+            std::cout << "[FAIL] The index of " << tableName << " has " << found << " entries for age " << age
+                      << " instead of " << numTuples / 80 << "." << std::endl;
+            result = -1;
+        }
+    }
+
+    free(tuple);
+    free(returnedData);
+    free(nullsIndicator);
+    return result;
+}
+
+RC TEST_RM_BENCH_1(const std::string &singleTable, const std::string &batchTable) {
+    // Functions Tested
+    // 1. insertTuple, one tuple at a time **
+    // 2. insertTuples, the same tuples in batches **
+    // 3. Both tables and their indexes hold the same tuples
+    // 4. Table and index files stay open between tuple operations
+    std::cout << std::endl << "***** In RM Test Case Bench 1 *****" << std::endl;
+
+    RC rc = createTable(singleTable);
+    assert(rc == success && "Creating a table should not fail.");
+    rc = createTable(batchTable);
+    assert(rc == success && "Creating a table should not fail.");
+    rc = rm.createIndex(singleTable, "Age");
+    assert(rc == success && "Creating an index should not fail.");
+    rc = rm.createIndex(batchTable, "Age");
+    assert(rc == success && "Creating an index should not fail.");
+
+    std::vector<RID> singleRids, batchRids;
+    unsigned hits, misses, evicts, hitsAfter, missesAfter, evictsAfter;
+    rm.collectHandleCounterValues(hits, misses, evicts);
+    double singleRate = loadTable(singleTable, false, singleRids);
+    rm.collectHandleCounterValues(hitsAfter, missesAfter, evictsAfter);
+    double batchRate = loadTable(batchTable, true, batchRids);
+    if (singleRate < 0 || batchRate < 0) {
+        std::cout << "[FAIL] Inserting tuples should not fail." << std::endl;
+        return -1;
+    }
+    std::cout << std::fixed << std::setprecision(0) << "insertTuple:  " << singleRate << " rows/sec" << std::endl
+              << "insertTuples: " << batchRate << " rows/sec (batches of " << batchSize << ")" << std::endl;
+    std::cout << "open handle cache during insertTuple: " << hitsAfter - hits << " hits, " << missesAfter - misses
+              << " misses, " << evictsAfter - evicts << " evictions" << std::endl;
+    if (missesAfter - misses > 2) {
+        std::cout << "[FAIL] The table and its index should only be opened once." << std::endl;
+        return -1;
+    }
+
+    if (checkTable(singleTable, singleRids) != success || checkTable(batchTable, batchRids) != success) {
+        return -1;
+    }
+
+    rm.destroyIndex(singleTable, "Age");
+    rm.destroyIndex(batchTable, "Age");
+    rm.deleteTable(singleTable);
+    rm.deleteTable(batchTable);
+
+    std::cout << "***** RM Test Case Bench 1 finished. The result will be examined. *****" << std::endl;
+    return success;
+}
+
+int main() {
+    // Run after rmtest_create_tables, the catalog has to exist
+    remove("tbl_bench_single");
+    remove("tbl_bench_batch");
+    remove("_Age_tbl_bench_single");
+    remove("_Age_tbl_bench_batch");
+    return TEST_RM_BENCH_1("tbl_bench_single", "tbl_bench_batch");
+}